@@ -0,0 +1,250 @@
+#include "AssetGenerator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numbers>
+#include <random>
+
+namespace {
+    // Smallest valid 1x1 RGBA PNG, used as the diffuse texture of every generated material.
+    const unsigned char PLACEHOLDER_PNG[] = {
+        0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d,
+        0x49, 0x48, 0x44, 0x52, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01,
+        0x08, 0x06, 0x00, 0x00, 0x00, 0x1f, 0x15, 0xc4, 0x89, 0x00, 0x00, 0x00,
+        0x0d, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9c, 0x63, 0xf8, 0xff, 0xff, 0x3f,
+        0x00, 0x05, 0xfe, 0x02, 0xfe, 0xa7, 0x35, 0x81, 0x84, 0x00, 0x00, 0x00,
+        0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82
+    };
+
+    const char* TEXTURE_PATH = "textures/entity/bench_diffuse";
+
+    std::string boneName(int index) {
+        return "bone_" + std::to_string(index);
+    }
+
+    std::vector<Badger::Bone> generateBones(const GeneratorOptions& options, std::mt19937& random) {
+        std::uniform_real_distribution<double> rotation(-15.0, 15.0);
+        std::vector<Badger::Bone> bones;
+        bones.reserve(options.bones);
+
+        for (auto i = 0; i < options.bones; i++) {
+            Badger::Bone bone {
+                .info {
+                    .bindPoseRotation { rotation(random), rotation(random), rotation(random) }
+                },
+                .locators = {},
+                .name = boneName(i),
+                .parent = i == 0 ? "" : boneName((i - 1) / 2),
+                .pivot { 0, i == 0 ? 0.0 : 4.0, 0 },
+                .scale { 1, 1, 1 }
+            };
+
+            if (i % 8 == 7) {
+                bone.locators.insert({"locator_" + std::to_string(i), {
+                    .discardScale = i % 16 == 15,
+                    .offset { 1, 0, 0 },
+                    .rotation { 0, 90, 0 }
+                }});
+            }
+
+            bones.push_back(bone);
+        }
+
+        return bones;
+    }
+
+    Badger::Mesh generateMesh(const GeneratorOptions& options, int meshIndex, std::mt19937& random) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+        auto columns = std::max(2, static_cast<int>(std::sqrt(options.verticesPerMesh)));
+        auto rows = std::max(2, options.verticesPerMesh / columns);
+        auto vertexCount = static_cast<size_t>(rows * columns);
+        auto influences = std::clamp(options.influences, 0, options.bones);
+
+        Badger::Mesh mesh;
+        mesh.name = "bench_mesh_" + std::to_string(meshIndex);
+        mesh.material = "mat_bench_" + std::to_string(meshIndex);
+        mesh.positions.reserve(vertexCount);
+        mesh.weights.reserve(vertexCount);
+        mesh.normals.resize(1);
+        mesh.uvs.resize(1);
+        mesh.colors.resize(1);
+
+        if (influences > 0)
+            mesh.indices.reserve(vertexCount);
+
+        for (auto row = 0; row < rows; row++) {
+            auto v = static_cast<double>(row) / (rows - 1);
+
+            for (auto column = 0; column < columns; column++) {
+                auto u = static_cast<double>(column) / (columns - 1);
+                auto angle = u * 2 * std::numbers::pi;
+                auto x = std::cos(angle);
+                auto z = std::sin(angle);
+
+                mesh.positions.push_back({ x * 8, v * 4.0 * options.bones, z * 8 + meshIndex });
+                mesh.normals[0].push_back({ x, 0, z, 0 });
+                mesh.uvs[0].push_back({ u, v });
+                mesh.colors[0].push_back({ u, v, 1, 1 });
+
+                std::vector<double> weights;
+                std::vector<Symbol> boneNames;
+                auto firstBone = std::min(options.bones - 1, static_cast<int>(v * options.bones));
+                auto total = 0.0;
+
+                for (auto i = 0; i < influences; i++) {
+                    auto weight = 0.05 + unit(random);
+                    weights.push_back(weight);
+                    boneNames.push_back(boneName((firstBone + i) % options.bones));
+                    total += weight;
+                }
+
+                for (auto& weight : weights)
+                    weight /= total;
+
+                mesh.weights.push_back(weights);
+                if (influences > 0)
+                    mesh.indices.push_back(boneNames);
+            }
+        }
+
+        mesh.triangles.reserve(static_cast<size_t>(rows - 1) * (columns - 1) * 6);
+        for (auto row = 0; row < rows - 1; row++) {
+            for (auto column = 0; column < columns - 1; column++) {
+                auto topLeft = row * columns + column;
+                auto bottomLeft = topLeft + columns;
+
+                mesh.triangles.insert(mesh.triangles.end(), {
+                    topLeft, bottomLeft, topLeft + 1,
+                    topLeft + 1, bottomLeft, bottomLeft + 1
+                });
+            }
+        }
+
+        return mesh;
+    }
+
+    Badger::Animations generateAnimations(const GeneratorOptions& options, std::mt19937& random) {
+        std::uniform_real_distribution<double> offset(-1.0, 1.0);
+        std::uniform_real_distribution<double> angle(-45.0, 45.0);
+
+        Badger::Animations animations { .formatVersion = "1.8.0", .animations = {} };
+
+        for (auto a = 0; a < options.animations; a++) {
+            Badger::Animation animation {
+                .animTimeUpdate = "(query.anim_time + (query.delta_time * 1))",
+                .blendWeight = "1",
+                .bones = {}
+            };
+
+            for (auto b = 0; b < options.bones; b++) {
+                Badger::AnimationBone bone { .lodDistance = 0, .rotation = {}, .position = {}, .scale = {} };
+
+                for (auto k = 0; k < options.keyframes; k++) {
+                    auto time = k / 30.0;
+                    bone.rotation.insert({time, {
+                        .lerpMode = "catmullrom",
+                        .post { angle(random), angle(random), angle(random) }
+                    }});
+
+                    if (b == 0) {
+                        bone.position.insert({time, {
+                            .lerpMode = "linear",
+                            .post { offset(random), offset(random), offset(random) }
+                        }});
+                        bone.scale.insert({time, {
+                            .lerpMode = "Undefined",
+                            .post { 0, 0, 0 }
+                        }});
+                    }
+                }
+
+                animation.bones.insert({boneName(b), bone});
+            }
+
+            animations.animations.insert({"animation.bench_" + std::to_string(a), animation});
+        }
+
+        return animations;
+    }
+
+    bool writeJson(const std::filesystem::path& path, const ArenaJson& value) {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream stream(path, std::ios::out);
+        if (!stream)
+            return false;
+
+        stream << value;
+        return static_cast<bool>(stream);
+    }
+}
+
+GeneratedAssets generateAssets(const GeneratorOptions& options) {
+    std::mt19937 random(options.seed);
+
+    GeneratedAssets assets;
+    assets.modelName = "bench_model";
+
+    Badger::Geometry geometry;
+    geometry.description.identifier = "geometry." + assets.modelName;
+    geometry.bones = generateBones(options, random);
+
+    for (auto i = 0; i < options.meshes; i++) {
+        geometry.meshes.push_back(generateMesh(options, i, random));
+
+        Badger::MetaMaterial material {
+            .formatVersion = "1.8.0",
+            .name = "mat_bench_" + std::to_string(i),
+            .baseName = "",
+            .info {
+                .material = "",
+                .culling = "none",
+                .textures { .diffuse = TEXTURE_PATH, .coeff = "", .emissive = "", .normal = "" }
+            }
+        };
+        assets.materials.push_back(material);
+    }
+
+    assets.model = {
+        .formatVersion = "1.8.0",
+        .geometry = { geometry }
+    };
+
+    assets.templateEntity.formatVersion = "1.8.0";
+    assets.entity.formatVersion = "1.8.0";
+    assets.entity.info.components.templates.push_back("badger:" + assets.modelName + "_base");
+
+    assets.animations = generateAnimations(options, random);
+
+    return assets;
+}
+
+bool writeResourcePack(const std::filesystem::path& packDirectory, const GeneratedAssets& assets) {
+    auto modelPath = packDirectory / "models" / "entity" / (assets.modelName + ".model.json");
+    if (!writeJson(modelPath, assets.model))
+        return false;
+
+    for (const auto& material : assets.materials) {
+        auto materialPath = packDirectory / "materials" / "meta_materials" / (material.name + ".json");
+        if (!writeJson(materialPath, material))
+            return false;
+    }
+
+    auto entityDirectory = packDirectory / "entity";
+    if (!writeJson(entityDirectory / (assets.modelName + ".entity.json"), assets.entity))
+        return false;
+    if (!writeJson(entityDirectory / (assets.modelName + "_base.entity.json"), assets.templateEntity))
+        return false;
+
+    auto animationsPath = packDirectory / "animations" / (assets.modelName + ".animations.json");
+    if (!writeJson(animationsPath, assets.animations))
+        return false;
+
+    auto texturePath = packDirectory / (std::string(TEXTURE_PATH) + ".png");
+    std::filesystem::create_directories(texturePath.parent_path());
+    std::ofstream texture(texturePath, std::ios::out | std::ios::binary);
+    texture.write(reinterpret_cast<const char*>(PLACEHOLDER_PNG), sizeof(PLACEHOLDER_PNG));
+
+    return static_cast<bool>(texture);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "BadgerModel.hh"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct GeneratorOptions {
+    int meshes = 4;
+    int verticesPerMesh = 10000;
+    int bones = 64;
+    int influences = 4;
+    int animations = 4;
+    int keyframes = 60;
+    unsigned int seed = 1;
+};
+
+struct GeneratedAssets {
+    std::string modelName;
+    Badger::Model model;
+    std::vector<Badger::MetaMaterial> materials;
+    Badger::Entity entity;
+    Badger::Entity templateEntity;
+    Badger::Animations animations;
+};
+
+// Procedurally builds a skinned, animated Badger model with the requested sizes.
+GeneratedAssets generateAssets(const GeneratorOptions& options);
+
+// Writes the generated assets as a resource pack laid out the way ResourceLoader expects it.
+bool writeResourcePack(const std::filesystem::path& packDirectory, const GeneratedAssets& assets);
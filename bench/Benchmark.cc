@@ -0,0 +1,319 @@
+#include "AssetGenerator.hh"
+
+#include "AnimationSampler.hh"
+#include "BadgerConverter.hh"
+#include "FbxConverter.hh"
+#include "Log.hh"
+#include "NativeFbxImporter.hh"
+#include "ResourceLoader.hh"
+#include "Stopwatch.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Counts every global heap allocation, so phases can report how many they make.
+namespace {
+    std::atomic<size_t> heapAllocations = 0;
+}
+
+void* operator new(size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto pointer = std::malloc(size != 0 ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+struct BenchmarkOptions {
+    GeneratorOptions generator;
+    int iterations = 5;
+    std::filesystem::path workDirectory = std::filesystem::temp_directory_path() / "fbx_converter_bench";
+    std::string output;
+};
+
+struct PhaseResult {
+    std::string name;
+    std::vector<double> samples;
+    std::vector<size_t> allocations;
+};
+
+// Times every phase through the public converter entry points and the PhaseTimings they record.
+class ConverterBenchmark {
+    public:
+        ConverterBenchmark(const BenchmarkOptions& options, const GeneratedAssets& assets) :
+            options(options),
+            assets(assets),
+            packsDirectory((options.workDirectory / "packs").string()),
+            nativeOutput((options.workDirectory / "native_output.fbx").string()) {}
+
+        // Returns false if any phase failed, results then only hold the iterations before the failure.
+        bool run(std::vector<PhaseResult>& results) {
+            auto succeeded = true;
+            succeeded &= measure(results, {{"resource_loader_parse", {"parse"}}}, [this](PhaseTimings& timings) { return parseResources(true, timings); });
+            succeeded &= measure(results, {{"resource_loader_parse_heap", {"parse"}}}, [this](PhaseTimings& timings) { return parseResources(false, timings); });
+            succeeded &= measure(results, {
+                {"fbx_import_bone", {"bones"}},
+                {"fbx_import_material", {"materials"}},
+                {"fbx_import_mesh", {"mesh_prepare", "meshes"}},
+                {"fbx_import_animation", {"animations"}},
+                {"fbx_export_sdk", {"write"}}
+            }, [this](PhaseTimings& timings) { return exportFbx(false, timings); });
+            succeeded &= measure(results, {{"fbx_write_native", {"write"}}}, [this](PhaseTimings& timings) { return exportFbx(true, timings); });
+            succeeded &= measure(results, {
+                {"fbx_read_sdk", {"read"}},
+                {"badger_export_mesh", {"extract"}}
+            }, [this](PhaseTimings& timings) { return importFbx(false, timings); });
+            succeeded &= measure(results, {{"fbx_read_native", {"read"}}}, [this](PhaseTimings& timings) { return importFbx(true, timings); });
+            succeeded &= measure(results, {{"json_write", {"write"}}}, [this](PhaseTimings& timings) { return writeJson(timings); });
+            succeeded &= measure(results, {{"animation_sample", {"sample"}}}, [this](PhaseTimings& timings) { return sampleAnimations(timings); });
+            return succeeded;
+        }
+
+    private:
+        // A reported phase and the recorded phases it adds up.
+        using PhaseMapping = std::vector<std::pair<std::string, std::vector<std::string>>>;
+
+        // Runs once per iteration and reads the mapped phases from the timings of the run. Allocations are counted
+        // for the whole run, so phases measured by the same run report the same number.
+        bool measure(std::vector<PhaseResult>& results, const PhaseMapping& phases, const std::function<bool(PhaseTimings&)>& run) {
+            auto first = results.size();
+            for (const auto& phase : phases)
+                results.push_back({ .name = phase.first, .samples = {}, .allocations = {} });
+
+            for (auto i = 0; i < options.iterations; i++) {
+                PhaseTimings timings;
+                auto allocationsBefore = heapAllocations.load();
+                if (!run(timings)) {
+                    Log::error() << "Error: benchmark phase " << phases.front().first << " failed.";
+                    return false;
+                }
+                auto allocations = heapAllocations.load() - allocationsBefore;
+
+                for (size_t p = 0; p < phases.size(); p++) {
+                    const auto& recorded = phases[p].second;
+                    auto elapsed = 0.0;
+                    for (const auto& phase : timings.get()) {
+                        if (std::find(recorded.begin(), recorded.end(), phase.first) != recorded.end())
+                            elapsed += phase.second;
+                    }
+
+                    results[first + p].samples.push_back(elapsed);
+                    results[first + p].allocations.push_back(allocations);
+                }
+            }
+
+            return true;
+        }
+
+        bool parseResources(bool arenas, PhaseTimings& timings) {
+            Stopwatch stopwatch;
+            ResourceLoader loader(packsDirectory.c_str());
+            loader.setParseArenas(arenas);
+
+            if (!loader.getModel(assets.modelName) || !loader.getEntity(assets.modelName) || !loader.getAnimations(assets.modelName))
+                return false;
+
+            for (const auto& material : assets.materials) {
+                if (!loader.getMaterial(material.name))
+                    return false;
+            }
+
+            timings.record("parse", stopwatch);
+            return true;
+        }
+
+        // The SDK run writes sdk_output.fbx, the native run writes the file the import phases read.
+        bool exportFbx(bool native, PhaseTimings& timings) {
+            auto output = native ? nativeOutput : (options.workDirectory / "sdk_output.fbx").string();
+            FbxConverter converter(packsDirectory.c_str());
+            converter.nativeWriter = native;
+            if (!converter.convertToFbx(assets.modelName.c_str(), output.c_str()))
+                return false;
+
+            timings = converter.getTimings();
+            return true;
+        }
+
+        bool importFbx(bool native, PhaseTimings& timings) {
+            auto outputDirectory = (options.workDirectory / (native ? "native_import" : "sdk_import")).string();
+            PhaseTimings unused;
+            if (!std::filesystem::exists(nativeOutput) && !exportFbx(true, unused))
+                return false;
+
+            if (native) {
+                NativeFbxImporter importer;
+                if (!importer.convertToBadger(nativeOutput.c_str(), outputDirectory.c_str()))
+                    return false;
+                timings = importer.getTimings();
+            } else {
+                BadgerConverter converter;
+                if (!converter.convertToBadger(nativeOutput.c_str(), outputDirectory.c_str()))
+                    return false;
+                timings = converter.getTimings();
+            }
+            return true;
+        }
+
+        bool writeJson(PhaseTimings& timings) {
+            auto outputDirectory = options.workDirectory / "json_output";
+            std::filesystem::create_directories(outputDirectory);
+
+            Stopwatch stopwatch;
+            std::ofstream modelStream(outputDirectory / (assets.modelName + ".model.json"), std::ios::out);
+            modelStream << ArenaJson(assets.model);
+            modelStream.close();
+
+            std::ofstream animationsStream(outputDirectory / (assets.modelName + ".animations.json"), std::ios::out);
+            animationsStream << ArenaJson(assets.animations);
+            animationsStream.close();
+
+            if (!modelStream || !animationsStream)
+                return false;
+
+            timings.record("write", stopwatch);
+            return true;
+        }
+
+        // Every animation on a 60 fps grid, the way a baked export would sample it.
+        bool sampleAnimations(PhaseTimings& timings) {
+            Stopwatch stopwatch;
+            AnimationSampler sampler;
+            std::vector<AnimationSampler::Pose> poses;
+            for (const auto& animation : assets.animations.animations) {
+                if (!sampler.load(animation.second))
+                    return false;
+                sampler.sampleGrid(1.0 / 60.0, poses);
+            }
+
+            timings.record("sample", stopwatch);
+            return true;
+        }
+
+        const BenchmarkOptions& options;
+        const GeneratedAssets& assets;
+        std::string packsDirectory;
+        std::string nativeOutput;
+};
+
+json summarize(const PhaseResult& result) {
+    auto samples = result.samples;
+    std::sort(samples.begin(), samples.end());
+
+    json summary {
+        {"iterations", samples.size()},
+        {"samples_ms", result.samples}
+    };
+
+    if (!samples.empty()) {
+        summary["min_ms"] = samples.front();
+        summary["max_ms"] = samples.back();
+        summary["median_ms"] = samples[samples.size() / 2];
+        summary["mean_ms"] = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+        // Whole iterations, including the untimed setup.
+        summary["heap_allocations"] = std::accumulate(result.allocations.begin(), result.allocations.end(), size_t(0)) / result.allocations.size();
+    }
+
+    return summary;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    Log::setLevel(Log::Level::Error);
+
+    for (auto i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        auto hasValue = i + 1 < argc;
+
+        if (arg == "--verbose") {
+            Log::setLevel(Log::Level::Verbose);
+        } else if (arg == "--meshes" && hasValue) {
+            options.generator.meshes = std::stoi(argv[++i]);
+        } else if (arg == "--vertices" && hasValue) {
+            options.generator.verticesPerMesh = std::stoi(argv[++i]);
+        } else if (arg == "--bones" && hasValue) {
+            options.generator.bones = std::stoi(argv[++i]);
+        } else if (arg == "--influences" && hasValue) {
+            options.generator.influences = std::stoi(argv[++i]);
+        } else if (arg == "--animations" && hasValue) {
+            options.generator.animations = std::stoi(argv[++i]);
+        } else if (arg == "--keyframes" && hasValue) {
+            options.generator.keyframes = std::stoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.generator.seed = std::stoul(argv[++i]);
+        } else if (arg == "--iterations" && hasValue) {
+            options.iterations = std::stoi(argv[++i]);
+        } else if (arg == "--work-dir" && hasValue) {
+            options.workDirectory = argv[++i];
+        } else if (arg == "--output" && hasValue) {
+            options.output = argv[++i];
+        } else {
+            std::cout << "Usage: " << argv[0] << " [options]" << std::endl;
+            std::cout << "  --meshes <n> --vertices <n per mesh> --bones <n> --influences <n per vertex>" << std::endl;
+            std::cout << "  --animations <n> --keyframes <n per track> --seed <n>" << std::endl;
+            std::cout << "  --iterations <n> --work-dir <path> --output <results .json>" << std::endl;
+            return -1;
+        }
+    }
+
+    if (options.generator.meshes < 1 || options.generator.bones < 1 || options.iterations < 1) {
+        Log::error() << "Error: at least one mesh, bone and iteration is required.";
+        return -1;
+    }
+
+    auto assets = generateAssets(options.generator);
+    if (!writeResourcePack(options.workDirectory / "packs" / "bench", assets)) {
+        Log::error() << "Error: failed to write generated resource pack to " << options.workDirectory << ".";
+        return -1;
+    }
+
+    ConverterBenchmark benchmark(options, assets);
+    std::vector<PhaseResult> results;
+    if (!benchmark.run(results)) {
+        Log::error() << "Error: benchmark failed, no results are reported.";
+        Log::flush();
+        return -1;
+    }
+
+    json report {
+        {"config", {
+            {"meshes", options.generator.meshes},
+            {"vertices_per_mesh", options.generator.verticesPerMesh},
+            {"bones", options.generator.bones},
+            {"influences", options.generator.influences},
+            {"animations", options.generator.animations},
+            {"keyframes", options.generator.keyframes},
+            {"seed", options.generator.seed},
+            {"iterations", options.iterations}
+        }},
+        {"phases", json::object()}
+    };
+
+    for (const auto& result : results)
+        report["phases"][result.name] = summarize(result);
+
+    if (options.output.empty()) {
+        std::cout << report.dump(4) << std::endl;
+    } else {
+        std::ofstream outputStream(options.output, std::ios::out);
+        outputStream << report.dump(4);
+    }
+
+    Log::flush();
+
+    return 0;
+}
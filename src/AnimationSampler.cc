@@ -0,0 +1,173 @@
+#include "AnimationSampler.hh"
+#include "Log.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SAMPLER_SSE2
+#endif
+
+namespace {
+    constexpr size_t CHANNEL_COUNT = 3;
+    // Tracks evaluated together, their inputs are gathered on the stack so sampling never allocates.
+    constexpr size_t BATCH_SIZE = 16;
+
+    // Four keys and their weights per track, laid out so one register holds the same value of two tracks.
+    struct Batch {
+        alignas(16) double weights[4][BATCH_SIZE];
+        alignas(16) double points[4][3][BATCH_SIZE];
+        alignas(16) double results[3][BATCH_SIZE];
+    };
+
+    void blend(Batch& batch, size_t count) {
+        size_t track = 0;
+#ifdef SAMPLER_SSE2
+        for (; track + 2 <= count; track += 2) {
+            for (auto component = 0; component < 3; component++) {
+                auto sum = _mm_setzero_pd();
+                for (auto key = 0; key < 4; key++)
+                    sum = _mm_add_pd(sum, _mm_mul_pd(_mm_load_pd(&batch.weights[key][track]), _mm_load_pd(&batch.points[key][component][track])));
+                _mm_store_pd(&batch.results[component][track], sum);
+            }
+        }
+#endif
+        for (; track < count; track++) {
+            for (auto component = 0; component < 3; component++) {
+                auto sum = 0.0;
+                for (auto key = 0; key < 4; key++)
+                    sum += batch.weights[key][track] * batch.points[key][component][track];
+                batch.results[component][track] = sum;
+            }
+        }
+    }
+}
+
+bool AnimationSampler::load(const Badger::Animation& animation) {
+    bones.clear();
+    tracks.clear();
+    duration = 0;
+
+    for (const auto& bone : animation.bones)
+        bones.push_back(bone.first);
+    std::sort(bones.begin(), bones.end());
+
+    tracks.resize(bones.size() * CHANNEL_COUNT);
+    for (size_t i = 0; i < bones.size(); i++) {
+        const auto& bone = animation.bones.at(bones[i]);
+        const std::array<const std::unordered_map<double, Badger::AnimationProperty>*, CHANNEL_COUNT> channels { &bone.position, &bone.rotation, &bone.scale };
+
+        for (size_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            // Keyframes are stored unordered.
+            std::vector<std::pair<double, const Badger::AnimationProperty*>> keys;
+            for (const auto& keyframe : *channels[channel])
+                keys.emplace_back(keyframe.first, &keyframe.second);
+            std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+            auto& track = tracks[channel * bones.size() + i];
+            for (const auto& [time, property] : keys) {
+                if (property->post.size() < 3 || !std::isfinite(time)) {
+                    Log::error() << "Error: keyframe " << time << " of bone " << bones[i] << " is invalid.";
+                    return false;
+                }
+
+                track.times.push_back(time);
+                track.values.insert(track.values.end(), property->post.begin(), property->post.begin() + 3);
+                track.smooth.push_back(property->lerpMode == "catmullrom");
+                duration = std::max(duration, time);
+            }
+        }
+    }
+
+    return true;
+}
+
+void AnimationSampler::sample(double time, Pose& pose) const {
+    const std::array<std::vector<double>*, CHANNEL_COUNT> outputs { &pose.position, &pose.rotation, &pose.scale };
+    for (auto output : outputs)
+        output->resize(bones.size() * 3);
+
+    static const double zero[3] {};
+    Batch batch;
+
+    for (size_t first = 0; first < tracks.size(); first += BATCH_SIZE) {
+        auto count = std::min(BATCH_SIZE, tracks.size() - first);
+
+        // Finding the segment is scalar, the weighted sum of its keys is done for the whole batch at once.
+        for (size_t i = 0; i < count; i++) {
+            const auto& track = tracks[first + i];
+            auto keyCount = track.times.size();
+
+            std::array<const double*, 4> points { zero, zero, zero, zero };
+            std::array<double, 4> weights { 0, 1, 0, 0 };
+
+            if (keyCount != 0) {
+                auto next = static_cast<size_t>(std::upper_bound(track.times.begin(), track.times.end(), time) - track.times.begin());
+                auto key = [&](size_t index) { return &track.values[std::min(index, keyCount - 1) * 3]; };
+
+                if (next == 0 || next == keyCount) {
+                    points[1] = key(next == 0 ? 0 : keyCount - 1);
+                } else {
+                    auto current = next - 1;
+                    auto u = (time - track.times[current]) / (track.times[next] - track.times[current]);
+                    points = { key(current == 0 ? 0 : current - 1), key(current), key(next), key(next + 1) };
+
+                    if (track.smooth[current] || track.smooth[next]) {
+                        auto u2 = u * u;
+                        auto u3 = u2 * u;
+                        weights = { 0.5 * (-u + 2 * u2 - u3), 0.5 * (2 - 5 * u2 + 3 * u3), 0.5 * (u + 4 * u2 - 3 * u3), 0.5 * (u3 - u2) };
+                    } else {
+                        weights = { 0, 1 - u, u, 0 };
+                    }
+                }
+            }
+
+            for (auto k = 0; k < 4; k++) {
+                batch.weights[k][i] = weights[k];
+                for (auto component = 0; component < 3; component++)
+                    batch.points[k][component][i] = points[k][component];
+            }
+        }
+
+        blend(batch, count);
+
+        for (size_t i = 0; i < count; i++) {
+            auto channel = (first + i) / bones.size();
+            auto bone = (first + i) % bones.size();
+            for (auto component = 0; component < 3; component++)
+                (*outputs[channel])[bone * 3 + component] = batch.results[component][i];
+        }
+    }
+}
+
+void AnimationSampler::sampleGrid(double step, std::vector<Pose>& poses) const {
+    poses.clear();
+    if (!(step > 0))
+        return;
+
+    // Computed from the index so the error does not accumulate over long animations.
+    auto count = static_cast<size_t>(std::floor(duration / step + 1e-9)) + 1;
+    poses.resize(count);
+    for (size_t i = 0; i < count; i++)
+        sample(std::min(i * step, duration), poses[i]);
+}
+
+std::vector<KeyTangents> catmullRomTangents(const std::vector<double>& times, const std::vector<double>& values, const std::vector<char>& smooth) {
+    auto count = times.size();
+    std::vector<KeyTangents> tangents(count, { false, 0, 0 });
+
+    for (size_t i = 0; i + 1 < count; i++) {
+        if (!smooth[i] && !smooth[i + 1])
+            continue;
+
+        // The spline's tangents are per segment, so they are scaled by this segment's length only.
+        auto length = times[i + 1] - times[i];
+        auto previous = values[i == 0 ? 0 : i - 1];
+        auto following = values[std::min(i + 2, count - 1)];
+        tangents[i] = { true, (values[i + 1] - previous) / (2 * length), (following - values[i]) / (2 * length) };
+    }
+
+    return tangents;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "BadgerModel.hh"
+
+#include <string>
+#include <vector>
+
+// Evaluates the bone tracks of a Badger animation at arbitrary times. Values are the offsets Badger
+// stores, which are added to the rest pose. Segments touching a "catmullrom" keyframe are interpolated
+// with a Catmull-Rom spline through the neighbouring keys, all others linearly. Before the first and
+// after the last keyframe a track holds its value, bones without keys for a channel sample as 0.
+class AnimationSampler {
+    public:
+        // Three values per bone and channel, bones in getBones() order.
+        struct Pose {
+            std::vector<double> position;
+            std::vector<double> rotation;
+            std::vector<double> scale;
+        };
+
+        bool load(const Badger::Animation& animation);
+
+        const std::vector<std::string>& getBones() const { return bones; }
+        // Time of the last keyframe in seconds.
+        double getDuration() const { return duration; }
+
+        void sample(double time, Pose& pose) const;
+        // Samples every step seconds from 0 up to and including the duration.
+        void sampleGrid(double step, std::vector<Pose>& poses) const;
+
+    private:
+        struct Track {
+            std::vector<double> times;
+            // Three values per key.
+            std::vector<double> values;
+            std::vector<char> smooth;
+        };
+
+        // Position, rotation and scale tracks of all bones, one channel after another.
+        std::vector<Track> tracks;
+        std::vector<std::string> bones;
+        double duration = 0;
+};
+
+// Tangents of one key for a cubic Hermite curve, like an FBX key with user tangents. Slopes are per second.
+struct KeyTangents {
+    // Whether the segment starting at this key is cubic, linear otherwise.
+    bool cubic;
+    double rightSlope;
+    // Slope at the end of the segment, on the next key's left side.
+    double nextLeftSlope;
+};
+
+// Tangents that make a cubic curve through the keys match AnimationSampler exactly: Catmull-Rom segments
+// become Hermite segments with the spline's end tangents, the rest stays linear. Takes one component.
+std::vector<KeyTangents> catmullRomTangents(const std::vector<double>& times, const std::vector<double>& values, const std::vector<char>& smooth);
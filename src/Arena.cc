@@ -0,0 +1,36 @@
+#include "Arena.hh"
+
+namespace {
+    thread_local std::pmr::memory_resource* currentArena = nullptr;
+
+    struct alignas(ArenaDetail::HEADER_SIZE) Header {
+        std::pmr::memory_resource* arena;
+    };
+
+    static_assert(sizeof(Header) == ArenaDetail::HEADER_SIZE);
+}
+
+ArenaScope::ArenaScope(std::pmr::memory_resource* arena) : previous(currentArena) {
+    currentArena = arena;
+}
+
+ArenaScope::~ArenaScope() {
+    currentArena = previous;
+}
+
+void* ArenaDetail::allocate(size_t size) {
+    auto arena = currentArena;
+    auto total = size + HEADER_SIZE;
+    auto block = arena != nullptr ? arena->allocate(total, HEADER_SIZE) : ::operator new(total);
+
+    auto header = new (block) Header { arena };
+    return header + 1;
+}
+
+void ArenaDetail::deallocate(void* pointer, size_t size) noexcept {
+    auto header = static_cast<Header*>(pointer) - 1;
+    if (header->arena != nullptr)
+        header->arena->deallocate(header, size + HEADER_SIZE, HEADER_SIZE);
+    else
+        ::operator delete(header);
+}
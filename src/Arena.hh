@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+// Monotonic memory for everything parsed from one file. Deallocation is a no-op, the memory is
+// released in one step when the arena is destroyed.
+class Arena : public std::pmr::memory_resource {
+    public:
+        explicit Arena(size_t initialSize = 64 * 1024) : buffer(initialSize) {}
+
+        size_t getAllocations() const { return allocations; }
+        size_t getBytes() const { return bytes; }
+
+    private:
+        void* do_allocate(size_t size, size_t alignment) override {
+            allocations++;
+            bytes += size;
+            return buffer.allocate(size, alignment);
+        }
+
+        void do_deallocate(void*, size_t, size_t) override {}
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+        std::pmr::monotonic_buffer_resource buffer;
+        size_t allocations = 0;
+        size_t bytes = 0;
+};
+
+// Makes ArenaAllocator allocate from the arena on this thread until the scope ends. Scopes nest,
+// a null arena switches back to the global heap. Nothing allocated in the scope may outlive the arena.
+class ArenaScope {
+    public:
+        explicit ArenaScope(std::pmr::memory_resource* arena);
+        ~ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+    private:
+        std::pmr::memory_resource* previous;
+};
+
+namespace ArenaDetail {
+    // Every block starts with a header naming the arena it came from, null for the global heap, so blocks
+    // can be freed correctly wherever they end up.
+    constexpr size_t HEADER_SIZE = 16;
+
+    void* allocate(size_t size);
+    void deallocate(void* pointer, size_t size) noexcept;
+}
+
+// Stateless allocator that takes its memory from the current ArenaScope, or the global heap outside of
+// one. Being stateless it can be plugged into types like nlohmann::basic_json, which only take an
+// allocator template, and values can still be moved between arena and heap memory freely.
+template <typename T>
+class ArenaAllocator {
+    public:
+        using value_type = T;
+        using is_always_equal = std::true_type;
+
+        ArenaAllocator() = default;
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+        T* allocate(size_t count) {
+            static_assert(alignof(T) <= ArenaDetail::HEADER_SIZE, "ArenaAllocator does not support over-aligned types.");
+            if (count > (SIZE_MAX - ArenaDetail::HEADER_SIZE) / sizeof(T))
+                throw std::bad_array_new_length();
+            return static_cast<T*>(ArenaDetail::allocate(count * sizeof(T)));
+        }
+
+        void deallocate(T* pointer, size_t count) noexcept {
+            ArenaDetail::deallocate(pointer, count * sizeof(T));
+        }
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>&) const noexcept { return true; }
+};
@@ -1,96 +1,188 @@
 #include "BadgerConverter.hh"
+#include "BadgerWriter.hh"
+#include "Log.hh"
+#include "NativeFbxImporter.hh"
+#include "Parallel.hh"
+#include "Stopwatch.hh"
+
+#include <unordered_map>
+
+namespace {
+    ElementMapping elementMapping(const FbxLayerElement* element) {
+        switch (element->GetMappingMode()) {
+            case FbxLayerElement::eByPolygonVertex:
+                return ElementMapping::ByPolygonVertex;
+            case FbxLayerElement::eByPolygon:
+                return ElementMapping::ByPolygon;
+            case FbxLayerElement::eAllSame:
+                return ElementMapping::AllSame;
+            default:
+                return ElementMapping::ByControlPoint;
+        }
+    }
 
-#include <iostream>
-#include <fstream>
+    // Copies a layer element as it is stored, the index array is kept so that buildMesh can de-index it.
+    template<typename T, typename Convert>
+    MeshElement readElement(const FbxLayerElementTemplate<T>* element, Convert convert) {
+        MeshElement result;
+        result.mapping = elementMapping(element);
+
+        const auto& direct = element->GetDirectArray();
+        result.values.reserve(direct.GetCount());
+        for (auto i = 0; i < direct.GetCount(); i++)
+            result.values.push_back(convert(direct[i]));
+
+        if (element->GetReferenceMode() != FbxLayerElement::eDirect) {
+            const auto& indices = element->GetIndexArray();
+            result.indices.resize(indices.GetCount());
+            for (auto i = 0; i < indices.GetCount(); i++)
+                result.indices[i] = indices[i];
+        }
+
+        return result;
+    }
+}
 
 BadgerConverter::BadgerConverter() : model() {
     manager = FbxManager::Create();
     auto ioSettings = FbxIOSettings::Create(manager, IOSROOT);
     manager->SetIOSettings(ioSettings);
-    scene = FbxScene::Create(manager, "ExportedScene");
+    scene = nullptr;
 
     model.formatVersion = "1.14.0";
 }
 
+BadgerConverter::~BadgerConverter() {
+    if (manager != nullptr)
+        manager->Destroy();
+}
+
+void BadgerConverter::resetScene() {
+    if (scene != nullptr)
+        scene->Destroy(true);
+
+    scene = FbxScene::Create(manager, "ExportedScene");
+    model.geometry.clear();
+    exportedMaterials.clear();
+    exportedAnimations.clear();
+    sceneTable.clear();
+}
+
+void BadgerConverter::buildSceneTable() {
+    sceneTable.clear();
+
+    // Iterative pre-order walk, children are pushed in reverse so they are visited in order.
+    std::vector<std::pair<FbxNode*, int>> pending { { scene->GetRootNode(), -1 } };
+    while (!pending.empty()) {
+        auto [node, parent] = pending.back();
+        pending.pop_back();
+
+        auto kind = NodeKind::Other;
+        if (auto attribute = node->GetNodeAttribute(); attribute != nullptr) {
+            switch (attribute->GetAttributeType()) {
+                case FbxNodeAttribute::eSkeleton:
+                    kind = NodeKind::Skeleton;
+                    break;
+                case FbxNodeAttribute::eNull:
+                    kind = NodeKind::Null;
+                    break;
+                case FbxNodeAttribute::eMesh:
+                    kind = NodeKind::Mesh;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        auto index = static_cast<int>(sceneTable.size());
+        sceneTable.push_back({
+            .node = node,
+            .parent = parent,
+            .kind = kind,
+            .name = node->GetName(),
+            .translation = node->LclTranslation.Get(),
+            .rotation = node->LclRotation.Get(),
+            .scaling = node->LclScaling.Get()
+        });
+
+        for (auto i = node->GetChildCount() - 1; i >= 0; i--)
+            pending.emplace_back(node->GetChild(i), index);
+    }
+}
+
 bool BadgerConverter::convertToBadger(const char* fbx, const char* outputDirectory) {
+    resetScene();
+    timings.clear();
+
+    if (nativeReader) {
+        NativeFbxImporter importer;
+        importer.threads = threads;
+        importer.weldTolerance = weldTolerance;
+        importer.influenceLimits = influenceLimits;
+        if (importer.convertToBadger(fbx, outputDirectory)) {
+            timings = importer.getTimings();
+            return true;
+        }
+
+        Log::warning() << "Warning: the native fbx reader could not convert " << fbx << ", falling back to the FBX SDK.";
+    }
+
+    Stopwatch stopwatch;
+
     auto importer = FbxImporter::Create(manager, "");
 
     auto fbxFilename = std::filesystem::path(fbx).stem().string();
 
-    std::cout << "Importing fbx." << std::endl;
+    Log::info() << "Importing fbx.";
 
     bool importStatus = importer->Initialize(fbx, -1, manager->GetIOSettings());
 
     if (!importStatus) {
-        std::cerr << "Error: failed to import fbx." << std::endl;
+        Log::error() << "Error: failed to import fbx.";
         return false;
     }
 
     importer->Import(scene);
     importer->Destroy();
+    timings.record("read", stopwatch);
 
-    std::cout << "Imported fbx." << std::endl;
-
-    FbxGeometryConverter converter(manager);
-    if (!converter.Triangulate(scene, true)) {
-        std::cerr << "Error: failed to triangulate mesh." << std::endl;
-        return false;
-    }
+    Log::info() << "Imported fbx.";
 
     Badger::Geometry geometry;
     geometry.description.identifier = "geometry." + fbxFilename;
 
-    const auto processNodeRecursive = [this, &geometry](FbxNode* const child) {
-        const auto process = [this, &geometry](FbxNode* const child, auto& processFunc) {
-            auto attribute = child->GetNodeAttribute();
-            if (attribute != nullptr) {
-                auto type = attribute->GetAttributeType();
-
-                if (type == FbxNodeAttribute::eSkeleton) {
-                    std::cout << "Node: " << child->GetName() << " - exporting bone." << std::endl;
-
-                    FbxSkeleton* bone = FbxCast<FbxSkeleton>(attribute);
-                    if (!exportBone(geometry, bone, child)) {
-                        std::cerr << "Error: failed to export bone." << std::endl;
-                        return false;
-                    }
-                } else if (type == FbxNodeAttribute::eMesh) {
-                    std::cout << "Node: " << child->GetName() << " - exporting mesh." << std::endl;
+    buildSceneTable();
 
-                    FbxMesh* mesh = FbxCast<FbxMesh>(attribute);
-                    if (!exportMesh(geometry, mesh, child)) {
-                        std::cerr << "Error: failed to export mesh." << std::endl;
-                        return false;
-                    }
-                }
-            }
-
-            for (auto i = 0; i < child->GetChildCount(); i++) {
-                if (!processFunc(child->GetChild(i), processFunc))
-                    return false;
-            }
-
-            return true;
-        };
+    Log::info() << "Exporting bones.";
+    if (!exportBones(geometry))
+        return false;
+    timings.record("bones", stopwatch);
 
-        return process(child, process);
-    };
+    std::vector<FbxNode*> meshNodes;
+    for (const auto& entry : sceneTable) {
+        if (entry.kind == NodeKind::Mesh) {
+            Log::verbose() << "Node: " << entry.name << " - collecting mesh.";
+            meshNodes.push_back(entry.node);
+        }
+    }
 
-    auto root = scene->GetRootNode();
-    processNodeRecursive(root);
+    Log::info() << "Exporting " << meshNodes.size() << " meshes.";
+    if (!exportMeshes(geometry, meshNodes))
+        return false;
+    timings.record("extract", stopwatch);
 
     auto animationCount = scene->GetSrcObjectCount<FbxAnimStack>();
     if (animationCount > 0) {
-        std::cout << "Exporting animations." << std::endl;
+        Log::info() << "Exporting animations.";
         for (auto i = 0; i < animationCount; i++) {
             auto stack = scene->GetSrcObject<FbxAnimStack>(i);
             if (!exportAnimation(stack)) {
-                std::cerr << "Error: failed to export animation." << std::endl;
+                Log::error() << "Error: failed to export animation.";
                 return false;
             }
         }
     }
-
+    timings.record("animations", stopwatch);
 
     if (geometry.bones.empty()) {
         Badger::Bone bone {
@@ -114,198 +206,147 @@ bool BadgerConverter::convertToBadger(const char* fbx, const char* outputDirecto
 
     model.geometry.push_back(geometry);
 
-    std::cout << "Creating model JSON." << std::endl;
-
-    std::filesystem::path outputPath(outputDirectory);
-    std::filesystem::create_directories(outputPath);
-
-    std::filesystem::path modelOutput(outputPath);
-    modelOutput = modelOutput / "models" / "entity";
-    std::filesystem::create_directories(modelOutput);
-    modelOutput /= (fbxFilename + ".model.json");
-
-    std::ofstream modelOutputStream(modelOutput, std::ios::out);
-
-    json modelJson(model);
-    modelOutputStream << modelJson;
-    modelOutputStream.close();
-
-    // TODO
-    std::cout << "Creating material JSONs." << std::endl;
-
-    auto materialDir = std::filesystem::path(outputDirectory);
-    materialDir /= "materials";
-    std::filesystem::create_directories(materialDir);
-
-    auto textureDir = std::filesystem::path(outputDirectory) / "textures" / "entity";
-    std::filesystem::create_directories(textureDir);
-
-    auto copyAndRedirectTexture = [&](std::string& path) {
-        std::filesystem::path originalTexPath(path);
-        std::filesystem::path newTexPath(textureDir);
-        newTexPath /= originalTexPath.filename();
+    if (!writeBadgerPack(outputDirectory, fbxFilename, model, exportedMaterials, exportedAnimations))
+        return false;
 
-        if (std::filesystem::exists(newTexPath))
-            std::filesystem::remove(newTexPath);
+    timings.record("write", stopwatch);
 
-        std::filesystem::copy(originalTexPath, newTexPath);
+    Log::info() << "Export finished.";
 
-        path = "textures/entity/" + originalTexPath.stem().string();
-    };
+    return true;
+}
 
-    std::ofstream materialOutputStream;
-    for (auto& pair : exportedMaterials) {
-        if (!pair.second.info.textures.diffuse.empty())
-            copyAndRedirectTexture(pair.second.info.textures.diffuse);
-        if (!pair.second.info.textures.coeff.empty())
-            copyAndRedirectTexture(pair.second.info.textures.coeff);
-        if (!pair.second.info.textures.normal.empty())
-            copyAndRedirectTexture(pair.second.info.textures.normal);
-        if (!pair.second.info.textures.emissive.empty())
-            copyAndRedirectTexture(pair.second.info.textures.emissive);
-
-        auto materialOutputPath = std::filesystem::path(materialDir);
-        materialOutputPath /= (pair.second.name + ".json");
-        json materialJson(pair.second);
-        materialOutputStream.open(materialOutputPath);
-        materialOutputStream << materialJson;
-        materialOutputStream.close();
+bool BadgerConverter::exportMeshes(Badger::Geometry& geometry, const std::vector<FbxNode*>& meshNodes) {
+    // Instanced nodes share one FbxMesh and the lock counters on its layer element arrays are not
+    // thread-safe, so each distinct mesh is extracted once, by a single thread.
+    std::vector<const FbxMesh*> distinctMeshes;
+    std::vector<const FbxNode*> firstNodes;
+    std::vector<size_t> nodeMeshes(meshNodes.size());
+    std::unordered_map<const FbxMesh*, size_t> meshIndices;
+    for (size_t i = 0; i < meshNodes.size(); i++) {
+        auto mesh = FbxCast<FbxMesh>(meshNodes[i]->GetNodeAttribute());
+        auto [it, inserted] = meshIndices.try_emplace(mesh, distinctMeshes.size());
+        if (inserted) {
+            distinctMeshes.push_back(mesh);
+            firstNodes.push_back(meshNodes[i]);
+        }
+        nodeMeshes[i] = it->second;
     }
 
-    if (!exportedAnimations.empty()) {
-        std::cout << "Creating animation JSON." << std::endl;
-
-        Badger::Animations animations {
-            .formatVersion = "1.8.0",
-            .animations = exportedAnimations
-        };
+    if (distinctMeshes.size() != meshNodes.size())
+        Log::verbose() << "Extracting " << distinctMeshes.size() << " distinct meshes for " << meshNodes.size() << " mesh nodes.";
+
+    std::vector<Badger::Mesh> meshes(distinctMeshes.size());
+    std::vector<int> materialIndices(distinctMeshes.size(), -1);
+    std::vector<char> succeeded(distinctMeshes.size(), false);
+    parallelFor(distinctMeshes.size(), threads, [&](size_t i) {
+        Log::verbose() << "Node: " << firstNodes[i]->GetName() << " - exporting mesh.";
+        succeeded[i] = exportMesh(meshes[i], materialIndices[i], distinctMeshes[i], firstNodes[i]);
+    });
+
+    std::vector<size_t> remainingUses(distinctMeshes.size(), 0);
+    for (auto mesh : nodeMeshes)
+        remainingUses[mesh]++;
+
+    // Materials are shared between meshes, they are resolved per node and exported while merging in scene order.
+    for (size_t i = 0; i < meshNodes.size(); i++) {
+        auto node = meshNodes[i];
+        auto mesh = nodeMeshes[i];
+        if (!succeeded[mesh]) {
+            Log::error() << "Error: failed to export mesh " << node->GetName() << ".";
+            return false;
+        }
 
-        auto animationsPath = std::filesystem::path(outputDirectory) / "animations";
-        std::filesystem::create_directories(animationsPath);
+        const FbxSurfaceMaterial* material = node->GetMaterial(materialIndices[mesh]);
+        if (material == nullptr) {
+            Log::error() << "Error: mesh material index " << materialIndices[mesh] << " is out of range for node " << node->GetName() << ".";
+            return false;
+        }
 
-        animationsPath /= (fbxFilename + ".animations.json");
+        if (!exportMaterial(material))
+            return false;
 
-        std::ofstream animationsOutputStream(animationsPath, std::ios::out);
-        json animationsJson(animations);
-        animationsOutputStream << animationsJson;
-        animationsOutputStream.close();
+        // Every node but the last one using a mesh gets a copy.
+        if (--remainingUses[mesh] == 0)
+            geometry.meshes.push_back(std::move(meshes[mesh]));
+        else
+            geometry.meshes.push_back(meshes[mesh]);
+        geometry.meshes.back().material = exportedMaterials.at(material->GetName()).name;
     }
 
-    std::cout << "Export finished." << std::endl;
-
     return true;
 }
 
-bool BadgerConverter::exportMesh(Badger::Geometry& geometry, const FbxMesh* mesh, const FbxNode* node) {
-    Badger::Mesh badgerMesh;
+bool BadgerConverter::exportMesh(Badger::Mesh& badgerMesh, int& materialIndex, const FbxMesh* mesh, const FbxNode* node) const {
     auto controlPointCount = mesh->GetControlPointsCount();
-    badgerMesh.positions.reserve(controlPointCount);
-    badgerMesh.weights.reserve(controlPointCount);
+    MeshSource source;
+    source.positions.reserve(controlPointCount);
 
-    std::cout << "Exporting positions." << std::endl;
+    Log::verbose() << "Exporting positions.";
 
     for (auto i = 0; i < controlPointCount; i++) {
         double* controlPoint = mesh->GetControlPoints()[i];
         std::vector<double> position{&controlPoint[0], &controlPoint[3]};
-        badgerMesh.positions.push_back(position);
+        source.positions.push_back(position);
     }
 
-    std::cout << "Exporting triangles." << std::endl;
+    Log::verbose() << "Exporting triangles.";
 
+    // Only meshes with polygons other than triangles are split, the scene itself is left untouched.
     auto polygonCount = mesh->GetPolygonCount();
-    auto verticesCount = mesh->GetPolygonVertexCount();
-    if (polygonCount * 3 != mesh->GetPolygonVertexCount()) {
-        std::cerr << "Error: the mesh is not triangulated." << std::endl;
+    std::vector<int> polygonSizes(polygonCount);
+    for (auto i = 0; i < polygonCount; i++)
+        polygonSizes[i] = mesh->GetPolygonSize(i);
+
+    Triangulation triangulation;
+    std::span<const int> polygonVertices(mesh->GetPolygonVertices(), mesh->GetPolygonVertexCount());
+    auto controlPoints = reinterpret_cast<const double*>(mesh->GetControlPoints());
+    if (!triangulatePolygons(polygonVertices, polygonSizes, controlPoints, controlPointCount, 4, triangulation)) {
+        Log::error() << "Error: failed to triangulate mesh, a polygon vertex is out of range.";
         return false;
     }
 
-    badgerMesh.triangles.reserve(polygonCount);
-    auto vertices = mesh->GetPolygonVertices();
-    badgerMesh.triangles.insert(badgerMesh.triangles.begin(), &vertices[0], &vertices[verticesCount]);
-
-    std::cout << "Exporting normals." << std::endl;
+    if (triangulation.splitPolygons != 0)
+        Log::verbose() << "Triangulated " << triangulation.splitPolygons << " polygons.";
 
-    auto normalsCount = mesh->GetElementNormalCount();
-    badgerMesh.normals.reserve(normalsCount);
-    if (normalsCount != 0) {
-        for (auto i = 0; i < normalsCount; i++) {
-            auto normalElement = mesh->GetElementNormal(i);
-            auto normalCount = normalElement->GetDirectArray().GetCount();
+    Log::verbose() << "Exporting normals.";
 
-            std::vector<std::vector<double>> normalsVec;
-            normalsVec.reserve(normalCount);
-
-            for (auto j = 0; j < normalCount; j++) {
-                auto normal = normalElement->GetDirectArray()[j];
-                std::vector<double> normalVec(&normal[0], &normal[4]);
-                normalsVec.push_back(normalVec);
-            }
-
-            badgerMesh.normals.push_back(normalsVec);
-        }
+    for (auto i = 0; i < mesh->GetElementNormalCount(); i++) {
+        source.normals.push_back(readElement(mesh->GetElementNormal(i), [](const FbxVector4& normal) {
+            return std::vector<double>(&normal[0], &normal[4]);
+        }));
     }
 
-    std::cout << "Exporting UVs." << std::endl;
-
-    auto uvsCount = mesh->GetElementUVCount();
-    badgerMesh.uvs.reserve(uvsCount);
-    if (uvsCount != 0) {
-        for (auto i = 0; i < uvsCount; i++) {
-            auto uvElement = mesh->GetElementUV(i);
-            auto uvCount = uvElement->GetDirectArray().GetCount();
+    Log::verbose() << "Exporting UVs.";
 
-            std::vector<std::vector<double>> uvsVec;
-            uvsVec.reserve(uvCount);
-
-            for (auto j = 0; j < uvCount; j++) {
-                auto uv = uvElement->GetDirectArray()[j];
-                std::vector<double> uvVec {
-                    uv[0], 1 - uv[1]
-                };
-                uvsVec.push_back(uvVec);
-            }
-
-            badgerMesh.uvs.push_back(uvsVec);
-        }
+    for (auto i = 0; i < mesh->GetElementUVCount(); i++) {
+        source.uvs.push_back(readElement(mesh->GetElementUV(i), [](const FbxVector2& uv) {
+            return std::vector<double> { uv[0], 1 - uv[1] };
+        }));
     }
 
-    std::cout << "Exporting vertex colors." << std::endl;
-
-    auto colorsCount = mesh->GetElementVertexColorCount();
-    badgerMesh.colors.reserve(colorsCount);
-    if (colorsCount != 0) {
-        for (auto i = 0; i < colorsCount; i++) {
-            auto colorElement = mesh->GetElementVertexColor(i);
-            auto colorCount = colorElement->GetDirectArray().GetCount();
-
-            std::vector<std::vector<double>> colorsVec;
-            colorsVec.reserve(colorCount);
+    Log::verbose() << "Exporting vertex colors.";
 
-            for (auto j = 0; j < colorCount; j++) {
-                auto color = colorElement->GetDirectArray()[j];
-                std::vector<double> colorVec(&color[0], &color[4]);
-                colorsVec.push_back(colorVec);
-            }
-
-            badgerMesh.colors.push_back(colorsVec);
-        }
+    for (auto i = 0; i < mesh->GetElementVertexColorCount(); i++) {
+        source.colors.push_back(readElement(mesh->GetElementVertexColor(i), [](const FbxColor& color) {
+            return std::vector<double>(&color[0], &color[4]);
+        }));
     }
 
-
     auto deformer = mesh->GetDeformer(0);
     if (deformer != nullptr && deformer->GetDeformerType() == FbxDeformer::eSkin) {
-        std::cout << "Exporting skin information." << std::endl;
+        Log::verbose() << "Exporting skin information.";
         FbxSkin* skin = FbxCast<FbxSkin>(deformer);
 
         // Using resize here as we need the elements initialized
-        badgerMesh.weights.resize(controlPointCount);
-        badgerMesh.indices.resize(controlPointCount);
+        source.weights.resize(controlPointCount);
+        source.boneNames.resize(controlPointCount);
 
         for (auto i = 0; i < skin->GetClusterCount(); i++) {
             FbxCluster* cluster = skin->GetCluster(i);
             auto link = cluster->GetLink();
             if (link == nullptr) {
-                std::cerr << "Error: skin cluster had no bone linked to it." << std::endl;
+                Log::error() << "Error: skin cluster had no bone linked to it.";
                 return false;
             }
 
@@ -318,49 +359,49 @@ bool BadgerConverter::exportMesh(Badger::Geometry& geometry, const FbxMesh* mesh
             auto weights = cluster->GetControlPointWeights();
 
             if (indices == nullptr) {
-                std::cerr << "Error: skin cluster has no indices." << std::endl;
+                Log::error() << "Error: skin cluster has no indices.";
                 return false;             
             }
 
             if (weights == nullptr) {
-                std::cerr << "Error: skin cluster has no weights." << std::endl;
+                Log::error() << "Error: skin cluster has no weights.";
                 return false;
             }
 
-            auto boneName = link->GetName();
+            Symbol boneName(link->GetName());
 
             for (auto j = 0; j < clusterControlPointCount; j++) {
                 auto controlPointIndex = indices[j];
                 if (controlPointIndex >= controlPointCount) {
-                    std::cerr << "Error: skin cluster contains control point index which is greater than the total control point count." << std::endl;
+                    Log::error() << "Error: skin cluster contains control point index which is greater than the total control point count.";
                     return false;
                 }
 
-                badgerMesh.indices.at(controlPointIndex).push_back(boneName);
-                badgerMesh.weights.at(controlPointIndex).push_back(weights[j]);
+                source.boneNames.at(controlPointIndex).push_back(boneName);
+                source.weights.at(controlPointIndex).push_back(weights[j]);
             }
         }
+
+        if (auto pruned = limitInfluences(source, influenceLimits); pruned != 0)
+            Log::info() << "Pruned " << pruned << " skin influences from mesh " << node->GetName() << ".";
     }
 
-    std::cout << "Exporting material." << std::endl;
+    Log::verbose() << "Building vertices.";
+
+    if (!buildMesh(source, triangulation, weldTolerance, badgerMesh))
+        return false;
+
+    Log::verbose() << "Exporting material.";
 
     auto materialCount = mesh->GetElementMaterialCount();
     if (materialCount == 0) {
-        std::cerr << "Error: mesh has no material." << std::endl;
+        Log::error() << "Error: mesh has no material.";
         return false;
     } else if (materialCount > 1) {
-        std::cerr << "Warning: mesh has more than one material, using first." << std::endl;
+        Log::warning() << "Warning: mesh has more than one material, using first.";
     }
 
-    auto materialIndex = mesh->GetElementMaterial()->GetIndexArray().GetFirst();
-    auto material = node->GetMaterial(materialIndex);
-
-    exportMaterial(material);
-
-    badgerMesh.material = exportedMaterials.at(material->GetName()).name;
-
-    geometry.meshes.push_back(badgerMesh);
-
+    materialIndex = mesh->GetElementMaterial()->GetIndexArray().GetFirst();
     return true;
 }
 
@@ -384,20 +425,20 @@ bool BadgerConverter::exportMaterial(const FbxSurfaceMaterial* material) {
     auto assignTextureName = [&](const char* isUsedProperty, const char* texProperty, std::string& badgerProp) -> bool {
         auto usedProp = material->FindPropertyHierarchical(isUsedProperty);
         if (!usedProp.IsValid()) {
-            std::cerr << "Could not find property " << isUsedProperty << " on material." << std::endl;
+            Log::error() << "Could not find property " << isUsedProperty << " on material.";
             return false;
         }
 
         if (usedProp.Get<bool>()) {
             auto texProp = material->FindPropertyHierarchical(texProperty);
             if (!texProp.IsValid()) {
-                std::cerr << "Could not find property " << texProperty << " on material." << std::endl;
+                Log::error() << "Could not find property " << texProperty << " on material.";
                 return false;
             }
 
             auto connectedTexture = texProp.GetSrcObject<FbxFileTexture>(0);
             if (connectedTexture == nullptr) {
-                std::cerr << "Material has no connected texture for property " << texProperty << std::endl;
+                Log::error() << "Material has no connected texture for property " << texProperty;
                 return false;
             }
 
@@ -416,52 +457,47 @@ bool BadgerConverter::exportMaterial(const FbxSurfaceMaterial* material) {
     return true;
 }
 
-bool BadgerConverter::exportBone(Badger::Geometry& geometry, const FbxSkeleton* skeleton, const FbxNode* node) {    
+bool BadgerConverter::exportBones(Badger::Geometry& geometry) const {
     auto convertVector = [&](FbxDouble3 vec) -> std::vector<double> {
         return std::vector<double>(&vec[0], &vec[3]);
     };
-    
-    Badger::Bone badgerBone {};
-    badgerBone.name = node->GetName();
 
-    badgerBone.scale = convertVector(node->LclScaling.Get());
-    badgerBone.pivot = convertVector(node->LclTranslation.Get());
-    badgerBone.info.bindPoseRotation = convertVector(node->LclRotation.Get());
+    // Position of each skeleton node's bone in geometry.bones, so locators can find theirs.
+    std::vector<int> boneIndices(sceneTable.size(), -1);
 
-    if (auto parent = node->GetParent(); parent != nullptr) {
-        auto parentAttribute = parent->GetNodeAttribute();
-        if (parentAttribute != nullptr && parentAttribute->GetAttributeType() == FbxNodeAttribute::eSkeleton) {
-            badgerBone.parent = parent->GetName();
-        }
-    }
-
-    for (auto i = 0; i < node->GetChildCount(); i++) {
-        auto child = node->GetChild(i);
-        auto attribute = child->GetNodeAttribute();
-        if (attribute == nullptr || attribute->GetAttributeType() != FbxNodeAttribute::eNull)
+    for (size_t i = 0; i < sceneTable.size(); i++) {
+        const auto& entry = sceneTable[i];
+        if (entry.kind != NodeKind::Skeleton)
             continue;
 
-        FbxTransform::EInheritType inheritType;
-        child->GetTransformationInheritType(inheritType);
+        Log::verbose() << "Node: " << entry.name << " - exporting bone.";
 
-        Badger::BoneLocator locator {};
-        locator.discardScale = inheritType == FbxTransform::eInheritRrs;
-        locator.offset = convertVector(child->LclTranslation.Get());
-        locator.rotation = convertVector(child->LclRotation.Get());
-        badgerBone.locators.insert({child->GetName(), locator});
-    }
+        Badger::Bone badgerBone {};
+        badgerBone.name = entry.name;
 
-    geometry.bones.push_back(badgerBone);
+        badgerBone.scale = convertVector(entry.scaling);
+        badgerBone.pivot = convertVector(entry.translation);
+        badgerBone.info.bindPoseRotation = convertVector(entry.rotation);
 
-    // Now we iterate over the children a second time. Costs performance, but the exported bones are not reversed in their order anymore.
+        if (entry.parent >= 0 && sceneTable[entry.parent].kind == NodeKind::Skeleton)
+            badgerBone.parent = sceneTable[entry.parent].name;
 
-    for (auto i = 0; i < node->GetChildCount(); i++) {
-        auto child = node->GetChild(i);
-        auto attribute = child->GetNodeAttribute();
-        if (attribute == nullptr || attribute->GetAttributeType() != FbxNodeAttribute::eSkeleton)
+        boneIndices[i] = static_cast<int>(geometry.bones.size());
+        geometry.bones.push_back(badgerBone);
+    }
+
+    for (const auto& entry : sceneTable) {
+        if (entry.kind != NodeKind::Null || entry.parent < 0 || boneIndices[entry.parent] < 0)
             continue;
 
-        exportBone(geometry, FbxCast<FbxSkeleton>(attribute), child);
+        FbxTransform::EInheritType inheritType;
+        entry.node->GetTransformationInheritType(inheritType);
+
+        Badger::BoneLocator locator {};
+        locator.discardScale = inheritType == FbxTransform::eInheritRrs;
+        locator.offset = convertVector(entry.translation);
+        locator.rotation = convertVector(entry.rotation);
+        geometry.bones[boneIndices[entry.parent]].locators.insert({entry.name, locator});
     }
 
     return true;
@@ -486,20 +522,20 @@ bool BadgerConverter::exportAnimation(FbxAnimStack* stack) {
 
     auto result = stack->BakeLayers(scene->GetAnimationEvaluator(), stack->LocalStart.Get(), stack->LocalStop.Get(), animPeriodTime);
     if (!result) {
-        std::cerr << "Error while baking animation layers." << std::endl;
+        Log::error() << "Error while baking animation layers.";
         return false;
     }*/
 
     auto baseLayer = stack->GetMember<FbxAnimLayer>(0);
     if (baseLayer == nullptr) {
-        std::cerr << "Error: animation has no base layer!" << std::endl;
+        Log::error() << "Error: animation has no base layer!";
         return false;
     }
     
     for (auto i = 0; i < baseLayer->GetSrcObjectCount<FbxAnimCurveNode>(); i++) {
         auto curveNode = baseLayer->GetSrcObject<FbxAnimCurveNode>(i);
         if (curveNode->GetChannelsCount() != 3 && curveNode->GetDstPropertyCount() != 1) {
-            std::cerr << "Warning: unsupported curve node in animation." << std::endl;
+            Log::warning() << "Warning: unsupported curve node in animation.";
             continue;
         }
 
@@ -511,7 +547,7 @@ bool BadgerConverter::exportAnimation(FbxAnimStack* stack) {
         auto isScale = !isTranslation && !isRotation && propertyName == "Lcl Scaling";
 
         if (!isTranslation && !isRotation && !isScale) {
-            std::cerr << "Warning: unsupported connected curve property (" << propertyName << ") in animation. Only translation, rotation and scale is supported." << std::endl;
+            Log::warning() << "Warning: unsupported connected curve property (" << propertyName << ") in animation. Only translation, rotation and scale is supported.";
             continue;
         }
 
@@ -525,7 +561,7 @@ bool BadgerConverter::exportAnimation(FbxAnimStack* stack) {
         //std::cout << "def " << defaultValues[0] << " y " << defaultValues[1] << " z " << defaultValues[2] << std::endl;
 
         if (curveX == nullptr || curveY == nullptr || curveZ == nullptr) {
-            std::cerr << "Error: one or more required curve components are missing." << std::endl;
+            Log::error() << "Error: one or more required curve components are missing.";
             return false;
         }
 
@@ -536,8 +572,8 @@ bool BadgerConverter::exportAnimation(FbxAnimStack* stack) {
         auto zKeyCount = curveZ->KeyGetCount();
 
         if (xKeyCount != yKeyCount || zKeyCount != xKeyCount) {
-            std::cerr << "Error: key count mismatch between the x/y/z animation curves. (" << xKeyCount << "/" << yKeyCount << "/" << zKeyCount << ")" << std::endl;
-            std::cerr << "Hint: if you are exporting this model from blender, setting \"Simplify\" to 0.0 will fix this issue." << std::endl;
+            Log::error() << "Error: key count mismatch between the x/y/z animation curves. (" << xKeyCount << "/" << yKeyCount << "/" << zKeyCount << ")";
+            Log::warning() << "Hint: if you are exporting this model from blender, setting \"Simplify\" to 0.0 will fix this issue.";
             return false;
         }
 
@@ -1,24 +1,59 @@
 #pragma once
 
 #include "BadgerModel.hh"
+#include "MeshBuilder.hh"
+#include "Stopwatch.hh"
 
+#include <string>
 #include <vector>
 #include <fbxsdk.h>
 
 class BadgerConverter {
     public:
         explicit BadgerConverter();
-        //~BadgerConverter();
+        ~BadgerConverter();
 
         bool convertToBadger(const char* fbx, const char* outputFolder);
+        const PhaseTimings& getTimings() const { return timings; }
+
+        // Worker threads used to extract meshes, 0 uses one per hardware thread.
+        size_t threads = 0;
+        // Reads binary files with NativeFbxImporter, the FBX SDK is used when that fails.
+        bool nativeReader = false;
+        // Corners whose positions, normals, UVs, colors and weights differ by no more than this share a vertex, 0 welds
+        // exact matches only.
+        double weldTolerance = 1e-6;
+        // Applied to skinned meshes before their vertices are built.
+        InfluenceLimits influenceLimits;
     private:
-        bool exportMesh(Badger::Geometry& geometry, const FbxMesh* mesh, const FbxNode* node);
-        bool exportBone(Badger::Geometry& geometry, const FbxSkeleton* skeleton, const FbxNode* node);
+        enum class NodeKind { Other, Skeleton, Null, Mesh };
+
+        // One node of the flattened scene. The table is in pre-order, so parents come before their children.
+        // Name and local transform are read once while building the table.
+        struct SceneNode {
+            FbxNode* node;
+            // Index of the parent in the table, -1 for the root.
+            int parent;
+            NodeKind kind;
+            std::string name;
+            FbxDouble3 translation;
+            FbxDouble3 rotation;
+            FbxDouble3 scaling;
+        };
+
+        void resetScene();
+        void buildSceneTable();
+        bool exportBones(Badger::Geometry& geometry) const;
+        bool exportMeshes(Badger::Geometry& geometry, const std::vector<FbxNode*>& meshNodes);
+        // Node is the first node using the mesh, only used for messages. The material index is resolved per node.
+        bool exportMesh(Badger::Mesh& badgerMesh, int& materialIndex, const FbxMesh* mesh, const FbxNode* node) const;
         bool exportMaterial(const FbxSurfaceMaterial* material);
         bool exportAnimation(FbxAnimStack* stack);
         FbxManager* manager;
         FbxScene* scene;
+        std::vector<SceneNode> sceneTable;
         std::unordered_map<std::string, Badger::MetaMaterial> exportedMaterials;
         std::unordered_map<std::string, Badger::Animation> exportedAnimations;
         Badger::Model model;
+        PhaseTimings timings;
 };
\ No newline at end of file
@@ -4,37 +4,43 @@
 
 #include "BadgerModel.hh"
 
-using json = nlohmann::json;
+void from_json(const ArenaJson& j, Symbol& p) {
+    p = Symbol(j.get_ref<const std::string&>());
+}
+
+void to_json(ArenaJson& j, const Symbol& p) {
+    j = p.str();
+}
 
 namespace Badger {
 
     #pragma region Model Structs
 
-    [[maybe_unused]] void from_json(const nlohmann::json& j, BoneInfo& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, BoneInfo& p) {
         j.at("bind_pose_rotation").get_to(p.bindPoseRotation);
     }
 
-    [[maybe_unused]] void to_json(json& j, const BoneInfo& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const BoneInfo& p) {
+        j = ArenaJson {
             {"bind_pose_rotation", p.bindPoseRotation}
         };
     }
 
-    [[maybe_unused]] void from_json(const nlohmann::json& j, BoneLocator& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, BoneLocator& p) {
         j.at("discard_scale").get_to(p.discardScale);
         j.at("offset").get_to(p.offset);
         j.at("rotation").get_to(p.rotation);
     }
 
-    [[maybe_unused]] void to_json(json& j, const BoneLocator& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const BoneLocator& p) {
+        j = ArenaJson {
             {"discard_scale", p.discardScale},
             {"offset", p.offset},
             {"rotation", p.rotation}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, Bone& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Bone& p) {
         j.at("\x1\x2\x3\x4\x5__").get_to(p.info);
         if (j.contains("locators")) j.at("locators").get_to(p.locators);
         j.at("name").get_to(p.name);
@@ -43,8 +49,8 @@ namespace Badger {
         j.at("scale").get_to(p.scale);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Bone& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Bone& p) {
+        j = ArenaJson {
             {"\x1\x2\x3\x4\x5__", p.info},
             {"name", p.name},
             {"parent", p.parent},
@@ -56,7 +62,7 @@ namespace Badger {
             j["locators"] = p.locators;
     }
 
-    [[maybe_unused]] void from_json(const json& j, Mesh& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Mesh& p) {
         if (j.contains("indices")) j.at("indices").get_to(p.indices);
         if (j.contains("color_sets")) j.at("color_sets").get_to(p.colors);
         if (j.contains("model_name")) j.at("model_name").get_to(p.name);
@@ -68,8 +74,8 @@ namespace Badger {
         j.at("weights").get_to(p.weights);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Mesh& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Mesh& p) {
+        j = ArenaJson {
             {"meta_material", p.material},
             {"normal_sets", p.normals},
             {"positions", p.positions},
@@ -88,43 +94,43 @@ namespace Badger {
             j["indices"] = p.indices;
     }
 
-    [[maybe_unused]] void from_json(const json& j, GeometryDescription& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, GeometryDescription& p) {
         j.at("identifier").get_to(p.identifier);
     }
 
-    [[maybe_unused]] void to_json(json& j, const GeometryDescription& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const GeometryDescription& p) {
+        j = ArenaJson {
             {"identifier", p.identifier},
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, Geometry& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Geometry& p) {
         j.at("bones").get_to(p.bones);
         j.at("meshes").get_to(p.meshes);
         j.at("description").get_to(p.description);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Geometry& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Geometry& p) {
+        j = ArenaJson {
             {"bones", p.bones},
             {"meshes", p.meshes},
             {"description", p.description}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, Model& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Model& p) {
         j.at("format_version").get_to(p.formatVersion);
         j.at("minecraft:geometry").get_to(p.geometry);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Model& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Model& p) {
+        j = ArenaJson {
             {"format_version", p.formatVersion},
             {"minecraft:geometry", p.geometry}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, MetaMaterialTextures& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, MetaMaterialTextures& p) {
         if (j.contains("diffuseMap")) j.at("diffuseMap").get_to(p.diffuse);
         else p.diffuse = std::string();
 
@@ -138,8 +144,8 @@ namespace Badger {
         else p.normal = std::string();
     }
 
-    [[maybe_unused]] void to_json(json& j, const MetaMaterialTextures& p) {
-        j = json {};
+    [[maybe_unused]] void to_json(ArenaJson& j, const MetaMaterialTextures& p) {
+        j = ArenaJson {};
         if (!p.diffuse.empty())
             j["diffuseMap"] = p.diffuse;
         if (!p.coeff.empty())
@@ -150,14 +156,14 @@ namespace Badger {
             j["normalMap"] = p.normal;
     }
 
-    [[maybe_unused]] void from_json(const json& j, MetaMaterialInfo& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, MetaMaterialInfo& p) {
         if (j.contains("material")) j.at("material").get_to(p.material);
         if (j.contains("culling")) j.at("culling").get_to(p.culling);
         j.at("textures").get_to(p.textures);
     }
 
-    [[maybe_unused]] void to_json(json& j, const MetaMaterialInfo& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const MetaMaterialInfo& p) {
+        j = ArenaJson {
             {"textures", p.textures}
         };
 
@@ -167,7 +173,7 @@ namespace Badger {
             j["culling"] = p.culling;
     }
 
-    [[maybe_unused]] void from_json(const json& j, MetaMaterial& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, MetaMaterial& p) {
         j.at("format_version").get_to(p.formatVersion);
         for (auto it = ++j.begin(); it != j.end(); ++it) {
             const auto& matName = it.key();
@@ -182,8 +188,8 @@ namespace Badger {
         }
     }
 
-    [[maybe_unused]] void to_json(json& j, const MetaMaterial& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const MetaMaterial& p) {
+        j = ArenaJson {
             {"format_version", p.formatVersion}
         };
 
@@ -194,29 +200,29 @@ namespace Badger {
     #pragma endregion
     #pragma region Entity Structs
 
-    [[maybe_unused]] void from_json(const json& j, Entity& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Entity& p) {
         j.at("format_version").get_to(p.formatVersion);
         j.at("minecraft:client_entity").get_to(p.info);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Entity& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Entity& p) {
+        j = ArenaJson {
             {"format_version", p.formatVersion},
             {"minecraft:client_entity", p.info}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, EntityInfo& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, EntityInfo& p) {
         j.at("components").get_to(p.components);
     }
 
-    [[maybe_unused]] void to_json(json& j, const EntityInfo& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const EntityInfo& p) {
+        j = ArenaJson {
             {"components", p.components}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, EntityComponents& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, EntityComponents& p) {
         if (j.contains("badger:face_animation")) 
             p.faceAnimation = j.at("badger:face_animation").get<Badger::FaceAnimation>();
         if (j.contains("badger:template")) {
@@ -229,8 +235,8 @@ namespace Badger {
         }
     }
 
-    [[maybe_unused]] void to_json(json& j, const EntityComponents& p) {
-        j = json {};
+    [[maybe_unused]] void to_json(ArenaJson& j, const EntityComponents& p) {
+        j = ArenaJson {};
         if (p.faceAnimation)
             j["badger:face_animation"] = p.faceAnimation.value();
 
@@ -242,15 +248,15 @@ namespace Badger {
         }
     }
 
-    [[maybe_unused]] void from_json(const json& j, FaceAnimation& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, FaceAnimation& p) {
         j.at("anim_columns").get_to(p.colums);
         j.at("anim_rows").get_to(p.rows);
         j.at("blink_frame").get_to(p.blinkFrame);
         j.at("default_frame").get_to(p.defaultFrame);
     }
 
-    [[maybe_unused]] void to_json(json& j, const FaceAnimation& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const FaceAnimation& p) {
+        j = ArenaJson {
             {"anim_columns", p.colums},
             {"anim_rows", p.rows},
             {"blink_frame", p.blinkFrame},
@@ -266,36 +272,41 @@ namespace Badger {
     #pragma endregion
     #pragma region Animation Structs
 
-    [[maybe_unused]] void from_json(const json& j, Animations& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Animations& p) {
         j.at("format_version").get_to(p.formatVersion);
         j.at("animations").get_to(p.animations);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Animations& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Animations& p) {
+        j = ArenaJson {
             {"format_version", p.formatVersion},
             {"animations", p.animations}
         };
     }
 
-    [[maybe_unused]] void from_json(const json& j, Animation& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, Animation& p) {
         j.at("anim_time_update").get_to(p.animTimeUpdate);
         j.at("blend_weight").get_to(p.blendWeight);
-        j.at("bones").get_to(p.bones);
+        for (const auto& bone : j.at("bones").items())
+            bone.value().get_to(p.bones[Symbol(bone.key())]);
     }
 
-    [[maybe_unused]] void to_json(json& j, const Animation& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const Animation& p) {
+        j = ArenaJson {
             {"anim_time_update", p.animTimeUpdate},
             {"blend_weight", p.blendWeight},
-            {"bones", p.bones}
+            {"bones", ArenaJson::object()}
         };
+
+        auto& bones = j["bones"];
+        for (const auto& [name, bone] : p.bones)
+            bones[name.str()] = bone;
     }
 
-    [[maybe_unused]] void from_json(const json& j, AnimationBone& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, AnimationBone& p) {
         j.at("lod_distance").get_to(p.lodDistance);
 
-        auto parseProperties = [&](const json& node, std::unordered_map<double, AnimationProperty>& properties) {
+        auto parseProperties = [&](const ArenaJson& node, std::unordered_map<double, AnimationProperty>& properties) {
             for (const auto& val : node.items()) {
                 if (val.key() == "lod_distance")
                     break;
@@ -331,12 +342,12 @@ namespace Badger {
         }
     }
 
-    [[maybe_unused]] void to_json(json& j, const AnimationBone& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const AnimationBone& p) {
+        j = ArenaJson {
             {"lod_distance", p.lodDistance}
         };
 
-        auto writeProperties = [&](const std::unordered_map<double, AnimationProperty>& properties, json& node) {
+        auto writeProperties = [&](const std::unordered_map<double, AnimationProperty>& properties, ArenaJson& node) {
             for (const auto& keyframe : properties) {
                 auto key = std::to_string(keyframe.first);
 
@@ -350,31 +361,31 @@ namespace Badger {
         };
 
         if (!p.position.empty()) {
-            json val {};
+            ArenaJson val {};
             writeProperties(p.position, val);
             j["position"] = val;
         }
 
         if (!p.rotation.empty()) {
-            json val {};
+            ArenaJson val {};
             writeProperties(p.rotation, val);
             j["rotation"] = val;
         }
 
         if (!p.scale.empty()) {
-            json val {};
+            ArenaJson val {};
             writeProperties(p.scale, val);
             j["scale"] = val;
         }
     }
 
-    [[maybe_unused]] void from_json(const json& j, AnimationProperty& p) {
+    [[maybe_unused]] void from_json(const ArenaJson& j, AnimationProperty& p) {
         j.at("lerp_mode").get_to(p.lerpMode);
         j.at("post").get_to(p.post);
     }
 
-    [[maybe_unused]] void to_json(json& j, const AnimationProperty& p) {
-        j = json {
+    [[maybe_unused]] void to_json(ArenaJson& j, const AnimationProperty& p) {
+        j = ArenaJson {
             {"lerp_mode", p.lerpMode},
             {"post", p.post}
         };
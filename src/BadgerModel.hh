@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <map>
 #include <string>
 #include <vector>
 #include <variant>
@@ -7,8 +9,19 @@
 
 #include <nlohmann/json.hpp>
 
+#include "Arena.hh"
+#include "Symbol.hh"
+
 using json = nlohmann::json;
 
+// Same as nlohmann::json, but nodes come from the current ArenaScope while one is active. Only resource files
+// parsed into the Badger model types use it, everything else stays on plain json.
+using ArenaJson = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t, std::uint64_t, double, ArenaAllocator>;
+
+// Symbols are plain strings in JSON.
+void from_json(const ArenaJson& j, Symbol& p);
+void to_json(ArenaJson& j, const Symbol& p);
+
 namespace Badger {
     typedef std::vector<double> Color;
     typedef std::vector<double> Vector3f;
@@ -29,8 +42,8 @@ namespace Badger {
     struct Bone {
         BoneInfo info;
         std::unordered_map<std::string, BoneLocator> locators;
-        std::string name;
-        std::string parent;
+        Symbol name;
+        Symbol parent;
         Vector3f pivot;
         Vector3f scale;
     };
@@ -38,14 +51,14 @@ namespace Badger {
     struct Mesh {
         // General info
         std::string name;
-        std::string material;
+        Symbol material;
 
         // Vertex info
         std::vector<Vector3f> positions;
         std::vector<int> triangles;
 
         // Bone info
-        std::vector<std::vector<std::string>> indices;
+        std::vector<std::vector<Symbol>> indices;
         std::vector<std::vector<double>> weights;
 
         // Normal info
@@ -90,32 +103,32 @@ namespace Badger {
     };
 
 
-    void from_json(const json& j, BoneInfo& p);
-    void to_json(json& j, const BoneInfo& p);
+    void from_json(const ArenaJson& j, BoneInfo& p);
+    void to_json(ArenaJson& j, const BoneInfo& p);
 
-    void from_json(const json& j, Bone& p);
-    void to_json(json& j, const Bone& p);
+    void from_json(const ArenaJson& j, Bone& p);
+    void to_json(ArenaJson& j, const Bone& p);
     
-    void from_json(const json& j, Mesh& p);
-    void to_json(json& j, const Mesh& p);
+    void from_json(const ArenaJson& j, Mesh& p);
+    void to_json(ArenaJson& j, const Mesh& p);
     
-    void from_json(const json& j, GeometryDescription& p);
-    void to_json(json& j, const GeometryDescription& p);
+    void from_json(const ArenaJson& j, GeometryDescription& p);
+    void to_json(ArenaJson& j, const GeometryDescription& p);
     
-    void from_json(const json& j, Geometry& p);
-    void to_json(json& j, const Geometry& p);
+    void from_json(const ArenaJson& j, Geometry& p);
+    void to_json(ArenaJson& j, const Geometry& p);
     
-    void from_json(const json& j, Model& p);
-    void to_json(json& j, const Model& p);
+    void from_json(const ArenaJson& j, Model& p);
+    void to_json(ArenaJson& j, const Model& p);
 
-    void from_json(const json& j, MetaMaterialTextures& p);
-    void to_json(json& j, const MetaMaterialTextures& p);
+    void from_json(const ArenaJson& j, MetaMaterialTextures& p);
+    void to_json(ArenaJson& j, const MetaMaterialTextures& p);
 
-    void from_json(const json& j, MetaMaterialInfo& p);
-    void to_json(json& j, const MetaMaterialInfo& p);
+    void from_json(const ArenaJson& j, MetaMaterialInfo& p);
+    void to_json(ArenaJson& j, const MetaMaterialInfo& p);
 
-    void from_json(const json& j, MetaMaterial& p);
-    void to_json(json& j, const MetaMaterial& p);
+    void from_json(const ArenaJson& j, MetaMaterial& p);
+    void to_json(ArenaJson& j, const MetaMaterial& p);
 
     #pragma endregion
     #pragma region Entity Structs
@@ -142,17 +155,17 @@ namespace Badger {
         void applyTemplate(const Entity& templateEntity);
     };
 
-    void from_json(const json& j, Entity& p);
-    void to_json(json& j, const Entity& p);
+    void from_json(const ArenaJson& j, Entity& p);
+    void to_json(ArenaJson& j, const Entity& p);
 
-    void from_json(const json& j, EntityInfo& p);
-    void to_json(json& j, const EntityInfo& p);
+    void from_json(const ArenaJson& j, EntityInfo& p);
+    void to_json(ArenaJson& j, const EntityInfo& p);
 
-    void from_json(const json& j, EntityComponents& p);
-    void to_json(json& j, const EntityComponents& p);
+    void from_json(const ArenaJson& j, EntityComponents& p);
+    void to_json(ArenaJson& j, const EntityComponents& p);
 
-    void from_json(const json& j, FaceAnimation& p);
-    void to_json(json& j, const FaceAnimation& p);
+    void from_json(const ArenaJson& j, FaceAnimation& p);
+    void to_json(ArenaJson& j, const FaceAnimation& p);
 
     #pragma endregion
     #pragma region Animation Structs
@@ -172,7 +185,7 @@ namespace Badger {
     struct Animation {
         std::string animTimeUpdate;
         std::string blendWeight;
-        std::unordered_map<std::string, AnimationBone> bones;
+        std::unordered_map<Symbol, AnimationBone> bones;
     };
 
     struct Animations {
@@ -180,17 +193,17 @@ namespace Badger {
         std::unordered_map<std::string, Animation> animations;
     };
 
-    void from_json(const json& j, Animations& p);
-    void to_json(json& j, const Animations& p);
+    void from_json(const ArenaJson& j, Animations& p);
+    void to_json(ArenaJson& j, const Animations& p);
 
-    void from_json(const json& j, Animation& p);
-    void to_json(json& j, const Animation& p);
+    void from_json(const ArenaJson& j, Animation& p);
+    void to_json(ArenaJson& j, const Animation& p);
 
-    void from_json(const json& j, AnimationBone& p);
-    void to_json(json& j, const AnimationBone& p);
+    void from_json(const ArenaJson& j, AnimationBone& p);
+    void to_json(ArenaJson& j, const AnimationBone& p);
 
-    void from_json(const json& j, AnimationProperty& p);
-    void to_json(json& j, const AnimationProperty& p);
+    void from_json(const ArenaJson& j, AnimationProperty& p);
+    void to_json(ArenaJson& j, const AnimationProperty& p);
 
     #pragma endregion
 }
\ No newline at end of file
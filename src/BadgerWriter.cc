@@ -0,0 +1,91 @@
+#include "BadgerWriter.hh"
+#include "Log.hh"
+
+#include <fstream>
+
+bool writeBadgerPack(const std::filesystem::path& outputDirectory, const std::string& name, const Badger::Model& model,
+    std::unordered_map<std::string, Badger::MetaMaterial>& materials, const std::unordered_map<std::string, Badger::Animation>& animations) {
+    Log::info() << "Creating model JSON.";
+
+    std::filesystem::create_directories(outputDirectory);
+
+    auto modelOutput = outputDirectory / "models" / "entity";
+    std::filesystem::create_directories(modelOutput);
+    modelOutput /= (name + ".model.json");
+
+    std::ofstream modelOutputStream(modelOutput, std::ios::out);
+
+    ArenaJson modelJson(model);
+    modelOutputStream << modelJson;
+    modelOutputStream.close();
+
+    if (!modelOutputStream) {
+        Log::error() << "Error: failed to write " << modelOutput.string() << ".";
+        return false;
+    }
+
+    // TODO
+    Log::info() << "Creating material JSONs.";
+
+    auto materialDir = outputDirectory / "materials";
+    std::filesystem::create_directories(materialDir);
+
+    auto textureDir = outputDirectory / "textures" / "entity";
+    std::filesystem::create_directories(textureDir);
+
+    auto copyAndRedirectTexture = [&](std::string& path) {
+        std::filesystem::path originalTexPath(path);
+        std::filesystem::path newTexPath(textureDir);
+        newTexPath /= originalTexPath.filename();
+
+        // Importers may already have extracted embedded textures into place.
+        std::error_code error;
+        if (!std::filesystem::equivalent(originalTexPath, newTexPath, error)) {
+            if (std::filesystem::exists(newTexPath))
+                std::filesystem::remove(newTexPath);
+
+            std::filesystem::copy(originalTexPath, newTexPath);
+        }
+
+        path = "textures/entity/" + originalTexPath.stem().string();
+    };
+
+    std::ofstream materialOutputStream;
+    for (auto& pair : materials) {
+        if (!pair.second.info.textures.diffuse.empty())
+            copyAndRedirectTexture(pair.second.info.textures.diffuse);
+        if (!pair.second.info.textures.coeff.empty())
+            copyAndRedirectTexture(pair.second.info.textures.coeff);
+        if (!pair.second.info.textures.normal.empty())
+            copyAndRedirectTexture(pair.second.info.textures.normal);
+        if (!pair.second.info.textures.emissive.empty())
+            copyAndRedirectTexture(pair.second.info.textures.emissive);
+
+        auto materialOutputPath = materialDir / (pair.second.name + ".json");
+        ArenaJson materialJson(pair.second);
+        materialOutputStream.open(materialOutputPath);
+        materialOutputStream << materialJson;
+        materialOutputStream.close();
+    }
+
+    if (!animations.empty()) {
+        Log::info() << "Creating animation JSON.";
+
+        Badger::Animations badgerAnimations {
+            .formatVersion = "1.8.0",
+            .animations = animations
+        };
+
+        auto animationsPath = outputDirectory / "animations";
+        std::filesystem::create_directories(animationsPath);
+
+        animationsPath /= (name + ".animations.json");
+
+        std::ofstream animationsOutputStream(animationsPath, std::ios::out);
+        ArenaJson animationsJson(badgerAnimations);
+        animationsOutputStream << animationsJson;
+        animationsOutputStream.close();
+    }
+
+    return true;
+}
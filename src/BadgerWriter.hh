@@ -0,0 +1,12 @@
+#pragma once
+
+#include "BadgerModel.hh"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+// Writes an imported model, its materials and animations in the resource pack layout, shared by all importers.
+// Textures are copied to textures/entity and the material paths are redirected there.
+bool writeBadgerPack(const std::filesystem::path& outputDirectory, const std::string& name, const Badger::Model& model,
+    std::unordered_map<std::string, Badger::MetaMaterial>& materials, const std::unordered_map<std::string, Badger::Animation>& animations);
@@ -0,0 +1,95 @@
+#include "Batch.hh"
+#include "FbxConverter.hh"
+#include "Log.hh"
+#include "Parallel.hh"
+#include "ResourceLoader.hh"
+#include "Stopwatch.hh"
+#include "Version.hh"
+
+#include <atomic>
+
+BatchRunner::BatchRunner(const char* resourcePacksDir, const std::filesystem::path& outputDirectory) :
+    resourcePacksDir(resourcePacksDir),
+    outputDirectory(outputDirectory) {
+
+}
+
+void BatchRunner::useCache(const std::filesystem::path& manifestPath) {
+    cache.emplace(manifestPath);
+}
+
+std::string BatchRunner::configuration() const {
+    // Anything that changes the output of a job without changing its inputs belongs here.
+    return std::string("version=") + FBX_CONVERTER_VERSION + ";format=fbx;writer=" + (nativeWriter ? "native" : "sdk")
+        + ";packs=" + ResourceLoader::normalizePath(resourcePacksDir);
+}
+
+BatchRunner::JobResult BatchRunner::runJob(const std::string& model) {
+    auto output = outputDirectory / (model + ".fbx");
+    auto config = configuration();
+
+    if (cache && cache->isUpToDate(model, config, output)) {
+        Log::verbose() << "Skipping " << model << ", its inputs are unchanged.";
+        return JobResult::Skipped;
+    }
+
+    Stopwatch stopwatch;
+    ResourceLoader loader(resourcePacksDir.c_str());
+
+    // Inputs are hashed before the conversion reads them and checked again once it finished. Finding them parses the
+    // resources, so the parsed copies are dropped and the conversion reads the files after they were hashed.
+    BuildCache::Snapshot inputs;
+    if (cache) {
+        inputs = cache->snapshot(loader.getDependencies(model));
+        loader.clearCache();
+    }
+
+    FbxConverter converter(loader);
+    converter.nativeWriter = nativeWriter;
+    if (!converter.convertToFbx(model.c_str(), output.string().c_str())) {
+        Log::error() << "Error: failed to convert model " << model << ".";
+        return JobResult::Failed;
+    }
+
+    if (cache)
+        cache->record(model, config, inputs, loader.getDependencies(model), output);
+
+    Log::info() << "Converted " << model << " in " << stopwatch.elapsedMilliseconds() << " ms.";
+    return JobResult::Converted;
+}
+
+BatchResult BatchRunner::run(const std::vector<std::string>& models, size_t jobs) {
+    std::filesystem::create_directories(outputDirectory);
+
+    if (cache && !cache->load())
+        cache.reset();
+
+    std::atomic<size_t> converted = 0;
+    std::atomic<size_t> skipped = 0;
+    std::atomic<size_t> failed = 0;
+
+    parallelFor(models.size(), jobs, [&](size_t i) {
+        switch (runJob(models[i])) {
+            case JobResult::Converted:
+                converted++;
+                break;
+            case JobResult::Skipped:
+                skipped++;
+                break;
+            case JobResult::Failed:
+                failed++;
+                break;
+        }
+    });
+
+    if (cache) {
+        cache->save();
+        Log::info() << "Build cache: " << cache->getHits() << " hit(s), " << cache->getMisses() << " miss(es).";
+    }
+
+    return BatchResult {
+        .converted = converted,
+        .skipped = skipped,
+        .failed = failed
+    };
+}
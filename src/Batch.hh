@@ -0,0 +1,37 @@
+#pragma once
+
+#include "BuildCache.hh"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct BatchResult {
+    size_t converted = 0;
+    size_t skipped = 0;
+    size_t failed = 0;
+};
+
+// Exports many models to a folder. With a build cache, models whose inputs and
+// configuration are unchanged since the last run keep their previous output.
+class BatchRunner {
+    public:
+        BatchRunner(const char* resourcePacksDir, const std::filesystem::path& outputDirectory);
+
+        void useCache(const std::filesystem::path& manifestPath);
+        BatchResult run(const std::vector<std::string>& models, size_t jobs);
+
+        // Writes the files with NativeFbxExporter instead of the FBX SDK.
+        bool nativeWriter = false;
+
+    private:
+        enum class JobResult { Converted, Skipped, Failed };
+
+        JobResult runJob(const std::string& model);
+        std::string configuration() const;
+
+        std::string resourcePacksDir;
+        std::filesystem::path outputDirectory;
+        std::optional<BuildCache> cache;
+};
@@ -0,0 +1,345 @@
+#include "BuildCache.hh"
+#include "BadgerModel.hh"
+#include "Log.hh"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace {
+    constexpr int MANIFEST_VERSION = 1;
+
+    // Coarsest modification time resolution of the file systems in use (FAT has 2 seconds). A file written this close
+    // to when its state was recorded can change again without changing its modification time.
+    constexpr auto TIMESTAMP_GRANULARITY = std::chrono::seconds(2);
+
+    constexpr uint64_t PRIME1 = 11400714785074694791ULL;
+    constexpr uint64_t PRIME2 = 14029467366897019727ULL;
+    constexpr uint64_t PRIME3 = 1609587929392839161ULL;
+    constexpr uint64_t PRIME4 = 9650029242287828579ULL;
+    constexpr uint64_t PRIME5 = 2870177450012600261ULL;
+
+    uint64_t rotateLeft(uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    uint64_t read64(const unsigned char* data) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t read32(const unsigned char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t round(uint64_t accumulator, uint64_t input) {
+        accumulator += input * PRIME2;
+        accumulator = rotateLeft(accumulator, 31);
+        return accumulator * PRIME1;
+    }
+
+    uint64_t mergeRound(uint64_t accumulator, uint64_t value) {
+        accumulator ^= round(0, value);
+        return accumulator * PRIME1 + PRIME4;
+    }
+
+    // XXH64, fast enough that hashing inputs costs far less than converting them.
+    uint64_t hashBytes(const unsigned char* data, size_t length, uint64_t seed = 0) {
+        auto end = data + length;
+        uint64_t hash;
+
+        if (length >= 32) {
+            auto v1 = seed + PRIME1 + PRIME2;
+            auto v2 = seed + PRIME2;
+            auto v3 = seed;
+            auto v4 = seed - PRIME1;
+
+            for (; data + 32 <= end; data += 32) {
+                v1 = round(v1, read64(data));
+                v2 = round(v2, read64(data + 8));
+                v3 = round(v3, read64(data + 16));
+                v4 = round(v4, read64(data + 24));
+            }
+
+            hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+            hash = mergeRound(hash, v1);
+            hash = mergeRound(hash, v2);
+            hash = mergeRound(hash, v3);
+            hash = mergeRound(hash, v4);
+        } else {
+            hash = seed + PRIME5;
+        }
+
+        hash += length;
+
+        for (; data + 8 <= end; data += 8) {
+            hash ^= round(0, read64(data));
+            hash = rotateLeft(hash, 27) * PRIME1 + PRIME4;
+        }
+
+        if (data + 4 <= end) {
+            hash ^= static_cast<uint64_t>(read32(data)) * PRIME1;
+            hash = rotateLeft(hash, 23) * PRIME2 + PRIME3;
+            data += 4;
+        }
+
+        for (; data < end; data++) {
+            hash ^= *data * PRIME5;
+            hash = rotateLeft(hash, 11) * PRIME1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= PRIME2;
+        hash ^= hash >> 29;
+        hash *= PRIME3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    uint64_t hashString(const std::string& value) {
+        return hashBytes(reinterpret_cast<const unsigned char*>(value.data()), value.size());
+    }
+
+    std::string toHex(uint64_t value) {
+        std::ostringstream stream;
+        stream << std::hex << value;
+        return stream.str();
+    }
+
+    uint64_t fromHex(const std::string& value) {
+        return std::stoull(value, nullptr, 16);
+    }
+}
+
+BuildCache::BuildCache(const std::filesystem::path& manifestPath) : manifestPath(manifestPath), hits(0), misses(0) {
+
+}
+
+bool BuildCache::readState(const std::string& path, FileState& state) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    if (error)
+        return false;
+
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (error)
+        return false;
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    std::vector<unsigned char> contents(size);
+    if (!file.read(reinterpret_cast<char*>(contents.data()), static_cast<std::streamsize>(size)))
+        return false;
+
+    state.hash = hashBytes(contents.data(), contents.size());
+    state.size = size;
+    state.modified = modified.time_since_epoch().count();
+    return true;
+}
+
+bool BuildCache::matches(const std::string& path, const FileState& recorded, int64_t recordedAt) {
+    std::error_code error;
+    if (!recorded.exists)
+        return std::filesystem::status(path, error).type() == std::filesystem::file_type::not_found;
+
+    auto size = std::filesystem::file_size(path, error);
+    if (error || size != recorded.size)
+        return false;
+
+    // Unchanged size and modification time are trusted unless the file was modified shortly before it was recorded,
+    // anything else is decided by the content hash.
+    auto granularity = std::chrono::duration_cast<std::filesystem::file_time_type::duration>(TIMESTAMP_GRANULARITY).count();
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (!error && modified.time_since_epoch().count() == recorded.modified && recorded.modified < recordedAt - granularity)
+        return true;
+
+    FileState current;
+    return readState(path, current) && current.hash == recorded.hash;
+}
+
+bool BuildCache::load() {
+    if (!std::filesystem::exists(manifestPath))
+        return true;
+
+    std::ifstream file(manifestPath);
+    if (!file) {
+        Log::error() << "Error: could not open build manifest at path " << manifestPath << ".";
+        return false;
+    }
+
+    try {
+        auto manifest = json::parse(file);
+        if (manifest.at("version").get<int>() != MANIFEST_VERSION) {
+            Log::warning() << "Warning: build manifest has an unsupported version, ignoring it.";
+            return true;
+        }
+
+        auto readFileState = [](const json& j) {
+            return FileState {
+                .exists = j.value("exists", true),
+                .hash = fromHex(j.at("hash").get<std::string>()),
+                .size = j.at("size").get<uint64_t>(),
+                .modified = j.at("modified").get<int64_t>()
+            };
+        };
+
+        for (const auto& job : manifest.at("jobs").items()) {
+            Entry entry;
+            entry.configuration = fromHex(job.value().at("configuration").get<std::string>());
+            entry.output = job.value().at("output").get<std::string>();
+            entry.outputState = readFileState(job.value().at("output_state"));
+            entry.recorded = job.value().value("recorded", int64_t(0));
+            for (const auto& input : job.value().at("inputs").items())
+                entry.inputs.insert({input.key(), readFileState(input.value())});
+
+            entries.insert({job.key(), entry});
+        }
+    } catch (const std::exception& e) {
+        Log::warning() << "Warning: failed to parse build manifest (" << e.what() << "), rebuilding everything.";
+        entries.clear();
+    }
+
+    return true;
+}
+
+bool BuildCache::save() {
+    auto writeFileState = [](const FileState& state) {
+        return json {
+            {"exists", state.exists},
+            {"hash", toHex(state.hash)},
+            {"size", state.size},
+            {"modified", state.modified}
+        };
+    };
+
+    json jobs = json::object();
+    {
+        std::lock_guard lock(mutex);
+        for (const auto& entry : entries) {
+            json inputs = json::object();
+            for (const auto& input : entry.second.inputs)
+                inputs[input.first] = writeFileState(input.second);
+
+            jobs[entry.first] = json {
+                {"configuration", toHex(entry.second.configuration)},
+                {"output", entry.second.output},
+                {"output_state", writeFileState(entry.second.outputState)},
+                {"recorded", entry.second.recorded},
+                {"inputs", inputs}
+            };
+        }
+    }
+
+    json manifest {
+        {"version", MANIFEST_VERSION},
+        {"jobs", jobs}
+    };
+
+    if (manifestPath.has_parent_path())
+        std::filesystem::create_directories(manifestPath.parent_path());
+
+    // Written to a temporary file first so an interrupted run never leaves a truncated manifest.
+    auto temporaryPath = manifestPath;
+    temporaryPath += ".tmp";
+
+    std::ofstream file(temporaryPath, std::ios::out);
+    file << manifest.dump(1);
+    file.close();
+    if (!file) {
+        Log::error() << "Error: could not write build manifest to " << temporaryPath << ".";
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, manifestPath, error);
+    if (error) {
+        Log::error() << "Error: could not replace build manifest " << manifestPath << " (" << error.message() << ").";
+        return false;
+    }
+
+    return true;
+}
+
+bool BuildCache::isUpToDate(const std::string& job, const std::string& configuration, const std::filesystem::path& output) {
+    Entry entry;
+    auto found = false;
+    {
+        std::lock_guard lock(mutex);
+        if (auto it = entries.find(job); it != entries.end()) {
+            entry = it->second;
+            found = true;
+        }
+    }
+
+    auto upToDate = found
+        && entry.configuration == hashString(configuration)
+        && entry.output == output.string()
+        && matches(entry.output, entry.outputState, entry.recorded);
+
+    for (auto it = entry.inputs.begin(); upToDate && it != entry.inputs.end(); ++it)
+        upToDate = matches(it->first, it->second, entry.recorded);
+
+    std::lock_guard lock(mutex);
+    if (upToDate)
+        hits++;
+    else
+        misses++;
+
+    return upToDate;
+}
+
+BuildCache::Snapshot BuildCache::snapshot(const std::vector<std::string>& inputs) {
+    Snapshot snapshot;
+    // Taken before any state is read, so a file written during the reads counts as recent.
+    snapshot.taken = std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+
+    for (const auto& input : inputs) {
+        FileState state;
+        std::error_code error;
+        if (std::filesystem::status(input, error).type() == std::filesystem::file_type::not_found) {
+            state.exists = false;
+        } else if (!readState(input, state)) {
+            Log::warning() << "Warning: could not read input " << input << ".";
+            snapshot.complete = false;
+        }
+        snapshot.inputs.insert({input, state});
+    }
+
+    return snapshot;
+}
+
+void BuildCache::record(const std::string& job, const std::string& configuration, const Snapshot& before, const std::vector<std::string>& inputs, const std::filesystem::path& output) {
+    if (!before.complete) {
+        Log::warning() << "Warning: not all inputs of job " << job << " could be read, it will not be cached.";
+        return;
+    }
+
+    Entry entry;
+    entry.configuration = hashString(configuration);
+    entry.output = output.string();
+    entry.recorded = std::filesystem::file_time_type::clock::now().time_since_epoch().count();
+
+    if (!readState(entry.output, entry.outputState)) {
+        Log::warning() << "Warning: could not read output " << output << " of job " << job << ", it will not be cached.";
+        return;
+    }
+
+    // The job read its inputs after the snapshot, if they still match it they are what the output was built from.
+    for (const auto& input : inputs) {
+        auto state = before.inputs.find(input);
+        if (state == before.inputs.end() || !matches(input, state->second, before.taken)) {
+            Log::warning() << "Warning: input " << input << " of job " << job << " changed while it ran, it will not be cached.";
+            return;
+        }
+        entry.inputs.insert(*state);
+    }
+
+    std::lock_guard lock(mutex);
+    entries.insert_or_assign(job, entry);
+}
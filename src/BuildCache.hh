@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Persistent manifest of finished conversion jobs. A job is up to date when the tool
+// configuration, the content hash of every input it read, the absence of every input it
+// looked for but did not find and its output are unchanged.
+class BuildCache {
+    public:
+        struct FileState {
+            // Inputs can be paths a file was looked up at without being found, adding the file changes the result.
+            bool exists = true;
+            uint64_t hash = 0;
+            uint64_t size = 0;
+            int64_t modified = 0;
+        };
+
+        // States of a job's inputs, taken before the job reads them.
+        struct Snapshot {
+            std::unordered_map<std::string, FileState> inputs;
+            // File clock time the states were read at.
+            int64_t taken = 0;
+            // False if an input could not be read, the job is not cached then.
+            bool complete = true;
+        };
+
+        explicit BuildCache(const std::filesystem::path& manifestPath);
+
+        bool load();
+        bool save();
+
+        bool isUpToDate(const std::string& job, const std::string& configuration, const std::filesystem::path& output);
+        Snapshot snapshot(const std::vector<std::string>& inputs);
+        // Records the job with the input states of the snapshot. Inputs are the files the job actually depended on,
+        // the job is not recorded if one of them is missing from the snapshot or changed since it was taken.
+        void record(const std::string& job, const std::string& configuration, const Snapshot& before, const std::vector<std::string>& inputs, const std::filesystem::path& output);
+
+        size_t getHits() const { return hits; }
+        size_t getMisses() const { return misses; }
+
+    private:
+        struct Entry {
+            uint64_t configuration = 0;
+            std::unordered_map<std::string, FileState> inputs;
+            std::string output;
+            FileState outputState;
+            // File clock time the states were read at.
+            int64_t recorded = 0;
+        };
+
+        bool matches(const std::string& path, const FileState& recorded, int64_t recordedAt);
+        static bool readState(const std::string& path, FileState& state);
+
+        std::filesystem::path manifestPath;
+        std::unordered_map<std::string, Entry> entries;
+        std::mutex mutex;
+        size_t hits;
+        size_t misses;
+};
@@ -1,89 +1,156 @@
 #include "FbxConverter.hh"
+#include "AnimationSampler.hh"
 #include "BadgerModel.hh"
+#include "Log.hh"
+#include "NativeFbxExporter.hh"
+#include "Parallel.hh"
+#include "Shadergraph.hh"
+#include "Stopwatch.hh"
 
-#include <iostream>
-
-#include <brotli/decode.h>
+#include <algorithm>
+#include <vector>
 
 #define BINARY
 
-FbxConverter::FbxConverter(const char* resourcePacksDir) {
+namespace {
+    FbxAMatrix toFbxMatrix(const Matrix4& matrix) {
+        FbxAMatrix result;
+        const auto& m = matrix.values;
+        for (auto row = 0; row < 4; row++)
+            result.SetRow(row, FbxVector4(m[row * 4], m[row * 4 + 1], m[row * 4 + 2], m[row * 4 + 3]));
+        return result;
+    }
+}
+
+FbxConverter::FbxConverter(const char* resourcePacksDir) : FbxConverter(new ResourceLoader(resourcePacksDir), true) {
+
+}
+
+FbxConverter::FbxConverter(ResourceLoader& loader) : FbxConverter(&loader, false) {
+
+}
+
+FbxConverter::FbxConverter(ResourceLoader* loader, bool ownsLoader) : loader(loader), ownsLoader(ownsLoader) {
     manager = FbxManager::Create();
     auto ioSettings = FbxIOSettings::Create(manager, IOSROOT);
 #ifdef BINARY
     ioSettings->SetBoolProp(EXP_FBX_EMBEDDED, true);
 #endif
     manager->SetIOSettings(ioSettings);
-    loader = new ResourceLoader(resourcePacksDir);
     pbShaderImplementation = nullptr;
     scene = nullptr;
 }
 
 FbxConverter::~FbxConverter() {
+    resetScene();
+    
+    if (manager != nullptr)
+        manager->Destroy();
+
+    if (ownsLoader)
+        delete loader;
+}
+
+void FbxConverter::resetScene() {
     if (pbShaderImplementation != nullptr)
         pbShaderImplementation->Destroy(true);
     
     if (scene != nullptr)
         scene->Destroy(true);
-    
-    if (manager != nullptr)
-        manager->Destroy();
 
-    delete loader;
+    pbShaderImplementation = nullptr;
+    scene = nullptr;
+    createdMaterials.clear();
+    boneIndices.clear();
+    locatorIndices.clear();
+    boneNodes.clear();
+    boneTransforms.clear();
 }
 
 bool FbxConverter::convertToFbx(const char* model, const char* output) {
-    std::cout << "Parsing model JSON." << std::endl;
+    resetScene();
+    timings.clear();
+
+    if (nativeWriter) {
+        NativeFbxExporter exporter(*loader);
+        exporter.threads = threads;
+        auto converted = exporter.convertToFbx(model, output);
+        timings = exporter.getTimings();
+        return converted;
+    }
+
+    Stopwatch stopwatch;
+    // Textures from archive packs are extracted next to the output, the file can only refer to paths on disk.
+    textureDirectory = std::filesystem::path(output).parent_path();
+
+    Log::info() << "Parsing model JSON.";
 
     std::string modelName(model);
+    auto prefetched = loader->prefetch(modelName);
+    if (!prefetched.model.get()) {
+        return false;
+    }
+
     auto modelData = loader->getModel(modelName);
     if (!modelData) {
         return false;
     }
 
     if (modelData->geometry.capacity() != 1) {
-        std::cerr << "Error: model has more than one geometry - this is not supported." << std::endl;
+        Log::error() << "Error: model has more than one geometry - this is not supported.";
         return false;
     }
-    auto geometry = modelData->geometry.at(0);
+    const auto& geometry = modelData->geometry.at(0);
+    timings.record("parse", stopwatch);
 
-    std::cout << "Importing model." << std::endl;
+    Log::info() << "Importing model.";
 
     scene = FbxScene::Create(manager, "ImportedModel");
 
-    std::cout << "Importing bones." << std::endl;
+    Log::info() << "Importing bones.";
 
     for (const auto& bone : geometry.bones) {
-        std::cout << "Importing bone " << bone.name << std::endl;
+        Log::verbose() << "Importing bone " << bone.name;
         if (!importBone(bone)) {
-            std::cerr << "Error: failed to import bone." << std::endl;
+            Log::error() << "Error: failed to import bone.";
             return false;
         }
     }
+    timings.record("bones", stopwatch);
 
-    std::cout << "Importing meshes." << std::endl;
+    Log::info() << "Importing materials.";
 
-    auto meshId = 0;
+    prefetched.materials.wait();
     for (const auto& mesh : geometry.meshes) {
-        std::cout << "Importing mesh #" << meshId << std::endl;
-        if (!loader->getMaterial(mesh.material)) {
+        if (getMaterial(mesh.material) == nullptr) {
+            Log::error() << "Error: failed to import material " << mesh.material << ".";
             return false;
         }
+    }
+    timings.record("materials", stopwatch);
+
+    Log::info() << "Importing meshes.";
+
+    std::vector<PreparedMesh> preparedMeshes;
+    if (!prepareMeshes(geometry.meshes, preparedMeshes)) {
+        return false;
+    }
+    timings.record("mesh_prepare", stopwatch);
 
-        if (!importMesh(mesh, meshId)) {
-            std::cerr << "Error: failed to import mesh #" << meshId << std::endl;
+    for (size_t meshId = 0; meshId < preparedMeshes.size(); meshId++) {
+        if (!attachMesh(preparedMeshes[meshId])) {
+            Log::error() << "Error: failed to import mesh #" << meshId;
             return false;
         }
-        std::cout << "Finished importing mesh #" << meshId << std::endl;
-        meshId++;
     }
+    timings.record("meshes", stopwatch);
 
-    auto entity = loader->getEntity(modelName);
+    auto entity = prefetched.entity.get() ? loader->getEntity(modelName) : nullptr;
     if (entity && entity->info.components.faceAnimation) {
-        std::cout << "Setting UV offset and scale for face material." << std::endl;
+        Log::info() << "Setting UV offset and scale for face material.";
         auto matName = "mat_" + modelName + "_face";
         if (auto it = createdMaterials.find(matName); it == createdMaterials.end()) {
-            std::cerr << "Failed to find face material " << matName << "." << std::endl;
+            Log::error() << "Failed to find face material " << matName << ".";
             return false;
         } else {
             auto faceMaterial = it->second;
@@ -95,9 +162,9 @@ bool FbxConverter::convertToFbx(const char* model, const char* output) {
         }
     }
 
-    auto animations = loader->getAnimations(modelName);
-    if (animations.has_value()) {
-        std::cout << "Importing animations." << std::endl;
+    auto animations = prefetched.animations.get() ? loader->getAnimations(modelName) : nullptr;
+    if (animations != nullptr) {
+        Log::info() << "Importing animations.";
         for (const auto& animation : animations->animations) {
             auto name = animation.first;
             if (name.starts_with("animation."))
@@ -106,8 +173,9 @@ bool FbxConverter::convertToFbx(const char* model, const char* output) {
             importAnimation(name, animation.second);
         }
     }
+    timings.record("animations", stopwatch);
 
-    std::cout << "Exporting model." << std::endl;
+    Log::info() << "Exporting model.";
 
     auto exporter = FbxExporter::Create(manager, "");
 
@@ -127,168 +195,203 @@ bool FbxConverter::convertToFbx(const char* model, const char* output) {
      auto status = exporter->Initialize(output, manager->GetIOPluginRegistry()->GetNativeWriterFormat(), manager->GetIOSettings());
 #endif
     if (!status) {
-        std::cerr << "Error: failed to initialize FbxExporter." << std::endl;
+        Log::error() << "Error: failed to initialize FbxExporter.";
         return false;
     }
 
     exporter->Export(scene);
     exporter->Destroy();
+    timings.record("write", stopwatch);
+
+    Log::info() << "Export finished.";
+
+    return true;
+}
+
+bool FbxConverter::prepareMeshes(const std::vector<Badger::Mesh>& meshes, std::vector<PreparedMesh>& prepared) {
+    prepared.clear();
+    prepared.resize(meshes.size());
+    std::vector<char> succeeded(meshes.size(), false);
 
-    std::cout << "Export finished." << std::endl;
+    parallelFor(meshes.size(), threads, [&](size_t meshId) {
+        Log::verbose() << "Preparing mesh #" << meshId;
+        succeeded[meshId] = prepareMesh(meshes[meshId], meshId, prepared[meshId]);
+    });
+
+    for (size_t meshId = 0; meshId < meshes.size(); meshId++) {
+        if (!succeeded[meshId]) {
+            Log::error() << "Error: failed to import mesh #" << meshId;
+            return false;
+        }
+    }
 
     return true;
 }
 
-bool FbxConverter::importMesh(const Badger::Mesh& meshData, size_t meshId) {
+bool FbxConverter::prepareMesh(const Badger::Mesh& meshData, size_t meshId, PreparedMesh& prepared) {
     auto positionsCount = meshData.positions.capacity();
     if (positionsCount != meshData.weights.capacity()) {
-        std::cerr << "Error: Invalid mesh positions/weights detected." << std::endl;
+        Log::error() << "Error: Invalid mesh positions/weights detected.";
         return false;
     }
 
     if (!meshData.indices.empty() && positionsCount != meshData.indices.capacity()) {
-        std::cerr << "Error: Invalid mesh positions/indices detected." << std::endl;
+        Log::error() << "Error: Invalid mesh positions/indices detected.";
         return false;
     }
-    
-    auto nodeName = "meshNode_" + std::to_string(meshId);
-    auto meshName = "mesh_" + std::to_string(meshId);
 
-    if (!meshData.name.empty()) {
-        nodeName = nodeName.append("_" + meshData.name);
-        meshName = meshName.append("_" + meshData.name);
-    }
-
-    FbxNode* meshNode = FbxNode::Create(scene, nodeName.c_str());
-    FbxMesh* mesh = FbxMesh::Create(scene, meshName.c_str());
-    meshNode->SetNodeAttribute(mesh);
-
-    scene->GetRootNode()->AddChild(meshNode);
-
-    std::cout << "Importing control points." << std::endl;
-    mesh->InitControlPoints(meshData.positions.capacity());
-    auto controlPoints = mesh->GetControlPoints();
+    if (!loader->getMaterial(meshData.material))
+        return false;
 
+    prepared.nodeName = "meshNode_" + std::to_string(meshId);
+    prepared.meshName = "mesh_" + std::to_string(meshId);
+    prepared.name = meshData.name;
+    prepared.material = meshData.material;
 
-    for (auto i = 0; i < meshData.positions.capacity(); i++) {
-        auto pos = meshData.positions[i];
-        controlPoints[i] = FbxVector4(pos[0], pos[1], pos[2]);
+    if (!meshData.name.empty()) {
+        prepared.nodeName.append("_" + meshData.name);
+        prepared.meshName.append("_" + meshData.name);
     }
 
-    std::cout << "Importing polygons." << std::endl;
-    for (int polygonIndex = 0; polygonIndex != meshData.triangles.capacity(); polygonIndex += 3) {
-        mesh->BeginPolygon();
-        mesh->AddPolygon(meshData.triangles[polygonIndex]);
-        mesh->AddPolygon(meshData.triangles[polygonIndex + 1]);
-        mesh->AddPolygon(meshData.triangles[polygonIndex + 2]);
-        mesh->EndPolygon();
-    }
+    prepared.controlPoints.reserve(positionsCount);
+    for (const auto& pos : meshData.positions)
+        prepared.controlPoints.emplace_back(pos[0], pos[1], pos[2]);
 
-    std::cout << "Importing normals." << std::endl;
-    for (const auto& normalSet : meshData.normals) {
-        std::cout << "Importing Normals Set." << std::endl;
+    prepared.triangles.assign(meshData.triangles.begin(), meshData.triangles.end() - meshData.triangles.size() % 3);
 
+    for (const auto& normalSet : meshData.normals) {
         if (positionsCount != normalSet.capacity()) {
-            std::cerr << "Error: Invalid normal set detected. " << std::endl;
+            Log::error() << "Error: Invalid normal set detected. ";
             return false;
         }
 
-        auto normalElement = mesh->CreateElementNormal();
-        normalElement->SetMappingMode(FbxLayerElement::eByControlPoint);
-        normalElement->SetReferenceMode(FbxLayerElement::eDirect);
-        for (auto normal : normalSet) {
-            normalElement->GetDirectArray().Add(FbxVector4(normal[0], normal[1], normal[2], normal[3]));
-        }
+        auto& normals = prepared.normals.emplace_back();
+        normals.reserve(positionsCount);
+        for (const auto& normal : normalSet)
+            normals.emplace_back(normal[0], normal[1], normal[2], normal[3]);
     }
 
-    std::cout << "Importing UVs." << std::endl;
     for (const auto& uvSet : meshData.uvs) {
-        std::cout << "Importing UV Set." << std::endl;
-
         if (positionsCount != uvSet.capacity()) {
-            std::cerr << "Error: Invalid UV set detected. " << std::endl;
+            Log::error() << "Error: Invalid UV set detected. ";
             return false;
         }
 
-        auto uvElement = mesh->CreateElementUV("UVs");
-        uvElement->SetMappingMode(FbxLayerElement::eByControlPoint);
-        uvElement->SetReferenceMode(FbxLayerElement::eDirect);
-        for (auto uv : uvSet) {
-            uvElement->GetDirectArray().Add(FbxVector2(uv[0], 1 - uv[1]));
-        }
+        auto& uvs = prepared.uvs.emplace_back();
+        uvs.reserve(positionsCount);
+        for (const auto& uv : uvSet)
+            uvs.emplace_back(uv[0], 1 - uv[1]);
     }
 
-    std::cout << "Importing colors." << std::endl;
     for (const auto& colorSet : meshData.colors) {
-        std::cout << "Importing color set." << std::endl;
-
         if (positionsCount != colorSet.capacity()) {
-            std::cerr << "Error: Invalid color set detected. " << std::endl;
+            Log::error() << "Error: Invalid color set detected. ";
             return false;
         }
 
-        auto colorElement = mesh->CreateElementVertexColor();
-        colorElement->SetMappingMode(FbxLayerElement::eByControlPoint);
-        colorElement->SetReferenceMode(FbxLayerElement::eDirect);
-        for (auto color : colorSet) {
-            colorElement->GetDirectArray().Add(FbxColor(color[0], color[1], color[2], color[3]));
-        }
+        auto& colors = prepared.colors.emplace_back();
+        colors.reserve(positionsCount);
+        for (const auto& color : colorSet)
+            colors.emplace_back(color[0], color[1], color[2], color[3]);
     }
 
-    if (!meshData.indices.empty()) {
-        std::cout << "Assigning mesh to bones." << std::endl;
-        auto skin = FbxSkin::Create(scene, (meshData.name + "_skin").c_str());
+    if (!buildSkinClusters(meshData, prepared.clusters))
+        return false;
 
-        std::unordered_map<std::string, FbxCluster*> clusterMap;
+    return true;
+}
 
-        for (auto i = 0; i < meshData.indices.capacity(); i++) {
-            auto boneNames = meshData.indices[i];
-            
-            for (auto j = 0; j < boneNames.capacity(); j++) {
-                auto boneName = boneNames[j];
-                auto weight = meshData.weights[i][j];
+bool FbxConverter::attachMesh(const PreparedMesh& prepared) {
+    FbxNode* meshNode = FbxNode::Create(scene, prepared.nodeName.c_str());
+    FbxMesh* mesh = FbxMesh::Create(scene, prepared.meshName.c_str());
+    meshNode->SetNodeAttribute(mesh);
 
-                FbxCluster* cluster;
-                if (auto pair = clusterMap.find(boneName); pair == clusterMap.end()) {
-                    cluster = FbxCluster::Create(scene, (meshData.name + "_" + boneName + "_cluster").c_str());
-                    auto skelNode = scene->GetRootNode()->FindChild(boneName.c_str());
-                    cluster->SetLink(skelNode);
-                    cluster->SetLinkMode(FbxCluster::eTotalOne);
-                    clusterMap.insert({boneName, cluster});
-                } else {
-                    cluster = pair->second;
-                }
+    scene->GetRootNode()->AddChild(meshNode);
+
+    auto positionsCount = static_cast<int>(prepared.controlPoints.size());
+    mesh->InitControlPoints(positionsCount);
+    std::copy(prepared.controlPoints.begin(), prepared.controlPoints.end(), mesh->GetControlPoints());
+
+    mesh->ReservePolygonCount(static_cast<int>(prepared.triangles.size() / 3));
+    mesh->ReservePolygonVertexCount(static_cast<int>(prepared.triangles.size()));
+    for (size_t polygonIndex = 0; polygonIndex < prepared.triangles.size(); polygonIndex += 3) {
+        mesh->BeginPolygon();
+        mesh->AddPolygon(prepared.triangles[polygonIndex]);
+        mesh->AddPolygon(prepared.triangles[polygonIndex + 1]);
+        mesh->AddPolygon(prepared.triangles[polygonIndex + 2]);
+        mesh->EndPolygon();
+    }
+
+    auto fillDirectArray = [positionsCount](auto& directArray, const auto& values) {
+        directArray.Resize(positionsCount);
+        for (auto i = 0; i < positionsCount; i++)
+            directArray.SetAt(i, values[i]);
+    };
+
+    for (const auto& normals : prepared.normals) {
+        auto normalElement = mesh->CreateElementNormal();
+        normalElement->SetMappingMode(FbxLayerElement::eByControlPoint);
+        normalElement->SetReferenceMode(FbxLayerElement::eDirect);
+        fillDirectArray(normalElement->GetDirectArray(), normals);
+    }
+
+    for (const auto& uvs : prepared.uvs) {
+        auto uvElement = mesh->CreateElementUV("UVs");
+        uvElement->SetMappingMode(FbxLayerElement::eByControlPoint);
+        uvElement->SetReferenceMode(FbxLayerElement::eDirect);
+        fillDirectArray(uvElement->GetDirectArray(), uvs);
+    }
 
-                cluster->AddControlPointIndex(i, weight);
+    for (const auto& colors : prepared.colors) {
+        auto colorElement = mesh->CreateElementVertexColor();
+        colorElement->SetMappingMode(FbxLayerElement::eByControlPoint);
+        colorElement->SetReferenceMode(FbxLayerElement::eDirect);
+        fillDirectArray(colorElement->GetDirectArray(), colors);
+    }
+
+    if (!prepared.clusters.empty()) {
+        // Unnamed meshes would all share one skin name, their mesh id keeps them apart.
+        auto skin = FbxSkin::Create(scene, ((prepared.name.empty() ? prepared.meshName : prepared.name) + "_skin").c_str());
+        // Mesh nodes sit directly under the root without a transform of their own.
+        auto transform = toFbxMatrix(Matrix4::identity());
+
+        for (const auto& preparedCluster : prepared.clusters) {
+            auto cluster = FbxCluster::Create(scene, (prepared.name + "_" + preparedCluster.bone.str() + "_cluster").c_str());
+            auto bone = boneIndices.find(preparedCluster.bone);
+            if (bone == boneIndices.end()) {
+                Log::error() << "Error: could not find bone " << preparedCluster.bone << " in the scene.";
+                return false;
             }
-        }
+            auto skelNode = boneNodes[bone->second];
 
-        auto transform = meshNode->EvaluateGlobalTransform();
+            cluster->SetLink(skelNode);
+            cluster->SetLinkMode(FbxCluster::eTotalOne);
 
-        for (auto pair : clusterMap) {
-            auto linkTransform = pair.second->GetLink()->EvaluateGlobalTransform();
-            pair.second->SetTransformMatrix(transform);
-            pair.second->SetTransformLinkMatrix(linkTransform);
-            skin->AddCluster(pair.second);
+            cluster->SetControlPointIWCount(static_cast<int>(preparedCluster.indices.size()));
+            std::copy(preparedCluster.indices.begin(), preparedCluster.indices.end(), cluster->GetControlPointIndices());
+            std::copy(preparedCluster.weights.begin(), preparedCluster.weights.end(), cluster->GetControlPointWeights());
+
+            cluster->SetTransformMatrix(transform);
+            cluster->SetTransformLinkMatrix(toFbxMatrix(boneTransforms.global(bone->second)));
+            skin->AddCluster(cluster);
         }
 
         mesh->AddDeformer(skin);
     }
 
-    std::cout << "Importing material." << std::endl;
     auto materialLayer = mesh->CreateElementMaterial();
     materialLayer->SetMappingMode(FbxLayerElement::eAllSame);
     materialLayer->SetReferenceMode(FbxLayerElement::eIndexToDirect);
     materialLayer->GetIndexArray().Add(0);
 
-    auto material = getMaterial(meshData.material);
+    auto material = getMaterial(prepared.material);
     if (material == nullptr) {
         return false;
     }
 
-    mesh->GetNode()->AddMaterial(material);
+    meshNode->AddMaterial(material);
 
-    mesh->GetNode()->SetShadingMode(FbxNode::eTextureShading);
+    meshNode->SetShadingMode(FbxNode::eTextureShading);
 
     return true;
 }
@@ -296,7 +399,7 @@ bool FbxConverter::importMesh(const Badger::Mesh& meshData, size_t meshId) {
 bool FbxConverter::importBone(const Badger::Bone& badgerBone) {
     auto isRootBone = badgerBone.parent.empty();
     auto skeletonNode = FbxNode::Create(scene, badgerBone.name.c_str());
-    auto skeleton = FbxSkeleton::Create(scene, (badgerBone.name + "_bone").c_str());
+    auto skeleton = FbxSkeleton::Create(scene, (badgerBone.name.str() + "_bone").c_str());
     if (isRootBone) {
         skeleton->SetSkeletonType(FbxSkeleton::eRoot);
     } else {
@@ -315,14 +418,43 @@ bool FbxConverter::importBone(const Badger::Bone& badgerBone) {
 
     //skeletonNode->SetTransformationInheritType(FbxTransform::eInheritRSrs);
 
+    auto local = Matrix4::compose(
+        { badgerBone.pivot[0], badgerBone.pivot[1], badgerBone.pivot[2] },
+        { badgerBone.info.bindPoseRotation[0], badgerBone.info.bindPoseRotation[1], badgerBone.info.bindPoseRotation[2] },
+        { badgerBone.scale[0], badgerBone.scale[1], badgerBone.scale[2] });
+
+    size_t transform;
+    if (isRootBone) {
+        scene->GetRootNode()->AddChild(skeletonNode);
+        transform = boneTransforms.add(local);
+    } else {
+        auto parent = boneIndices.find(badgerBone.parent);
+        if (parent == boneIndices.end()) {
+            Log::error() << "Error: could not find parent bone " << badgerBone.parent << ".";
+            return false; 
+        }
+        boneNodes[parent->second]->AddChild(skeletonNode);
+        transform = boneTransforms.add(local, parent->second);
+    }
+
+    boneIndices.try_emplace(badgerBone.name, transform);
+    boneNodes.push_back(skeletonNode);
+
     if (!badgerBone.locators.empty()) {
-        std::cout << "Importing locators." << std::endl;
+        Log::verbose() << "Importing locators.";
 
+        // Locators are placed in the transform table under their bone. Meshes are never bound to them, so they
+        // have their own index for animations instead of an entry in boneIndices.
         for (const auto& locatorPair : badgerBone.locators) {
-            auto info = locatorPair.second;
+            const auto& info = locatorPair.second;
+            if (info.offset.size() < 3 || info.rotation.size() < 3) {
+                Log::error() << "Error: locator " << locatorPair.first << " has an invalid transform.";
+                return false;
+            }
+
             auto locator = FbxNull::Create(scene, (locatorPair.first + "_locator").c_str());
             auto locatorNode = FbxNode::Create(scene, locatorPair.first.c_str());
-            
+
             locatorNode->SetNodeAttribute(locator);
             locatorNode->LclTranslation.Set(FbxDouble3(info.offset[0], info.offset[1], info.offset[2]));
             locatorNode->LclRotation.Set(FbxDouble3(info.rotation[0], info.rotation[1], info.rotation[2]));
@@ -333,19 +465,15 @@ bool FbxConverter::importBone(const Badger::Bone& badgerBone) {
                 : FbxTransform::eInheritRSrs;
             locatorNode->SetTransformationInheritType(inheritType);
 
-            skeletonNode->AddChild(locatorNode);
-        }
-    }
+            auto locatorLocal = Matrix4::compose(
+                { info.offset[0], info.offset[1], info.offset[2] },
+                { info.rotation[0], info.rotation[1], info.rotation[2] },
+                { 1, 1, 1 });
+            locatorIndices.try_emplace(locatorPair.first, boneTransforms.add(locatorLocal, transform, !info.discardScale));
+            boneNodes.push_back(locatorNode);
 
-    if (isRootBone) {
-        scene->GetRootNode()->AddChild(skeletonNode);
-    } else {
-        auto parentNode = scene->GetRootNode()->FindChild(badgerBone.parent.c_str(), true);
-        if (parentNode == nullptr) {
-            std::cerr << "Error: could not find parent bone " << badgerBone.parent << "." << std::endl;
-            return false; 
+            skeletonNode->AddChild(locatorNode);
         }
-        parentNode->AddChild(skeletonNode);
     }
 
     return true;
@@ -358,69 +486,83 @@ bool FbxConverter::importAnimation(const std::string& name, const Badger::Animat
 
     animationLayer->BlendMode.Set(FbxAnimLayer::eBlendAdditive);
 
-    auto setKeyframes = [&](FbxTime& keyframeTime, FbxPropertyT<FbxDouble3>& property, const std::unordered_map<double, Badger::AnimationProperty>& keyframeInfo) {
+    auto setKeyframes = [&](FbxTime& stopTime, FbxPropertyT<FbxDouble3>& property, const std::unordered_map<double, Badger::AnimationProperty>& keyframeInfo) {
         if (keyframeInfo.empty())
             return;
 
-        auto originalX = property.Get()[0];
-        auto originalY = property.Get()[1];
-        auto originalZ = property.Get()[2];
-
-        auto curveNode = property.GetCurveNode(animationLayer, true);
-        auto translationX = property.GetCurve(animationLayer, FBXSDK_CURVENODE_COMPONENT_X, true);
-        auto translationY = property.GetCurve(animationLayer, FBXSDK_CURVENODE_COMPONENT_Y, true);
-        auto translationZ = property.GetCurve(animationLayer, FBXSDK_CURVENODE_COMPONENT_Z, true);
-
-        translationX->KeyModifyBegin();
-        translationY->KeyModifyBegin();
-        translationZ->KeyModifyBegin();
-
-        auto ind = 0;
-        for (const auto& currentKeyframe : keyframeInfo) {
-            keyframeTime.SetSecondDouble(currentKeyframe.first);
-            
-            ind = translationX->KeyAdd(keyframeTime);
-            translationX->KeySet(
-                ind,
-                keyframeTime, 
-                originalX + currentKeyframe.second.post[0],
-                FbxAnimCurveDef::eInterpolationLinear
-            );
-
-            ind = translationY->KeyAdd(keyframeTime);
-            translationY->KeySet(
-                ind,
-                keyframeTime, 
-                originalY + currentKeyframe.second.post[1],
-                FbxAnimCurveDef::eInterpolationLinear
-            );
-
-            ind = translationZ->KeyAdd(keyframeTime);
-            translationZ->KeySet(
-                ind,
-                keyframeTime, 
-                originalZ + currentKeyframe.second.post[2],
-                FbxAnimCurveDef::eInterpolationLinear
-            );
+        // Tangents depend on the neighbouring keys, so the keyframes are needed in time order.
+        std::vector<std::pair<double, const Badger::AnimationProperty*>> keyframes;
+        keyframes.reserve(keyframeInfo.size());
+        for (const auto& keyframe : keyframeInfo)
+            keyframes.emplace_back(keyframe.first, &keyframe.second);
+        std::sort(keyframes.begin(), keyframes.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        std::vector<double> times;
+        std::vector<char> smooth;
+        for (const auto& keyframe : keyframes) {
+            times.push_back(keyframe.first);
+            smooth.push_back(keyframe.second->lerpMode == "catmullrom");
         }
 
-        translationX->KeyModifyEnd();
-        translationY->KeyModifyEnd();
-        translationZ->KeyModifyEnd();
+        property.GetCurveNode(animationLayer, true);
+        const char* components[] = { FBXSDK_CURVENODE_COMPONENT_X, FBXSDK_CURVENODE_COMPONENT_Y, FBXSDK_CURVENODE_COMPONENT_Z };
+
+        for (auto axis = 0; axis < 3; axis++) {
+            auto original = property.Get()[axis];
+            auto curve = property.GetCurve(animationLayer, components[axis], true);
+
+            std::vector<double> values;
+            for (const auto& keyframe : keyframes)
+                values.push_back(original + keyframe.second->post[axis]);
+
+            // Catmull-Rom segments become cubic keys with matching tangents, so the curve follows the game without baking.
+            auto tangents = catmullRomTangents(times, values, smooth);
+
+            curve->KeyModifyBegin();
+            for (size_t i = 0; i < keyframes.size(); i++) {
+                FbxTime keyframeTime;
+                keyframeTime.SetSecondDouble(times[i]);
+
+                auto index = curve->KeyAdd(keyframeTime);
+                if (tangents[i].cubic) {
+                    curve->KeySet(index, keyframeTime, static_cast<float>(values[i]), FbxAnimCurveDef::eInterpolationCubic,
+                        FbxAnimCurveDef::eTangentBreak, static_cast<float>(tangents[i].rightSlope), static_cast<float>(tangents[i].nextLeftSlope));
+                } else {
+                    curve->KeySet(index, keyframeTime, static_cast<float>(values[i]), FbxAnimCurveDef::eInterpolationLinear);
+                }
+
+                if (keyframeTime > stopTime)
+                    stopTime = keyframeTime;
+            }
+            curve->KeyModifyEnd();
+        }
     };
 
     FbxTime time; // Will be stop time once setKeyframe is done
 
+    // Bones are sorted so the curves are created in the same order on every run.
+    std::vector<std::pair<size_t, const Badger::AnimationBone*>> bones;
     for (const auto& boneAnimation : badgerAnimation.bones) {
-        auto boneNode = scene->FindNodeByName(boneAnimation.first.c_str());
-        if (boneNode == nullptr) {
-            std::cerr << "Error: could not find bone " << boneAnimation.first << " in the scene." << std::endl;
-            return false;
+        // Animations can key locators as well as bones.
+        auto bone = boneIndices.find(boneAnimation.first);
+        if (bone == boneIndices.end()) {
+            bone = locatorIndices.find(boneAnimation.first);
+            if (bone == locatorIndices.end()) {
+                Log::error() << "Error: could not find bone " << boneAnimation.first << " in the scene.";
+                return false;
+            }
         }
+        bones.emplace_back(bone->second, &boneAnimation.second);
+    }
+    std::sort(bones.begin(), bones.end());
 
-        setKeyframes(time, boneNode->LclTranslation, boneAnimation.second.position);
-        setKeyframes(time, boneNode->LclRotation, boneAnimation.second.rotation);
-        setKeyframes(time, boneNode->LclScaling, boneAnimation.second.scale);
+    for (const auto& [bone, boneAnimation] : bones) {
+        auto boneNode = boneNodes[bone];
+        setKeyframes(time, boneNode->LclTranslation, boneAnimation->position);
+        setKeyframes(time, boneNode->LclRotation, boneAnimation->rotation);
+        setKeyframes(time, boneNode->LclScaling, boneAnimation->scale);
     }
 
     animationStack->LocalStart.Set(FbxTime(0));
@@ -433,7 +575,7 @@ FbxSurfaceMaterial* FbxConverter::getMaterial(const std::string& name) {
     if (auto it = createdMaterials.find(name); it != createdMaterials.end())
         return it->second;
 
-    std::cout << "Importing material " << name << "." << std::endl;
+    Log::verbose() << "Importing material " << name << ".";
 
     auto materialData = loader->getMaterial(name);
     if (!materialData) {
@@ -499,7 +641,7 @@ FbxSurfaceMaterial* FbxConverter::getMaterial(const std::string& name) {
 
     auto createTexture = [&](const std::string& texName, const std::string& texPath) {
         auto tex = FbxFileTexture::Create(scene, texName.c_str());
-        tex->SetFileName(texPath.c_str());
+        tex->SetFileName(loader->extractFile(texPath, textureDirectory).c_str());
         tex->SetTextureUse(FbxTexture::eStandard);
         tex->SetMappingType(FbxTexture::eUV);
         tex->SetMaterialUse(FbxFileTexture::eModelMaterial);
@@ -512,21 +654,21 @@ FbxSurfaceMaterial* FbxConverter::getMaterial(const std::string& name) {
     };
 
     if (useColorMap) {
-        std::cout << "Adding diffuse texture." << std::endl;
+        Log::verbose() << "Adding diffuse texture.";
 
         auto tex = createTexture(name + "_diffuse", materialInfo.diffuse + ".png");
         tex->ConnectDstProperty(colorMapProp);
     }
 
     if (useNormalMap) {
-        std::cout << "Adding normal texture." << std::endl;
+        Log::verbose() << "Adding normal texture.";
 
         auto tex = createTexture(name + "_normal", materialInfo.normal + ".png");
         tex->ConnectDstProperty(normalMapProp);
     }
 
     if (useCoefficientMap) {
-        std::cout << "Adding coefficient texture." << std::endl;
+        Log::verbose() << "Adding coefficient texture.";
 
         auto tex = createTexture(name + "_coeff", materialInfo.coeff + ".png");
         tex->ConnectDstProperty(metallicMapProp);
@@ -534,7 +676,7 @@ FbxSurfaceMaterial* FbxConverter::getMaterial(const std::string& name) {
     }
 
     if (useEmissiveMap) {
-        std::cout << "Adding emissive texture." << std::endl;
+        Log::verbose() << "Adding emissive texture.";
 
         auto tex = createTexture(name + "_emissive", materialInfo.emissive + ".hdr");
         tex->ConnectDstProperty(emissiveMapProp);
@@ -552,7 +694,7 @@ FbxSurfaceMaterial* FbxConverter::getMaterial(const std::string& name) {
 }
 
 bool FbxConverter::generateShaderImplementation(const FbxProperty& mayaProp) {
-    std::cout << "Generating default shader implementation." << std::endl;
+    Log::verbose() << "Generating default shader implementation.";
 
     pbShaderImplementation = FbxImplementation::Create(scene, "PBS_Implementation");
     pbShaderImplementation->RenderAPI = "SFX_PBS_SHADER";
@@ -560,26 +702,14 @@ bool FbxConverter::generateShaderImplementation(const FbxProperty& mayaProp) {
     pbShaderImplementation->LanguageVersion = "28";
     auto shaderGraphProp = FbxProperty::Create(pbShaderImplementation, FbxBlobDT, "ShaderGraph", "");
     
-    std::cout << "Decompressing shadergraph." << std::endl;
-
-    // Decompress shadergraph
-    size_t decompressedLength = DEFAULT_SFX_SHADERGRAPH_DECOMPRESSED_LENGTH;
-    auto decompressedData = new unsigned char[decompressedLength];
-    auto result = BrotliDecoderDecompress(
-        DEFAULT_SFX_SHADERGRAPH_COMPRESSED_LENGTH,
-        DEFAULT_SFX_SHADERGRAPH_COMPRESSED, 
-        &decompressedLength, 
-        decompressedData
-    );
-
-    if (result != BrotliDecoderResult::BROTLI_DECODER_RESULT_SUCCESS) {
-        delete[] decompressedData;
-        std::cerr << "Error: failed to decompress shadergraph binary. Result: " << result << std::endl;
-        return false; 
+    Log::verbose() << "Decompressing shadergraph.";
+
+    const auto& shadergraph = decompressedShadergraph();
+    if (shadergraph.empty()) {
+        return false;
     }
     
-    shaderGraphProp.Set(FbxBlob(decompressedData, decompressedLength));
-    delete[] decompressedData;
+    shaderGraphProp.Set(FbxBlob(shadergraph.data(), static_cast<int>(shadergraph.size())));
 
     auto bindingTable = pbShaderImplementation->AddNewTable("root", "shader");
     pbShaderImplementation->RootBindingName = "root";
@@ -1,19 +1,48 @@
 #pragma once
 
 #include "BadgerModel.hh"
+#include "MeshBuilder.hh"
 #include "ResourceLoader.hh"
+#include "Stopwatch.hh"
+#include "Transform.hh"
 
+#include <filesystem>
 #include <vector>
 #include <fbxsdk.h>
 
 class FbxConverter {
     public:
         explicit FbxConverter(const char* resourcePacksDir);
+        explicit FbxConverter(ResourceLoader& loader);
         ~FbxConverter();
 
         bool convertToFbx(const char* model, const char* output);
+        const PhaseTimings& getTimings() const { return timings; }
+
+        // Worker threads used to prepare meshes, 0 uses one per hardware thread.
+        size_t threads = 0;
+        // Writes the file with NativeFbxExporter instead of building an SDK scene.
+        bool nativeWriter = false;
     private:
-        bool importMesh(const Badger::Mesh& badgerMesh, size_t meshId);
+        // Everything needed to build one FbxMesh, computed without touching the scene.
+        struct PreparedMesh {
+            std::string nodeName;
+            std::string meshName;
+            std::string name;
+            std::string material;
+            std::vector<FbxVector4> controlPoints;
+            std::vector<int> triangles;
+            std::vector<std::vector<FbxVector4>> normals;
+            std::vector<std::vector<FbxVector2>> uvs;
+            std::vector<std::vector<FbxColor>> colors;
+            std::vector<SkinCluster> clusters;
+        };
+
+        FbxConverter(ResourceLoader* loader, bool ownsLoader);
+        void resetScene();
+        bool prepareMeshes(const std::vector<Badger::Mesh>& meshes, std::vector<PreparedMesh>& prepared);
+        bool prepareMesh(const Badger::Mesh& badgerMesh, size_t meshId, PreparedMesh& prepared);
+        bool attachMesh(const PreparedMesh& prepared);
         bool importBone(const Badger::Bone& badgerBone);
         bool importAnimation(const std::string& name, const Badger::Animation& badgerAnimation);
         bool generateShaderImplementation(const FbxProperty& mayaProp);
@@ -21,12 +50,15 @@ class FbxConverter {
         FbxManager* manager;
         FbxScene* scene;
         ResourceLoader* loader;
-        std::unordered_map<std::string, FbxSurfaceMaterial*> createdMaterials;
+        bool ownsLoader;
+        std::unordered_map<Symbol, FbxSurfaceMaterial*> createdMaterials;
+        // Imported bone and locator nodes and their global bind transforms, in import order so parents come first.
+        // Bones and locators are named in separate indices, meshes only bind to bones.
+        std::unordered_map<Symbol, size_t> boneIndices;
+        std::unordered_map<Symbol, size_t> locatorIndices;
+        std::vector<FbxNode*> boneNodes;
+        TransformTable boneTransforms;
         FbxImplementation* pbShaderImplementation;
+        std::filesystem::path textureDirectory;
+        PhaseTimings timings;
 };
-
-static unsigned char DEFAULT_SFX_SHADERGRAPH_COMPRESSED[] = {
-#include "shadergraph.brotli.hex"
-};
-static const int DEFAULT_SFX_SHADERGRAPH_COMPRESSED_LENGTH = sizeof(DEFAULT_SFX_SHADERGRAPH_COMPRESSED);
-static const int DEFAULT_SFX_SHADERGRAPH_DECOMPRESSED_LENGTH = 29285;
\ No newline at end of file
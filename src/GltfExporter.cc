@@ -0,0 +1,763 @@
+#include "GltfExporter.hh"
+#include "AnimationSampler.hh"
+#include "BadgerModel.hh"
+#include "Log.hh"
+#include "Version.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numbers>
+
+namespace {
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr uint32_t GLB_VERSION = 2;
+    constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+    constexpr uint32_t CHUNK_BIN = 0x004E4942;
+
+    constexpr int COMPONENT_UNSIGNED_SHORT = 5123;
+    constexpr int COMPONENT_UNSIGNED_INT = 5125;
+    constexpr int COMPONENT_FLOAT = 5126;
+
+    constexpr int TARGET_NONE = 0;
+    constexpr int TARGET_ARRAY_BUFFER = 34962;
+    constexpr int TARGET_ELEMENT_ARRAY_BUFFER = 34963;
+
+    // glTF has no Catmull-Rom interpolation, such segments are resampled into this many linear ones.
+    constexpr size_t SMOOTH_SEGMENT_STEPS = 8;
+
+    // Column-major, as glTF expects it.
+    using Matrix = std::array<double, 16>;
+    using Quaternion = std::array<double, 4>;
+
+    Quaternion multiply(const Quaternion& a, const Quaternion& b) {
+        return {
+            a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+            a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+            a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+            a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2]
+        };
+    }
+
+    // Badger rotations are euler angles in degrees, applied in X, Y, Z order like the FBX default.
+    Quaternion eulerToQuaternion(double x, double y, double z) {
+        auto half = std::numbers::pi / 360.0;
+        Quaternion qx { std::sin(x * half), 0, 0, std::cos(x * half) };
+        Quaternion qy { 0, std::sin(y * half), 0, std::cos(y * half) };
+        Quaternion qz { 0, 0, std::sin(z * half), std::cos(z * half) };
+        return multiply(qz, multiply(qy, qx));
+    }
+
+    Matrix composeTransform(const Badger::Vector3f& translation, const Quaternion& q, const Badger::Vector3f& scale) {
+        auto [x, y, z, w] = q;
+        return {
+            (1 - 2 * (y * y + z * z)) * scale[0], 2 * (x * y + z * w) * scale[0], 2 * (x * z - y * w) * scale[0], 0,
+            2 * (x * y - z * w) * scale[1], (1 - 2 * (x * x + z * z)) * scale[1], 2 * (y * z + x * w) * scale[1], 0,
+            2 * (x * z + y * w) * scale[2], 2 * (y * z - x * w) * scale[2], (1 - 2 * (x * x + y * y)) * scale[2], 0,
+            translation[0], translation[1], translation[2], 1
+        };
+    }
+
+    Matrix multiply(const Matrix& a, const Matrix& b) {
+        Matrix result {};
+        for (auto column = 0; column < 4; column++) {
+            for (auto row = 0; row < 4; row++) {
+                for (auto k = 0; k < 4; k++)
+                    result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+            }
+        }
+        return result;
+    }
+
+    Matrix invert(const Matrix& m) {
+        Matrix inverse {
+            m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10],
+            -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10],
+            m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7] - m[13] * m[3] * m[6],
+            -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9] * m[2] * m[7] + m[9] * m[3] * m[6],
+            -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10],
+            m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10],
+            -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7] + m[12] * m[3] * m[6],
+            m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8] * m[2] * m[7] - m[8] * m[3] * m[6],
+            m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9],
+            -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9],
+            m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7] - m[12] * m[3] * m[5],
+            -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] - m[8] * m[1] * m[7] + m[8] * m[3] * m[5],
+            -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9],
+            m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9],
+            -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6] + m[12] * m[2] * m[5],
+            m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] + m[8] * m[1] * m[6] - m[8] * m[2] * m[5]
+        };
+
+        auto determinant = m[0] * inverse[0] + m[1] * inverse[4] + m[2] * inverse[8] + m[3] * inverse[12];
+        if (determinant == 0)
+            return Matrix { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+        for (auto& value : inverse)
+            value /= determinant;
+        return inverse;
+    }
+
+    bool isVector3(const Badger::Vector3f& vector) {
+        return vector.size() >= 3;
+    }
+}
+
+GltfExporter::GltfExporter(const char* resourcePacksDir) : GltfExporter(new ResourceLoader(resourcePacksDir), true) {
+
+}
+
+GltfExporter::GltfExporter(ResourceLoader& loader) : GltfExporter(&loader, false) {
+
+}
+
+GltfExporter::GltfExporter(ResourceLoader* loader, bool ownsLoader) : loader(loader), ownsLoader(ownsLoader) {
+
+}
+
+GltfExporter::~GltfExporter() {
+    if (ownsLoader)
+        delete loader;
+}
+
+void GltfExporter::resetDocument() {
+    document = json {
+        {"asset", {
+            {"version", "2.0"},
+            {"generator", "FbxConverter " FBX_CONVERTER_VERSION}
+        }},
+        {"scene", 0},
+        {"scenes", json::array({ json { {"nodes", json::array()} } })}
+    };
+
+    binary.clear();
+    boneJoints.clear();
+    jointNodes.clear();
+    jointBones.clear();
+    exportedMaterials.clear();
+    exportedTextures.clear();
+}
+
+bool GltfExporter::convertToGlb(const char* model, const char* output) {
+    resetDocument();
+    timings.clear();
+    Stopwatch stopwatch;
+
+    Log::info() << "Parsing model JSON.";
+
+    std::string modelName(model);
+    auto prefetched = loader->prefetch(modelName);
+    if (!prefetched.model.get()) {
+        return false;
+    }
+
+    auto modelData = loader->getModel(modelName);
+    if (!modelData) {
+        return false;
+    }
+
+    if (modelData->geometry.size() != 1) {
+        Log::error() << "Error: model has more than one geometry - this is not supported.";
+        return false;
+    }
+    const auto& geometry = modelData->geometry.at(0);
+    timings.record("parse", stopwatch);
+
+    Log::info() << "Exporting bones.";
+
+    if (!exportBones(geometry)) {
+        return false;
+    }
+    timings.record("bones", stopwatch);
+
+    Log::info() << "Exporting meshes.";
+
+    prefetched.materials.wait();
+
+    for (size_t meshId = 0; meshId < geometry.meshes.size(); meshId++) {
+        Log::verbose() << "Exporting mesh #" << meshId;
+        if (!exportMesh(geometry.meshes[meshId], meshId)) {
+            Log::error() << "Error: failed to export mesh #" << meshId;
+            return false;
+        }
+    }
+    timings.record("meshes", stopwatch);
+
+    auto animations = prefetched.animations.get() ? loader->getAnimations(modelName) : nullptr;
+    if (animations != nullptr) {
+        Log::info() << "Exporting animations.";
+        for (const auto& animation : animations->animations) {
+            auto name = animation.first;
+            if (name.starts_with("animation."))
+                name = name.substr(10);
+
+            if (!exportAnimation(name, animation.second)) {
+                Log::error() << "Error: failed to export animation " << name << ".";
+                return false;
+            }
+        }
+    }
+    timings.record("animations", stopwatch);
+
+    Log::info() << "Writing glb.";
+
+    auto written = write(output);
+    timings.record("write", stopwatch);
+
+    // The bone pointers refer into the cached model, which may be evicted once it is released.
+    jointBones.clear();
+
+    if (written)
+        Log::info() << "Export finished.";
+
+    return written;
+}
+
+size_t GltfExporter::addBufferView(size_t byteLength, int target, size_t& offset) {
+    offset = binary.size();
+    binary.resize(offset + ((byteLength + 3) & ~size_t(3)));
+
+    json bufferView {
+        {"buffer", 0},
+        {"byteOffset", offset},
+        {"byteLength", byteLength}
+    };
+    if (target != TARGET_NONE)
+        bufferView["target"] = target;
+
+    document["bufferViews"].push_back(bufferView);
+    return document["bufferViews"].size() - 1;
+}
+
+template <typename T>
+T* GltfExporter::allocate(size_t count, int target, size_t& bufferView) {
+    size_t offset;
+    bufferView = addBufferView(count * sizeof(T), target, offset);
+    return reinterpret_cast<T*>(binary.data() + offset);
+}
+
+size_t GltfExporter::addAccessor(size_t bufferView, int componentType, size_t count, const char* type, const json& min, const json& max) {
+    json accessor {
+        {"bufferView", bufferView},
+        {"componentType", componentType},
+        {"count", count},
+        {"type", type}
+    };
+    if (!min.is_null())
+        accessor["min"] = min;
+    if (!max.is_null())
+        accessor["max"] = max;
+
+    document["accessors"].push_back(accessor);
+    return document["accessors"].size() - 1;
+}
+
+bool GltfExporter::exportBones(const Badger::Geometry& geometry) {
+    std::vector<Matrix> globalTransforms;
+
+    for (const auto& bone : geometry.bones) {
+        if (!isVector3(bone.pivot) || !isVector3(bone.scale) || !isVector3(bone.info.bindPoseRotation)) {
+            Log::error() << "Error: bone " << bone.name << " has an invalid transform.";
+            return false;
+        }
+
+        const auto& rotation = bone.info.bindPoseRotation;
+        auto quaternion = eulerToQuaternion(rotation[0], rotation[1], rotation[2]);
+        auto nodeIndex = document["nodes"].size();
+
+        document["nodes"].push_back({
+            {"name", bone.name},
+            {"translation", { bone.pivot[0], bone.pivot[1], bone.pivot[2] }},
+            {"rotation", quaternion},
+            {"scale", { bone.scale[0], bone.scale[1], bone.scale[2] }}
+        });
+
+        auto localTransform = composeTransform(bone.pivot, quaternion, bone.scale);
+        if (bone.parent.empty()) {
+            document["scenes"][0]["nodes"].push_back(nodeIndex);
+            globalTransforms.push_back(localTransform);
+        } else {
+            auto parent = boneJoints.find(bone.parent);
+            if (parent == boneJoints.end()) {
+                Log::error() << "Error: could not find parent bone " << bone.parent << ".";
+                return false;
+            }
+
+            document["nodes"][jointNodes[parent->second]]["children"].push_back(nodeIndex);
+            globalTransforms.push_back(multiply(globalTransforms[parent->second], localTransform));
+        }
+
+        boneJoints.insert({bone.name, jointNodes.size()});
+        jointNodes.push_back(nodeIndex);
+        jointBones.push_back(&bone);
+
+        // glTF has no per-node scale inheritance modes, so discard_scale cannot be represented.
+        for (const auto& locator : bone.locators) {
+            if (!isVector3(locator.second.offset) || !isVector3(locator.second.rotation))
+                continue;
+
+            const auto& offset = locator.second.offset;
+            const auto& locatorRotation = locator.second.rotation;
+            document["nodes"][nodeIndex]["children"].push_back(document["nodes"].size());
+            document["nodes"].push_back({
+                {"name", locator.first},
+                {"translation", { offset[0], offset[1], offset[2] }},
+                {"rotation", eulerToQuaternion(locatorRotation[0], locatorRotation[1], locatorRotation[2])}
+            });
+        }
+    }
+
+    if (jointNodes.empty())
+        return true;
+
+    size_t bufferView;
+    auto inverseBindMatrices = allocate<float>(jointNodes.size() * 16, TARGET_NONE, bufferView);
+    for (size_t joint = 0; joint < jointNodes.size(); joint++) {
+        auto inverse = invert(globalTransforms[joint]);
+        std::transform(inverse.begin(), inverse.end(), inverseBindMatrices + joint * 16, [](double value) {
+            return static_cast<float>(value);
+        });
+    }
+
+    document["skins"].push_back({
+        {"joints", jointNodes},
+        {"inverseBindMatrices", addAccessor(bufferView, COMPONENT_FLOAT, jointNodes.size(), "MAT4")}
+    });
+
+    return true;
+}
+
+bool GltfExporter::exportMesh(const Badger::Mesh& meshData, size_t meshId) {
+    auto positionsCount = meshData.positions.size();
+    if (positionsCount != meshData.weights.size()) {
+        Log::error() << "Error: Invalid mesh positions/weights detected.";
+        return false;
+    }
+
+    if (!meshData.indices.empty() && positionsCount != meshData.indices.size()) {
+        Log::error() << "Error: Invalid mesh positions/indices detected.";
+        return false;
+    }
+
+    auto nodeName = "meshNode_" + std::to_string(meshId);
+    auto meshName = "mesh_" + std::to_string(meshId);
+    if (!meshData.name.empty()) {
+        nodeName.append("_" + meshData.name);
+        meshName.append("_" + meshData.name);
+    }
+
+    json attributes = json::object();
+    size_t bufferView;
+
+    auto positions = allocate<float>(positionsCount * 3, TARGET_ARRAY_BUFFER, bufferView);
+    std::array<float, 3> min { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    std::array<float, 3> max { std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest() };
+    for (size_t i = 0; i < positionsCount; i++) {
+        const auto& position = meshData.positions[i];
+        if (!isVector3(position)) {
+            Log::error() << "Error: Invalid mesh position detected.";
+            return false;
+        }
+
+        for (auto axis = 0; axis < 3; axis++) {
+            auto value = static_cast<float>(position[axis]);
+            positions[i * 3 + axis] = value;
+            min[axis] = std::min(min[axis], value);
+            max[axis] = std::max(max[axis], value);
+        }
+    }
+    attributes["POSITION"] = positionsCount == 0
+        ? addAccessor(bufferView, COMPONENT_FLOAT, 0, "VEC3")
+        : addAccessor(bufferView, COMPONENT_FLOAT, positionsCount, "VEC3", min, max);
+
+    auto triangleCount = meshData.triangles.size() - meshData.triangles.size() % 3;
+    auto indices = allocate<uint32_t>(triangleCount, TARGET_ELEMENT_ARRAY_BUFFER, bufferView);
+    for (size_t i = 0; i < triangleCount; i++) {
+        auto index = meshData.triangles[i];
+        if (index < 0 || static_cast<size_t>(index) >= positionsCount) {
+            Log::error() << "Error: triangle index " << index << " is out of range.";
+            return false;
+        }
+        indices[i] = static_cast<uint32_t>(index);
+    }
+    auto indicesAccessor = addAccessor(bufferView, COMPONENT_UNSIGNED_INT, triangleCount, "SCALAR");
+
+    // glTF only has a single normal attribute, further sets are dropped.
+    if (!meshData.normals.empty()) {
+        if (meshData.normals.size() > 1)
+            Log::warning() << "Warning: mesh " << meshName << " has more than one normal set, using first.";
+
+        const auto& normalSet = meshData.normals[0];
+        if (normalSet.size() != positionsCount) {
+            Log::error() << "Error: Invalid normal set detected. ";
+            return false;
+        }
+
+        auto normals = allocate<float>(positionsCount * 3, TARGET_ARRAY_BUFFER, bufferView);
+        for (size_t i = 0; i < positionsCount; i++) {
+            const auto& normal = normalSet[i];
+            auto length = isVector3(normal) ? std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]) : 0.0;
+            for (auto axis = 0; axis < 3; axis++)
+                normals[i * 3 + axis] = length > 0 ? static_cast<float>(normal[axis] / length) : (axis == 1 ? 1.0f : 0.0f);
+        }
+        attributes["NORMAL"] = addAccessor(bufferView, COMPONENT_FLOAT, positionsCount, "VEC3");
+    }
+
+    for (size_t set = 0; set < meshData.uvs.size(); set++) {
+        const auto& uvSet = meshData.uvs[set];
+        if (uvSet.size() != positionsCount) {
+            Log::error() << "Error: Invalid UV set detected. ";
+            return false;
+        }
+
+        // Badger UVs already have their origin in the top left corner, like glTF.
+        auto uvs = allocate<float>(positionsCount * 2, TARGET_ARRAY_BUFFER, bufferView);
+        for (size_t i = 0; i < positionsCount; i++) {
+            uvs[i * 2] = uvSet[i].size() > 0 ? static_cast<float>(uvSet[i][0]) : 0.0f;
+            uvs[i * 2 + 1] = uvSet[i].size() > 1 ? static_cast<float>(uvSet[i][1]) : 0.0f;
+        }
+        attributes["TEXCOORD_" + std::to_string(set)] = addAccessor(bufferView, COMPONENT_FLOAT, positionsCount, "VEC2");
+    }
+
+    for (size_t set = 0; set < meshData.colors.size(); set++) {
+        const auto& colorSet = meshData.colors[set];
+        if (colorSet.size() != positionsCount) {
+            Log::error() << "Error: Invalid color set detected. ";
+            return false;
+        }
+
+        auto colors = allocate<float>(positionsCount * 4, TARGET_ARRAY_BUFFER, bufferView);
+        for (size_t i = 0; i < positionsCount; i++) {
+            for (size_t channel = 0; channel < 4; channel++)
+                colors[i * 4 + channel] = channel < colorSet[i].size() ? static_cast<float>(colorSet[i][channel]) : 1.0f;
+        }
+        attributes["COLOR_" + std::to_string(set)] = addAccessor(bufferView, COMPONENT_FLOAT, positionsCount, "VEC4");
+    }
+
+    // Influences are written four at a time into JOINTS_n/WEIGHTS_n pairs.
+    size_t maxInfluences = 0;
+    for (const auto& boneNames : meshData.indices)
+        maxInfluences = std::max(maxInfluences, boneNames.size());
+
+    auto skinned = maxInfluences > 0 && !jointNodes.empty();
+    for (size_t set = 0; skinned && set * 4 < maxInfluences; set++) {
+        size_t jointsView;
+        auto joints = allocate<uint16_t>(positionsCount * 4, TARGET_ARRAY_BUFFER, jointsView);
+        std::fill(joints, joints + positionsCount * 4, 0);
+
+        for (size_t i = 0; i < positionsCount; i++) {
+            const auto& boneNames = meshData.indices[i];
+            for (size_t influence = set * 4; influence < std::min(boneNames.size(), set * 4 + 4); influence++) {
+                auto joint = boneJoints.find(boneNames[influence]);
+                if (joint == boneJoints.end()) {
+                    Log::error() << "Error: could not find bone " << boneNames[influence] << ".";
+                    return false;
+                }
+                joints[i * 4 + influence % 4] = static_cast<uint16_t>(joint->second);
+            }
+        }
+
+        size_t weightsView;
+        auto weights = allocate<float>(positionsCount * 4, TARGET_ARRAY_BUFFER, weightsView);
+        std::fill(weights, weights + positionsCount * 4, 0.0f);
+
+        for (size_t i = 0; i < positionsCount; i++) {
+            const auto& vertexWeights = meshData.weights[i];
+            auto count = std::min(meshData.indices[i].size(), vertexWeights.size());
+            for (size_t influence = set * 4; influence < std::min(count, set * 4 + 4); influence++)
+                weights[i * 4 + influence % 4] = static_cast<float>(vertexWeights[influence]);
+        }
+
+        attributes["JOINTS_" + std::to_string(set)] = addAccessor(jointsView, COMPONENT_UNSIGNED_SHORT, positionsCount, "VEC4");
+        attributes["WEIGHTS_" + std::to_string(set)] = addAccessor(weightsView, COMPONENT_FLOAT, positionsCount, "VEC4");
+    }
+
+    json primitive {
+        {"attributes", attributes},
+        {"indices", indicesAccessor},
+        {"mode", 4}
+    };
+
+    auto material = exportMaterial(meshData.material);
+    if (material < 0)
+        return false;
+    primitive["material"] = material;
+
+    document["meshes"].push_back({
+        {"name", meshName},
+        {"primitives", json::array({ primitive })}
+    });
+
+    json node {
+        {"name", nodeName},
+        {"mesh", document["meshes"].size() - 1}
+    };
+    if (skinned)
+        node["skin"] = 0;
+
+    document["scenes"][0]["nodes"].push_back(document["nodes"].size());
+    document["nodes"].push_back(node);
+
+    return true;
+}
+
+int GltfExporter::exportMaterial(const std::string& name) {
+    if (auto it = exportedMaterials.find(name); it != exportedMaterials.end())
+        return it->second;
+
+    Log::verbose() << "Exporting material " << name << ".";
+
+    auto materialData = loader->getMaterial(name);
+    if (!materialData) {
+        return -1;
+    }
+
+    const auto& textures = materialData->info.textures;
+    auto materialName = materialData->baseName.empty() ? materialData->name : (materialData->name + "___" + materialData->baseName);
+
+    json pbr {
+        {"metallicFactor", 0.0},
+        {"roughnessFactor", 1.0}
+    };
+
+    json material {
+        {"name", materialName},
+        {"doubleSided", materialData->info.culling == "none"}
+    };
+
+    // The coefficient map packs channels differently from glTF's metallic-roughness texture and
+    // emissive maps are HDR, so only the color and normal maps are embedded.
+    if (!textures.diffuse.empty()) {
+        if (auto texture = exportTexture(textures.diffuse + ".png"); texture >= 0)
+            pbr["baseColorTexture"] = { {"index", texture} };
+    }
+
+    if (!textures.normal.empty()) {
+        if (auto texture = exportTexture(textures.normal + ".png"); texture >= 0)
+            material["normalTexture"] = { {"index", texture} };
+    }
+
+    material["pbrMetallicRoughness"] = pbr;
+
+    document["materials"].push_back(material);
+    auto index = static_cast<int>(document["materials"].size() - 1);
+    exportedMaterials.insert({name, index});
+    return index;
+}
+
+int GltfExporter::exportTexture(const std::string& path) {
+    if (auto it = exportedTextures.find(path); it != exportedTextures.end())
+        return it->second;
+
+    // Textures of archive packs are read from the archive.
+    ResourceData file;
+    if (!loader->readFile(path, file)) {
+        Log::warning() << "Warning: could not read texture " << path << ", it will not be embedded.";
+        exportedTextures.insert({path, -1});
+        return -1;
+    }
+
+    size_t bufferView;
+    auto data = allocate<char>(file.bytes.size(), TARGET_NONE, bufferView);
+    std::copy(file.bytes.begin(), file.bytes.end(), data);
+
+    document["images"].push_back({
+        {"name", std::filesystem::path(path).stem().string()},
+        {"bufferView", bufferView},
+        {"mimeType", "image/png"}
+    });
+
+    document["textures"].push_back({
+        {"source", document["images"].size() - 1}
+    });
+
+    auto index = static_cast<int>(document["textures"].size() - 1);
+    exportedTextures.insert({path, index});
+    return index;
+}
+
+bool GltfExporter::exportAnimation(const std::string& name, const Badger::Animation& badgerAnimation) {
+    json animation {
+        {"name", name},
+        {"samplers", json::array()},
+        {"channels", json::array()}
+    };
+
+    // Keyframes are offsets from the bind pose, like in the FBX export.
+    auto addChannel = [&](size_t node, const char* path, const std::unordered_map<double, Badger::AnimationProperty>& keyframeInfo, const Badger::Vector3f& base) {
+        std::vector<std::pair<double, const Badger::AnimationProperty*>> keyframes;
+        keyframes.reserve(keyframeInfo.size());
+        for (const auto& keyframe : keyframeInfo) {
+            if (keyframe.second.post.size() >= 3)
+                keyframes.emplace_back(keyframe.first, &keyframe.second);
+        }
+
+        if (keyframes.empty())
+            return;
+
+        std::sort(keyframes.begin(), keyframes.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        // Offsets per axis and key. Catmull-Rom segments are sampled from the same Hermite curves the FBX
+        // export writes, so both formats play the spline back alike.
+        std::vector<double> keyTimes;
+        std::vector<char> smooth;
+        for (const auto& keyframe : keyframes) {
+            keyTimes.push_back(keyframe.first);
+            smooth.push_back(keyframe.second->lerpMode == "catmullrom");
+        }
+
+        std::array<std::vector<KeyTangents>, 3> tangents;
+        for (auto axis = 0; axis < 3; axis++) {
+            std::vector<double> axisValues;
+            for (const auto& keyframe : keyframes)
+                axisValues.push_back(keyframe.second->post[axis]);
+            tangents[axis] = catmullRomTangents(keyTimes, axisValues, smooth);
+        }
+
+        std::vector<std::pair<double, std::array<double, 3>>> samples;
+        for (size_t i = 0; i < keyframes.size(); i++) {
+            const auto& post = keyframes[i].second->post;
+            samples.push_back({ keyTimes[i], { post[0], post[1], post[2] } });
+
+            if (i + 1 == keyframes.size() || !tangents[0][i].cubic)
+                continue;
+
+            const auto& nextPost = keyframes[i + 1].second->post;
+            auto length = keyTimes[i + 1] - keyTimes[i];
+            for (size_t step = 1; step < SMOOTH_SEGMENT_STEPS; step++) {
+                auto u = static_cast<double>(step) / SMOOTH_SEGMENT_STEPS;
+                auto u2 = u * u;
+                auto u3 = u2 * u;
+                std::array<double, 3> value;
+                for (auto axis = 0; axis < 3; axis++) {
+                    const auto& tangent = tangents[axis][i];
+                    value[axis] = (2 * u3 - 3 * u2 + 1) * post[axis] + (u3 - 2 * u2 + u) * length * tangent.rightSlope
+                        + (3 * u2 - 2 * u3) * nextPost[axis] + (u3 - u2) * length * tangent.nextLeftSlope;
+                }
+                samples.push_back({ keyTimes[i] + u * length, value });
+            }
+        }
+
+        size_t inputView;
+        auto times = allocate<float>(samples.size(), TARGET_NONE, inputView);
+        for (size_t i = 0; i < samples.size(); i++)
+            times[i] = static_cast<float>(samples[i].first);
+
+        auto input = addAccessor(inputView, COMPONENT_FLOAT, samples.size(), "SCALAR",
+            json::array({ times[0] }), json::array({ times[samples.size() - 1] }));
+
+        auto isRotation = std::strcmp(path, "rotation") == 0;
+        auto components = isRotation ? 4 : 3;
+
+        size_t outputView;
+        auto values = allocate<float>(samples.size() * components, TARGET_NONE, outputView);
+        for (size_t i = 0; i < samples.size(); i++) {
+            const auto& offset = samples[i].second;
+            if (isRotation) {
+                auto quaternion = eulerToQuaternion(base[0] + offset[0], base[1] + offset[1], base[2] + offset[2]);
+                for (auto component = 0; component < 4; component++)
+                    values[i * 4 + component] = static_cast<float>(quaternion[component]);
+            } else {
+                for (auto component = 0; component < 3; component++)
+                    values[i * 3 + component] = static_cast<float>(base[component] + offset[component]);
+            }
+        }
+
+        auto output = addAccessor(outputView, COMPONENT_FLOAT, samples.size(), isRotation ? "VEC4" : "VEC3");
+
+        animation["channels"].push_back({
+            {"sampler", animation["samplers"].size()},
+            {"target", { {"node", node}, {"path", path} }}
+        });
+
+        animation["samplers"].push_back({
+            {"input", input},
+            {"output", output},
+            {"interpolation", "LINEAR"}
+        });
+    };
+
+    // Bones are sorted so the written channels do not depend on the hash map order.
+    std::vector<std::pair<size_t, const Badger::AnimationBone*>> bones;
+    for (const auto& boneAnimation : badgerAnimation.bones) {
+        auto joint = boneJoints.find(boneAnimation.first);
+        if (joint == boneJoints.end()) {
+            Log::error() << "Error: could not find bone " << boneAnimation.first << " in the scene.";
+            return false;
+        }
+        bones.emplace_back(joint->second, &boneAnimation.second);
+    }
+    std::sort(bones.begin(), bones.end());
+
+    for (const auto& [joint, boneAnimation] : bones) {
+        auto node = jointNodes[joint];
+        const auto& bone = *jointBones[joint];
+
+        addChannel(node, "translation", boneAnimation->position, bone.pivot);
+        addChannel(node, "rotation", boneAnimation->rotation, bone.info.bindPoseRotation);
+        addChannel(node, "scale", boneAnimation->scale, bone.scale);
+    }
+
+    if (animation["channels"].empty())
+        return true;
+
+    document["animations"].push_back(animation);
+    return true;
+}
+
+bool GltfExporter::write(const char* output) {
+    if (!binary.empty())
+        document["buffers"] = json::array({ json { {"byteLength", binary.size()} } });
+
+    auto jsonChunk = document.dump();
+    jsonChunk.append((4 - jsonChunk.size() % 4) % 4, ' ');
+
+    // The GLB header stores all lengths in 32 bits.
+    auto total = 12 + 8 + static_cast<uint64_t>(jsonChunk.size()) + (binary.empty() ? 0 : 8 + static_cast<uint64_t>(binary.size()));
+    if (total > std::numeric_limits<uint32_t>::max()) {
+        Log::error() << "Error: " << output << " would be " << total << " bytes, more than a glb can hold.";
+        return false;
+    }
+
+    auto binaryLength = static_cast<uint32_t>(binary.size());
+    auto totalLength = static_cast<uint32_t>(total);
+    auto jsonLength = static_cast<uint32_t>(jsonChunk.size());
+
+    std::ofstream file(output, std::ios::out | std::ios::binary);
+    if (!file) {
+        Log::error() << "Error: could not open " << output << " for writing.";
+        return false;
+    }
+
+    auto writeUint32 = [&](uint32_t value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    writeUint32(GLB_MAGIC);
+    writeUint32(GLB_VERSION);
+    writeUint32(totalLength);
+
+    writeUint32(jsonLength);
+    writeUint32(CHUNK_JSON);
+    file.write(jsonChunk.data(), jsonChunk.size());
+
+    if (!binary.empty()) {
+        writeUint32(binaryLength);
+        writeUint32(CHUNK_BIN);
+        file.write(reinterpret_cast<const char*>(binary.data()), binary.size());
+    }
+
+    file.close();
+    if (!file) {
+        Log::error() << "Error: failed to write " << output << ".";
+        return false;
+    }
+
+    return true;
+}
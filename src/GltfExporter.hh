@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "ResourceLoader.hh"
+#include "Stopwatch.hh"
+
+#include <string>
+#include <vector>
+
+// Writes Badger models with their meta-materials and animations directly to binary glTF,
+// without going through the FBX SDK. Bones become a skin, keyframe tracks become animation samplers.
+class GltfExporter {
+    public:
+        explicit GltfExporter(const char* resourcePacksDir);
+        explicit GltfExporter(ResourceLoader& loader);
+        ~GltfExporter();
+
+        bool convertToGlb(const char* model, const char* output);
+        const PhaseTimings& getTimings() const { return timings; }
+    private:
+        GltfExporter(ResourceLoader* loader, bool ownsLoader);
+        void resetDocument();
+
+        // Appends a 4 byte aligned region to the binary chunk and returns its buffer view index.
+        size_t addBufferView(size_t byteLength, int target, size_t& offset);
+        template <typename T>
+        T* allocate(size_t count, int target, size_t& bufferView);
+        size_t addAccessor(size_t bufferView, int componentType, size_t count, const char* type, const json& min = nullptr, const json& max = nullptr);
+
+        bool exportBones(const Badger::Geometry& geometry);
+        bool exportMesh(const Badger::Mesh& mesh, size_t meshId);
+        bool exportAnimation(const std::string& name, const Badger::Animation& animation);
+        int exportMaterial(const std::string& name);
+        int exportTexture(const std::string& path);
+        bool write(const char* output);
+
+        ResourceLoader* loader;
+        bool ownsLoader;
+        json document;
+        std::vector<unsigned char> binary;
+        // Skin joints in bone order, with the node and the source bone of each joint.
+        std::unordered_map<Symbol, size_t> boneJoints;
+        std::vector<size_t> jointNodes;
+        std::vector<const Badger::Bone*> jointBones;
+        std::unordered_map<Symbol, int> exportedMaterials;
+        std::unordered_map<std::string, int> exportedTextures;
+        PhaseTimings timings;
+};
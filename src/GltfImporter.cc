@@ -0,0 +1,1008 @@
+#include "GltfImporter.hh"
+#include "BadgerWriter.hh"
+#include "Log.hh"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <new>
+#include <numbers>
+
+namespace {
+    constexpr uint32_t GLB_MAGIC = 0x46546C67;
+    constexpr uint32_t CHUNK_JSON = 0x4E4F534A;
+    constexpr uint32_t CHUNK_BIN = 0x004E4942;
+
+    constexpr int COMPONENT_BYTE = 5120;
+    constexpr int COMPONENT_UNSIGNED_BYTE = 5121;
+    constexpr int COMPONENT_SHORT = 5122;
+    constexpr int COMPONENT_UNSIGNED_SHORT = 5123;
+    constexpr int COMPONENT_UNSIGNED_INT = 5125;
+    constexpr int COMPONENT_FLOAT = 5126;
+
+    constexpr size_t NO_NODE = static_cast<size_t>(-1);
+
+    size_t componentSize(int componentType) {
+        switch (componentType) {
+            case COMPONENT_BYTE:
+            case COMPONENT_UNSIGNED_BYTE:
+                return 1;
+            case COMPONENT_SHORT:
+            case COMPONENT_UNSIGNED_SHORT:
+                return 2;
+            case COMPONENT_UNSIGNED_INT:
+            case COMPONENT_FLOAT:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    size_t componentCount(const std::string& type) {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4" || type == "MAT2")
+            return 4;
+        if (type == "MAT3")
+            return 9;
+        if (type == "MAT4")
+            return 16;
+        return 0;
+    }
+
+    template <typename T>
+    T readUnaligned(const unsigned char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    float readComponent(const unsigned char* data, int componentType, bool normalized) {
+        switch (componentType) {
+            case COMPONENT_BYTE: {
+                auto value = readUnaligned<int8_t>(data);
+                return normalized ? std::max(value / 127.0f, -1.0f) : value;
+            }
+            case COMPONENT_UNSIGNED_BYTE: {
+                auto value = readUnaligned<uint8_t>(data);
+                return normalized ? value / 255.0f : value;
+            }
+            case COMPONENT_SHORT: {
+                auto value = readUnaligned<int16_t>(data);
+                return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+            }
+            case COMPONENT_UNSIGNED_SHORT: {
+                auto value = readUnaligned<uint16_t>(data);
+                return normalized ? value / 65535.0f : value;
+            }
+            case COMPONENT_UNSIGNED_INT:
+                return static_cast<float>(readUnaligned<uint32_t>(data));
+            default:
+                return readUnaligned<float>(data);
+        }
+    }
+
+    bool decodeBase64(std::string_view input, std::vector<unsigned char>& output) {
+        static constexpr std::string_view ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        output.clear();
+        output.reserve(input.size() / 4 * 3);
+
+        uint32_t accumulator = 0;
+        auto bits = 0;
+        for (auto c : input) {
+            if (c == '=')
+                break;
+
+            auto value = ALPHABET.find(c);
+            if (value == std::string_view::npos)
+                return false;
+
+            accumulator = (accumulator << 6) | static_cast<uint32_t>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                output.push_back(static_cast<unsigned char>((accumulator >> bits) & 0xFF));
+            }
+        }
+
+        return true;
+    }
+
+    std::string decodeUri(const std::string& uri) {
+        std::string decoded;
+        decoded.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); i++) {
+            if (uri[i] == '%' && i + 2 < uri.size() && std::isxdigit(uri[i + 1]) && std::isxdigit(uri[i + 2])) {
+                decoded.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+                i += 2;
+            } else {
+                decoded.push_back(uri[i]);
+            }
+        }
+        return decoded;
+    }
+
+    bool readFile(const std::filesystem::path& path, std::vector<unsigned char>& content) {
+        std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!file)
+            return false;
+
+        content.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(content.data()), static_cast<std::streamsize>(content.size())));
+    }
+
+    // Euler angles in degrees for a row-major rotation matrix, in the X, Y, Z order Badger and FBX use.
+    Badger::Vector3f rotationToEuler(const std::array<double, 9>& r) {
+        auto toDegrees = 180.0 / std::numbers::pi;
+        auto sinY = std::clamp(-r[6], -1.0, 1.0);
+
+        if (std::abs(sinY) < 0.9999) {
+            return {
+                std::atan2(r[7], r[8]) * toDegrees,
+                std::asin(sinY) * toDegrees,
+                std::atan2(r[3], r[0]) * toDegrees
+            };
+        }
+
+        // Gimbal lock, the Z rotation is folded into X.
+        return {
+            std::atan2(-r[5], r[4]) * toDegrees,
+            std::asin(sinY) * toDegrees,
+            0.0
+        };
+    }
+
+    Badger::Vector3f quaternionToEuler(double x, double y, double z, double w) {
+        auto length = std::sqrt(x * x + y * y + z * z + w * w);
+        if (length == 0)
+            return { 0, 0, 0 };
+
+        x /= length;
+        y /= length;
+        z /= length;
+        w /= length;
+
+        return rotationToEuler({
+            1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y),
+            2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x),
+            2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y)
+        });
+    }
+
+    // Local transform of a node as Badger translation, euler rotation and scale.
+    void nodeTransform(const json& node, Badger::Vector3f& translation, Badger::Vector3f& rotation, Badger::Vector3f& scale) {
+        if (node.contains("matrix")) {
+            auto m = node.at("matrix").get<std::vector<double>>();
+            if (m.size() == 16) {
+                translation = { m[12], m[13], m[14] };
+                scale = {
+                    std::sqrt(m[0] * m[0] + m[1] * m[1] + m[2] * m[2]),
+                    std::sqrt(m[4] * m[4] + m[5] * m[5] + m[6] * m[6]),
+                    std::sqrt(m[8] * m[8] + m[9] * m[9] + m[10] * m[10])
+                };
+
+                auto determinant = m[0] * (m[5] * m[10] - m[9] * m[6]) - m[4] * (m[1] * m[10] - m[9] * m[2]) + m[8] * (m[1] * m[6] - m[5] * m[2]);
+                if (determinant < 0)
+                    scale[0] = -scale[0];
+
+                auto sx = scale[0] != 0 ? scale[0] : 1.0;
+                auto sy = scale[1] != 0 ? scale[1] : 1.0;
+                auto sz = scale[2] != 0 ? scale[2] : 1.0;
+                rotation = rotationToEuler({
+                    m[0] / sx, m[4] / sy, m[8] / sz,
+                    m[1] / sx, m[5] / sy, m[9] / sz,
+                    m[2] / sx, m[6] / sy, m[10] / sz
+                });
+                return;
+            }
+        }
+
+        translation = node.value("translation", std::vector<double> { 0, 0, 0 });
+        scale = node.value("scale", std::vector<double> { 1, 1, 1 });
+
+        auto quaternion = node.value("rotation", std::vector<double> { 0, 0, 0, 1 });
+        rotation = quaternion.size() == 4 ? quaternionToEuler(quaternion[0], quaternion[1], quaternion[2], quaternion[3]) : Badger::Vector3f { 0, 0, 0 };
+    }
+}
+
+void GltfImporter::reset() {
+    document = json();
+    buffers.clear();
+    jointNodes.clear();
+    boneNames.clear();
+    boneIndices.clear();
+    exportedImages.clear();
+    exportedMaterials.clear();
+    exportedAnimations.clear();
+
+    model = Badger::Model();
+    model.formatVersion = "1.14.0";
+}
+
+bool GltfImporter::convertToBadger(const char* gltf, const char* outputDirectory) {
+    reset();
+    timings.clear();
+    Stopwatch stopwatch;
+
+    std::filesystem::path inputPath(gltf);
+    inputName = inputPath.stem().string();
+    inputDirectory = inputPath.parent_path();
+    textureDirectory = std::filesystem::path(outputDirectory) / "textures" / "entity";
+
+    Log::info() << "Importing glTF.";
+
+    if (!readDocument(inputPath))
+        return false;
+    timings.record("read", stopwatch);
+
+    try {
+        Badger::Geometry geometry;
+        geometry.description.identifier = "geometry." + inputName;
+
+        if (!document.contains("nodes"))
+            document["nodes"] = json::array();
+
+        const auto& nodes = document.at("nodes");
+        auto nodeCount = nodes.size();
+
+        if (document.contains("skins")) {
+            for (const auto& skin : document.at("skins")) {
+                for (const auto& joint : skin.at("joints"))
+                    jointNodes.insert(joint.get<size_t>());
+            }
+        }
+
+        std::vector<size_t> parents(nodeCount, NO_NODE);
+        for (size_t i = 0; i < nodeCount; i++) {
+            if (!nodes[i].contains("children"))
+                continue;
+
+            for (const auto& child : nodes[i].at("children")) {
+                auto childIndex = child.get<size_t>();
+                if (childIndex >= nodeCount || parents[childIndex] != NO_NODE) {
+                    Log::error() << "Error: node " << i << " has an invalid child " << childIndex << ".";
+                    return false;
+                }
+                parents[childIndex] = i;
+            }
+        }
+
+        std::vector<size_t> roots;
+        if (document.contains("scenes") && !document.at("scenes").empty()) {
+            const auto& scene = document.at("scenes").at(document.value("scene", 0));
+            if (scene.contains("nodes"))
+                roots = scene.at("nodes").get<std::vector<size_t>>();
+        } else {
+            for (size_t i = 0; i < nodeCount; i++) {
+                if (parents[i] == NO_NODE)
+                    roots.push_back(i);
+            }
+        }
+
+        // Bones are exported during the walk, parents before their children. Meshes are only collected.
+        std::vector<size_t> meshNodes;
+        std::vector<char> visited(nodeCount, false);
+
+        std::function<bool(size_t)> processNode = [&](size_t node) {
+            if (node >= nodeCount || visited[node]) {
+                Log::error() << "Error: invalid node hierarchy at node " << node << ".";
+                return false;
+            }
+            visited[node] = true;
+
+            if (jointNodes.contains(node)) {
+                auto parent = parents[node] != NO_NODE && jointNodes.contains(parents[node]) ? parents[node] : NO_NODE;
+                if (!exportBone(geometry, node, parent))
+                    return false;
+            }
+
+            if (nodes[node].contains("mesh"))
+                meshNodes.push_back(node);
+
+            if (nodes[node].contains("children")) {
+                for (const auto& child : nodes[node].at("children")) {
+                    if (!processNode(child.get<size_t>()))
+                        return false;
+                }
+            }
+
+            return true;
+        };
+
+        for (auto root : roots) {
+            if (!processNode(root))
+                return false;
+        }
+        timings.record("bones", stopwatch);
+
+        Log::info() << "Exporting " << meshNodes.size() << " meshes.";
+
+        for (auto nodeIndex : meshNodes) {
+            const auto& node = nodes[nodeIndex];
+            const auto& mesh = document.at("meshes").at(node.at("mesh").get<size_t>());
+
+            for (const auto& primitive : mesh.at("primitives")) {
+                if (primitive.value("mode", 4) != 4) {
+                    Log::warning() << "Warning: skipping non-triangle primitive of node " << node.value("name", std::to_string(nodeIndex)) << ".";
+                    continue;
+                }
+
+                Badger::Mesh badgerMesh;
+                if (!exportMesh(badgerMesh, primitive, node)) {
+                    Log::error() << "Error: failed to export mesh of node " << node.value("name", std::to_string(nodeIndex)) << ".";
+                    return false;
+                }
+
+                if (!primitive.contains("material")) {
+                    Log::error() << "Error: mesh has no material.";
+                    return false;
+                }
+
+                if (!exportMaterial(primitive.at("material").get<size_t>(), badgerMesh.material))
+                    return false;
+
+                geometry.meshes.push_back(std::move(badgerMesh));
+            }
+        }
+        timings.record("extract", stopwatch);
+
+        if (document.contains("animations")) {
+            Log::info() << "Exporting animations.";
+            const auto& animations = document.at("animations");
+            for (size_t i = 0; i < animations.size(); i++) {
+                if (!exportAnimation(geometry, animations[i], i)) {
+                    Log::error() << "Error: failed to export animation.";
+                    return false;
+                }
+            }
+        }
+        timings.record("animations", stopwatch);
+
+        if (geometry.bones.empty()) {
+            Badger::Bone bone {
+                .info {
+                    .bindPoseRotation {
+                        0, 0, 0
+                    }
+                },
+                .locators = {},
+                .name = "minecraft:geometry_root_bone",
+                .parent = "",
+                .pivot = {
+                    0, 0, 0
+                },
+                .scale {
+                    1, 1, 1
+                }
+            };
+
+            geometry.bones.push_back(bone);
+        }
+
+        model.geometry.push_back(std::move(geometry));
+    } catch (const json::exception& e) {
+        Log::error() << "Error: invalid glTF document (" << e.what() << ").";
+        return false;
+    } catch (const std::bad_alloc&) {
+        Log::error() << "Error: glTF document is too large to convert.";
+        return false;
+    }
+
+    if (!writeBadgerPack(outputDirectory, inputName, model, exportedMaterials, exportedAnimations))
+        return false;
+
+    timings.record("write", stopwatch);
+
+    Log::info() << "Export finished.";
+
+    return true;
+}
+
+bool GltfImporter::readDocument(const std::filesystem::path& path) {
+    std::vector<unsigned char> content;
+    if (!readFile(path, content)) {
+        Log::error() << "Error: failed to read " << path.string() << ".";
+        return false;
+    }
+
+    std::vector<unsigned char> binaryChunk;
+
+    try {
+        if (content.size() >= 12 && readUnaligned<uint32_t>(content.data()) == GLB_MAGIC) {
+            auto version = readUnaligned<uint32_t>(content.data() + 4);
+            auto length = readUnaligned<uint32_t>(content.data() + 8);
+            if (version != 2 || length > content.size()) {
+                Log::error() << "Error: unsupported or truncated glb file.";
+                return false;
+            }
+
+            auto hasJson = false;
+            size_t offset = 12;
+            while (offset + 8 <= length) {
+                auto chunkLength = readUnaligned<uint32_t>(content.data() + offset);
+                auto chunkType = readUnaligned<uint32_t>(content.data() + offset + 4);
+                offset += 8;
+
+                if (chunkLength > length - offset) {
+                    Log::error() << "Error: glb chunk exceeds the file length.";
+                    return false;
+                }
+
+                auto chunk = content.data() + offset;
+                if (chunkType == CHUNK_JSON && !hasJson) {
+                    document = json::parse(chunk, chunk + chunkLength);
+                    hasJson = true;
+                } else if (chunkType == CHUNK_BIN && binaryChunk.empty()) {
+                    binaryChunk.assign(chunk, chunk + chunkLength);
+                }
+
+                offset += (chunkLength + 3) & ~size_t(3);
+            }
+
+            if (!hasJson) {
+                Log::error() << "Error: glb file has no JSON chunk.";
+                return false;
+            }
+        } else {
+            document = json::parse(content.begin(), content.end());
+        }
+    } catch (const json::exception& e) {
+        Log::error() << "Error: failed to parse glTF JSON (" << e.what() << ").";
+        return false;
+    } catch (const std::bad_alloc&) {
+        Log::error() << "Error: glTF JSON is too large to parse.";
+        return false;
+    }
+
+    const auto& asset = document.contains("asset") ? document.at("asset") : json::object();
+    if (!asset.value("version", std::string()).starts_with("2.")) {
+        Log::error() << "Error: only glTF 2.0 is supported.";
+        return false;
+    }
+
+    if (document.contains("extensionsRequired")) {
+        for (const auto& extension : document.at("extensionsRequired")) {
+            Log::error() << "Error: required glTF extension " << extension.get<std::string>() << " is not supported.";
+            return false;
+        }
+    }
+
+    return loadBuffers(path.parent_path(), binaryChunk);
+}
+
+bool GltfImporter::loadBuffers(const std::filesystem::path& directory, std::vector<unsigned char>& binaryChunk) {
+    if (!document.contains("buffers"))
+        return true;
+
+    const auto& bufferInfos = document.at("buffers");
+    buffers.resize(bufferInfos.size());
+
+    for (size_t i = 0; i < bufferInfos.size(); i++) {
+        const auto& info = bufferInfos[i];
+        auto byteLength = info.at("byteLength").get<size_t>();
+        auto& buffer = buffers[i];
+
+        if (!info.contains("uri")) {
+            if (i != 0 || binaryChunk.empty()) {
+                Log::error() << "Error: buffer " << i << " has no data.";
+                return false;
+            }
+            buffer = std::move(binaryChunk);
+        } else if (auto uri = info.at("uri").get<std::string>(); uri.starts_with("data:")) {
+            auto separator = uri.find(";base64,");
+            if (separator == std::string::npos || !decodeBase64(std::string_view(uri).substr(separator + 8), buffer)) {
+                Log::error() << "Error: buffer " << i << " has an invalid data uri.";
+                return false;
+            }
+        } else if (!readFile(directory / decodeUri(uri), buffer)) {
+            Log::error() << "Error: failed to read buffer " << uri << ".";
+            return false;
+        }
+
+        if (buffer.size() < byteLength) {
+            Log::error() << "Error: buffer " << i << " is shorter than its byteLength.";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool GltfImporter::getAccessor(size_t index, Accessor& accessor) const {
+    const auto& info = document.at("accessors").at(index);
+
+    if (info.contains("sparse") || !info.contains("bufferView")) {
+        Log::error() << "Error: accessor " << index << " is sparse or has no buffer view, this is not supported.";
+        return false;
+    }
+
+    accessor.count = info.at("count").get<size_t>();
+    accessor.componentType = info.at("componentType").get<int>();
+    accessor.components = componentCount(info.at("type").get<std::string>());
+    accessor.normalized = info.value("normalized", false);
+
+    auto elementSize = accessor.components * componentSize(accessor.componentType);
+    if (elementSize == 0) {
+        Log::error() << "Error: accessor " << index << " has an unsupported type.";
+        return false;
+    }
+
+    const auto& view = document.at("bufferViews").at(info.at("bufferView").get<size_t>());
+    auto bufferIndex = view.at("buffer").get<size_t>();
+    auto viewOffset = view.value("byteOffset", size_t(0));
+    auto viewLength = view.at("byteLength").get<size_t>();
+    auto offset = info.value("byteOffset", size_t(0));
+
+    accessor.stride = view.value("byteStride", elementSize);
+
+    if (accessor.count == 0) {
+        Log::error() << "Error: accessor " << index << " is empty.";
+        return false;
+    }
+
+    if (view.contains("byteStride") && (accessor.stride < elementSize || accessor.stride % 4 != 0)) {
+        Log::error() << "Error: accessor " << index << " has an invalid byte stride.";
+        return false;
+    }
+
+    // Written as subtractions, sizes come straight from the file and sums could wrap.
+    if (bufferIndex >= buffers.size() || viewOffset > buffers[bufferIndex].size() || viewLength > buffers[bufferIndex].size() - viewOffset
+        || offset > viewLength || elementSize > viewLength - offset
+        || accessor.count - 1 > (viewLength - offset - elementSize) / accessor.stride) {
+        Log::error() << "Error: accessor " << index << " exceeds its buffer.";
+        return false;
+    }
+
+    accessor.data = buffers[bufferIndex].data() + viewOffset + offset;
+    return true;
+}
+
+bool GltfImporter::readFloats(size_t index, size_t components, std::vector<float>& values) const {
+    Accessor accessor;
+    if (!getAccessor(index, accessor))
+        return false;
+
+    if (accessor.components != components) {
+        Log::error() << "Error: accessor " << index << " has " << accessor.components << " components, expected " << components << ".";
+        return false;
+    }
+
+    values.resize(accessor.count * components);
+
+    // Tightly packed floats are copied as a whole.
+    if (accessor.componentType == COMPONENT_FLOAT && accessor.stride == components * sizeof(float)) {
+        std::memcpy(values.data(), accessor.data, values.size() * sizeof(float));
+        return true;
+    }
+
+    auto size = componentSize(accessor.componentType);
+    for (size_t i = 0; i < accessor.count; i++) {
+        auto element = accessor.data + i * accessor.stride;
+        for (size_t component = 0; component < components; component++)
+            values[i * components + component] = readComponent(element + component * size, accessor.componentType, accessor.normalized);
+    }
+
+    return true;
+}
+
+bool GltfImporter::readIntegers(size_t index, size_t components, std::vector<int>& values) const {
+    Accessor accessor;
+    if (!getAccessor(index, accessor))
+        return false;
+
+    if (accessor.components != components || accessor.componentType == COMPONENT_FLOAT || accessor.normalized) {
+        Log::error() << "Error: accessor " << index << " does not hold integers with " << components << " components.";
+        return false;
+    }
+
+    values.resize(accessor.count * components);
+
+    if (accessor.componentType == COMPONENT_UNSIGNED_INT && accessor.stride == components * sizeof(uint32_t)) {
+        std::memcpy(values.data(), accessor.data, values.size() * sizeof(uint32_t));
+        return true;
+    }
+
+    auto size = componentSize(accessor.componentType);
+    for (size_t i = 0; i < accessor.count; i++) {
+        auto element = accessor.data + i * accessor.stride;
+        for (size_t component = 0; component < components; component++)
+            values[i * components + component] = static_cast<int>(readComponent(element + component * size, accessor.componentType, false));
+    }
+
+    return true;
+}
+
+bool GltfImporter::exportBone(Badger::Geometry& geometry, size_t node, size_t parent) {
+    const auto& nodes = document.at("nodes");
+    const auto& nodeInfo = nodes.at(node);
+
+    auto uniqueName = [&](const json& info, const char* prefix, size_t index) {
+        auto name = info.value("name", std::string());
+        if (name.empty())
+            return prefix + std::to_string(index);
+
+        for (const auto& bone : geometry.bones) {
+            if (bone.name == name)
+                return name + "_" + std::to_string(index);
+        }
+        return name;
+    };
+
+    Badger::Bone badgerBone {};
+    badgerBone.name = uniqueName(nodeInfo, "bone_", node);
+    nodeTransform(nodeInfo, badgerBone.pivot, badgerBone.info.bindPoseRotation, badgerBone.scale);
+
+    if (parent != NO_NODE)
+        badgerBone.parent = boneNames.at(parent);
+
+    // Plain children of a bone are its locators, like the null nodes in the FBX import.
+    if (nodeInfo.contains("children")) {
+        for (const auto& child : nodeInfo.at("children")) {
+            auto childIndex = child.get<size_t>();
+            const auto& childInfo = nodes.at(childIndex);
+            if (jointNodes.contains(childIndex) || childInfo.contains("mesh") || childInfo.contains("children"))
+                continue;
+
+            Badger::BoneLocator locator {};
+            Badger::Vector3f scale;
+            nodeTransform(childInfo, locator.offset, locator.rotation, scale);
+            badgerBone.locators.insert({childInfo.value("name", "locator_" + std::to_string(childIndex)), locator});
+        }
+    }
+
+    boneNames.insert({node, badgerBone.name});
+    boneIndices.insert({node, geometry.bones.size()});
+    geometry.bones.push_back(badgerBone);
+    return true;
+}
+
+bool GltfImporter::exportMesh(Badger::Mesh& badgerMesh, const json& primitive, const json& node) const {
+    const auto& attributes = primitive.at("attributes");
+    if (!attributes.contains("POSITION")) {
+        Log::error() << "Error: primitive has no positions.";
+        return false;
+    }
+
+    Log::verbose() << "Exporting positions.";
+
+    std::vector<float> values;
+    if (!readFloats(attributes.at("POSITION").get<size_t>(), 3, values))
+        return false;
+
+    auto positionsCount = values.size() / 3;
+    badgerMesh.positions.reserve(positionsCount);
+    for (size_t i = 0; i < positionsCount; i++)
+        badgerMesh.positions.push_back({ values[i * 3], values[i * 3 + 1], values[i * 3 + 2] });
+
+    Log::verbose() << "Exporting triangles.";
+
+    if (primitive.contains("indices")) {
+        if (!readIntegers(primitive.at("indices").get<size_t>(), 1, badgerMesh.triangles))
+            return false;
+    } else {
+        badgerMesh.triangles.resize(positionsCount);
+        for (size_t i = 0; i < positionsCount; i++)
+            badgerMesh.triangles[i] = static_cast<int>(i);
+    }
+
+    if (badgerMesh.triangles.size() % 3 != 0) {
+        Log::error() << "Error: the mesh is not triangulated.";
+        return false;
+    }
+
+    for (auto index : badgerMesh.triangles) {
+        if (index < 0 || static_cast<size_t>(index) >= positionsCount) {
+            Log::error() << "Error: triangle index " << index << " is out of range.";
+            return false;
+        }
+    }
+
+    if (attributes.contains("NORMAL")) {
+        Log::verbose() << "Exporting normals.";
+
+        if (!readFloats(attributes.at("NORMAL").get<size_t>(), 3, values) || values.size() != positionsCount * 3)
+            return false;
+
+        auto& normals = badgerMesh.normals.emplace_back(positionsCount);
+        for (size_t i = 0; i < positionsCount; i++)
+            normals[i] = { values[i * 3], values[i * 3 + 1], values[i * 3 + 2], 1.0 };
+    }
+
+    Log::verbose() << "Exporting UVs.";
+
+    // glTF and Badger both put the UV origin in the top left corner.
+    for (auto set = 0; attributes.contains("TEXCOORD_" + std::to_string(set)); set++) {
+        if (!readFloats(attributes.at("TEXCOORD_" + std::to_string(set)).get<size_t>(), 2, values) || values.size() != positionsCount * 2)
+            return false;
+
+        auto& uvs = badgerMesh.uvs.emplace_back(positionsCount);
+        for (size_t i = 0; i < positionsCount; i++)
+            uvs[i] = { values[i * 2], values[i * 2 + 1] };
+    }
+
+    Log::verbose() << "Exporting vertex colors.";
+
+    for (auto set = 0; attributes.contains("COLOR_" + std::to_string(set)); set++) {
+        auto accessorIndex = attributes.at("COLOR_" + std::to_string(set)).get<size_t>();
+
+        Accessor accessor;
+        if (!getAccessor(accessorIndex, accessor) || (accessor.components != 3 && accessor.components != 4))
+            return false;
+
+        auto components = accessor.components;
+        if (!readFloats(accessorIndex, components, values) || values.size() != positionsCount * components)
+            return false;
+
+        auto& colors = badgerMesh.colors.emplace_back(positionsCount);
+        for (size_t i = 0; i < positionsCount; i++) {
+            auto color = &values[i * components];
+            colors[i] = { color[0], color[1], color[2], components == 4 ? color[3] : 1.0 };
+        }
+    }
+
+    // Unskinned meshes still carry an (empty) weight list per position.
+    badgerMesh.weights.resize(positionsCount);
+
+    if (!node.contains("skin"))
+        return true;
+
+    Log::verbose() << "Exporting skin information.";
+
+    const auto& joints = document.at("skins").at(node.at("skin").get<size_t>()).at("joints");
+    badgerMesh.indices.resize(positionsCount);
+
+    std::vector<int> jointValues;
+    for (auto set = 0; attributes.contains("JOINTS_" + std::to_string(set)) && attributes.contains("WEIGHTS_" + std::to_string(set)); set++) {
+        if (!readIntegers(attributes.at("JOINTS_" + std::to_string(set)).get<size_t>(), 4, jointValues)
+            || !readFloats(attributes.at("WEIGHTS_" + std::to_string(set)).get<size_t>(), 4, values)
+            || jointValues.size() != positionsCount * 4 || values.size() != positionsCount * 4) {
+            Log::error() << "Error: invalid joints/weights set " << set << ".";
+            return false;
+        }
+
+        for (size_t i = 0; i < positionsCount * 4; i++) {
+            if (values[i] <= 0)
+                continue;
+
+            auto joint = static_cast<size_t>(jointValues[i]);
+            auto bone = joint < joints.size() ? boneNames.find(joints[joint].get<size_t>()) : boneNames.end();
+            if (bone == boneNames.end()) {
+                Log::error() << "Error: skin joint " << joint << " is not a bone in the scene.";
+                return false;
+            }
+
+            badgerMesh.indices[i / 4].push_back(bone->second);
+            badgerMesh.weights[i / 4].push_back(values[i]);
+        }
+    }
+
+    // The influences are already per vertex, so they go through the same limits as the FBX import in place.
+    MeshSource source;
+    source.boneNames = std::move(badgerMesh.indices);
+    source.weights = std::move(badgerMesh.weights);
+    if (auto pruned = limitInfluences(source, influenceLimits); pruned != 0)
+        Log::info() << "Pruned " << pruned << " skin influences from mesh " << node.value("name", std::string()) << ".";
+    badgerMesh.indices = std::move(source.boneNames);
+    badgerMesh.weights = std::move(source.weights);
+
+    return true;
+}
+
+bool GltfImporter::exportMaterial(size_t material, Symbol& name) {
+    const auto& info = document.at("materials").at(material);
+    auto fullName = info.value("name", std::string());
+    if (fullName.empty())
+        fullName = inputName + "_material_" + std::to_string(material);
+
+    if (auto it = exportedMaterials.find(fullName); it != exportedMaterials.end()) {
+        name = it->second.name;
+        return true;
+    }
+
+    Badger::MetaMaterial metaMaterial;
+    auto matDelim = fullName.rfind("___");
+    if (matDelim != std::string::npos) {
+        metaMaterial.name = fullName.substr(0, matDelim);
+        metaMaterial.baseName = fullName.substr(matDelim + 3);
+    } else {
+        metaMaterial.name = fullName;
+    }
+
+    metaMaterial.formatVersion = "1.8.0";
+    metaMaterial.info.culling = "none";
+
+    // Metallic-roughness and emissive maps do not match the Badger texture layouts and are left out.
+    if (info.contains("pbrMetallicRoughness") && info.at("pbrMetallicRoughness").contains("baseColorTexture"))
+        exportTexture(info.at("pbrMetallicRoughness").at("baseColorTexture"), metaMaterial.info.textures.diffuse);
+
+    if (info.contains("normalTexture"))
+        exportTexture(info.at("normalTexture"), metaMaterial.info.textures.normal);
+
+    name = metaMaterial.name;
+    exportedMaterials.insert({fullName, metaMaterial});
+    return true;
+}
+
+bool GltfImporter::exportTexture(const json& textureInfo, std::string& path) {
+    const auto& texture = document.at("textures").at(textureInfo.at("index").get<size_t>());
+    if (!texture.contains("source")) {
+        Log::warning() << "Warning: texture has no image source, skipping.";
+        return false;
+    }
+
+    auto imageIndex = texture.at("source").get<size_t>();
+    if (auto it = exportedImages.find(imageIndex); it != exportedImages.end()) {
+        path = it->second;
+        return !path.empty();
+    }
+
+    const auto& image = document.at("images").at(imageIndex);
+    auto uri = image.value("uri", std::string());
+    auto mimeType = image.value("mimeType", std::string());
+
+    std::string imagePath;
+    if (!uri.empty() && !uri.starts_with("data:")) {
+        auto filePath = inputDirectory / decodeUri(uri);
+        if (filePath.extension() != ".png")
+            Log::warning() << "Warning: image " << uri << " is not a png, skipping.";
+        else if (!std::filesystem::exists(filePath))
+            Log::warning() << "Warning: image " << uri << " does not exist, skipping.";
+        else
+            imagePath = filePath.string();
+    } else {
+        // Embedded images are extracted straight into the output textures.
+        std::vector<unsigned char> data;
+        if (!uri.empty()) {
+            auto separator = uri.find(";base64,");
+            if (separator != std::string::npos) {
+                mimeType = uri.substr(5, uri.find(';') - 5);
+                decodeBase64(std::string_view(uri).substr(separator + 8), data);
+            }
+        } else if (image.contains("bufferView")) {
+            const auto& view = document.at("bufferViews").at(image.at("bufferView").get<size_t>());
+            auto bufferIndex = view.at("buffer").get<size_t>();
+            auto offset = view.value("byteOffset", size_t(0));
+            auto length = view.at("byteLength").get<size_t>();
+            if (bufferIndex < buffers.size() && offset <= buffers[bufferIndex].size() && length <= buffers[bufferIndex].size() - offset)
+                data.assign(buffers[bufferIndex].begin() + offset, buffers[bufferIndex].begin() + offset + length);
+        }
+
+        if (mimeType != "image/png" || data.empty()) {
+            Log::warning() << "Warning: embedded image " << imageIndex << " is not a png, skipping.";
+        } else {
+            // Only the last component of the name is used, so it cannot point outside the texture directory.
+            auto name = std::filesystem::path(image.value("name", std::string())).filename().string();
+            if (name.empty() || name == "." || name == "..")
+                name = inputName + "_image_" + std::to_string(imageIndex);
+            auto filePath = textureDirectory / (name + ".png");
+
+            std::filesystem::create_directories(textureDirectory);
+            std::ofstream output(filePath, std::ios::out | std::ios::binary);
+            output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            output.close();
+
+            if (output)
+                imagePath = filePath.string();
+            else
+                Log::warning() << "Warning: failed to write " << filePath.string() << ".";
+        }
+    }
+
+    exportedImages.insert({imageIndex, imagePath});
+    path = imagePath;
+    return !path.empty();
+}
+
+bool GltfImporter::exportAnimation(const Badger::Geometry& geometry, const json& animation, size_t index) {
+    auto name = animation.value("name", std::string());
+    if (name.empty())
+        name = inputName + "_" + std::to_string(index);
+
+    if (!name.starts_with("animation."))
+        name = "animation." + name;
+
+    Badger::Animation badgerAnimation {
+        .animTimeUpdate = "(query.anim_time + (query.delta_time * 1))",
+        .blendWeight = "1",
+        .bones = {}
+    };
+
+    const auto& samplers = animation.at("samplers");
+    std::vector<float> times;
+    std::vector<float> values;
+
+    for (const auto& channel : animation.at("channels")) {
+        const auto& target = channel.at("target");
+        if (!target.contains("node"))
+            continue;
+
+        auto node = target.at("node").get<size_t>();
+        auto path = target.at("path").get<std::string>();
+
+        auto isTranslation = path == "translation";
+        auto isRotation = path == "rotation";
+        auto isScale = path == "scale";
+
+        if (!isTranslation && !isRotation && !isScale) {
+            Log::warning() << "Warning: unsupported animation path (" << path << "). Only translation, rotation and scale is supported.";
+            continue;
+        }
+
+        auto bone = boneIndices.find(node);
+        if (bone == boneIndices.end()) {
+            Log::warning() << "Warning: animation channel targets node " << node << ", which is not a bone.";
+            continue;
+        }
+
+        const auto& sampler = samplers.at(channel.at("sampler").get<size_t>());
+        auto interpolation = sampler.value("interpolation", std::string("LINEAR"));
+        auto isCubic = interpolation == "CUBICSPLINE";
+        size_t components = isRotation ? 4 : 3;
+
+        if (!readFloats(sampler.at("input").get<size_t>(), 1, times) || !readFloats(sampler.at("output").get<size_t>(), components, values))
+            return false;
+
+        if (values.size() != times.size() * components * (isCubic ? 3 : 1)) {
+            Log::error() << "Error: animation sampler input and output counts do not match.";
+            return false;
+        }
+
+        // Cubic splines are approximated with catmull-rom through their values, tangents are dropped.
+        std::string lerpMode = interpolation == "STEP" ? "step" : (isCubic ? "catmullrom" : "linear");
+
+        const auto& badgerBone = geometry.bones[bone->second];
+        const auto& base = isTranslation ? badgerBone.pivot : (isRotation ? badgerBone.info.bindPoseRotation : badgerBone.scale);
+
+        std::unordered_map<double, Badger::AnimationProperty> keyframeData;
+        auto previous = base;
+
+        for (size_t i = 0; i < times.size(); i++) {
+            auto value = &values[(isCubic ? i * 3 + 1 : i) * components];
+
+            Badger::Vector3f post;
+            if (isRotation) {
+                post = quaternionToEuler(value[0], value[1], value[2], value[3]);
+
+                // Keep each key on the same turn as the previous one (or the bind pose) so interpolation takes the short way.
+                for (size_t axis = 0; axis < 3; axis++) {
+                    while (post[axis] - previous[axis] > 180.0)
+                        post[axis] -= 360.0;
+                    while (post[axis] - previous[axis] < -180.0)
+                        post[axis] += 360.0;
+                }
+                previous = post;
+            } else {
+                post = { value[0], value[1], value[2] };
+            }
+
+            for (size_t axis = 0; axis < 3; axis++)
+                post[axis] -= base[axis];
+
+            keyframeData.insert({times[i], {
+                .lerpMode = lerpMode,
+                .post = post
+            }});
+        }
+
+        auto& animationBone = badgerAnimation.bones.try_emplace(badgerBone.name, Badger::AnimationBone { .lodDistance = 0, .rotation = {}, .position = {}, .scale = {} }).first->second;
+        if (isTranslation)
+            animationBone.position = keyframeData;
+        else if (isRotation)
+            animationBone.rotation = keyframeData;
+        else
+            animationBone.scale = keyframeData;
+    }
+
+    exportedAnimations.insert({name, badgerAnimation});
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "MeshBuilder.hh"
+#include "Stopwatch.hh"
+
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Imports glTF 2.0 files (.gltf and .glb) into the Badger format without going through the FBX SDK.
+// Accessors are mapped straight into mesh arrays, skin joints become bones and samplers become keyframe tracks.
+class GltfImporter {
+    public:
+        bool convertToBadger(const char* gltf, const char* outputFolder);
+        const PhaseTimings& getTimings() const { return timings; }
+
+        // Applied to skinned meshes after their joints are read.
+        InfluenceLimits influenceLimits;
+    private:
+        // A validated view of an accessor's elements inside one of the buffers.
+        struct Accessor {
+            const unsigned char* data;
+            size_t count;
+            size_t components;
+            int componentType;
+            size_t stride;
+            bool normalized;
+        };
+
+        void reset();
+        bool readDocument(const std::filesystem::path& path);
+        bool loadBuffers(const std::filesystem::path& directory, std::vector<unsigned char>& binaryChunk);
+
+        bool getAccessor(size_t index, Accessor& accessor) const;
+        bool readFloats(size_t index, size_t components, std::vector<float>& values) const;
+        bool readIntegers(size_t index, size_t components, std::vector<int>& values) const;
+
+        bool exportBone(Badger::Geometry& geometry, size_t node, size_t parent);
+        bool exportMesh(Badger::Mesh& badgerMesh, const json& primitive, const json& node) const;
+        bool exportMaterial(size_t material, Symbol& name);
+        bool exportTexture(const json& textureInfo, std::string& path);
+        bool exportAnimation(const Badger::Geometry& geometry, const json& animation, size_t index);
+
+        std::filesystem::path inputDirectory;
+        std::filesystem::path textureDirectory;
+        std::string inputName;
+        json document;
+        std::vector<std::vector<unsigned char>> buffers;
+        std::unordered_set<size_t> jointNodes;
+        // Bone names and their index in the geometry, by node index.
+        std::unordered_map<size_t, Symbol> boneNames;
+        std::unordered_map<size_t, size_t> boneIndices;
+        std::unordered_map<size_t, std::string> exportedImages;
+        std::unordered_map<std::string, Badger::MetaMaterial> exportedMaterials;
+        std::unordered_map<std::string, Badger::Animation> exportedAnimations;
+        Badger::Model model;
+        PhaseTimings timings;
+};
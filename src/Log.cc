@@ -0,0 +1,178 @@
+#include "Log.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Buffered output is handed to the sink once a thread has collected this much,
+    // otherwise the sink picks it up on its next periodic drain.
+    constexpr size_t THREAD_BUFFER_FLUSH_SIZE = 16 * 1024;
+    constexpr auto SINK_DRAIN_INTERVAL = std::chrono::milliseconds(50);
+
+    std::atomic<int> currentLevel = static_cast<int>(Log::Level::Info);
+    std::atomic<bool> infoToStderr = false;
+
+    struct ThreadBuffer {
+        std::mutex mutex;
+        std::string data;
+    };
+
+    class Sink {
+        public:
+            Sink() : stopping(false), worker([this] { run(); }) {}
+
+            ~Sink() {
+                {
+                    std::lock_guard lock(mutex);
+                    stopping = true;
+                }
+                wakeup.notify_one();
+                worker.join();
+                drain();
+            }
+
+            void attach(const std::shared_ptr<ThreadBuffer>& buffer) {
+                std::lock_guard lock(mutex);
+                buffers.push_back(buffer);
+            }
+
+            void detach(const std::shared_ptr<ThreadBuffer>& buffer) {
+                std::lock_guard lock(mutex);
+                {
+                    std::lock_guard bufferLock(buffer->mutex);
+                    orphaned.append(buffer->data);
+                    buffer->data.clear();
+                }
+                std::erase(buffers, buffer);
+            }
+
+            void notify() {
+                wakeup.notify_one();
+            }
+
+            // Collects all thread buffers and writes them to the info stream.
+            void drain() {
+                std::string pending;
+                {
+                    std::lock_guard lock(mutex);
+                    pending.swap(orphaned);
+                    for (const auto& buffer : buffers) {
+                        std::lock_guard bufferLock(buffer->mutex);
+                        pending.append(buffer->data);
+                        buffer->data.clear();
+                    }
+                }
+
+                std::lock_guard writeLock(writeMutex);
+                if (!pending.empty()) {
+                    auto output = infoToStderr.load(std::memory_order_relaxed) ? stderr : stdout;
+                    std::fwrite(pending.data(), 1, pending.size(), output);
+                    std::fflush(output);
+                }
+            }
+
+            // Writes a line to stderr right away, after everything that was logged before it.
+            void writeImmediate(const std::string& line) {
+                drain();
+
+                std::lock_guard writeLock(writeMutex);
+                std::fwrite(line.data(), 1, line.size(), stderr);
+                std::fflush(stderr);
+            }
+
+        private:
+            void run() {
+                std::unique_lock lock(mutex);
+                while (!stopping) {
+                    wakeup.wait_for(lock, SINK_DRAIN_INTERVAL);
+                    lock.unlock();
+                    drain();
+                    lock.lock();
+                }
+            }
+
+            std::mutex mutex;
+            std::mutex writeMutex;
+            std::condition_variable wakeup;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+            std::string orphaned;
+            bool stopping;
+            std::thread worker;
+    };
+
+    Sink& sink() {
+        static Sink instance;
+        return instance;
+    }
+
+    struct ThreadBufferHandle {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ThreadBufferHandle() : buffer(std::make_shared<ThreadBuffer>()) {
+            sink().attach(buffer);
+        }
+
+        ~ThreadBufferHandle() {
+            sink().detach(buffer);
+        }
+    };
+
+    ThreadBuffer& threadBuffer() {
+        thread_local ThreadBufferHandle handle;
+        return *handle.buffer;
+    }
+}
+
+namespace Log {
+    void setLevel(Level level) {
+        currentLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    void useStderr(bool enabled) {
+        infoToStderr.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool isEnabled(Level level) {
+        return static_cast<int>(level) <= currentLevel.load(std::memory_order_relaxed);
+    }
+
+    void flush() {
+        sink().drain();
+    }
+
+    Line::Line(Level level) : level(level) {
+        if (isEnabled(level))
+            stream.emplace();
+    }
+
+    Line::~Line() {
+        if (!stream)
+            return;
+
+        *stream << '\n';
+        auto line = stream->str();
+
+        if (level <= Level::Warning) {
+            sink().writeImmediate(line);
+            return;
+        }
+
+        auto& buffer = threadBuffer();
+        size_t bufferedSize;
+        {
+            std::lock_guard lock(buffer.mutex);
+            buffer.data.append(line);
+            bufferedSize = buffer.data.size();
+        }
+
+        if (bufferedSize >= THREAD_BUFFER_FLUSH_SIZE)
+            sink().notify();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <optional>
+#include <sstream>
+
+namespace Log {
+    enum class Level {
+        Error,
+        Warning,
+        Info,
+        Verbose
+    };
+
+    void setLevel(Level level);
+    // Sends info and verbose output to stderr, for modes that use stdout as a data channel.
+    void useStderr(bool enabled);
+    bool isEnabled(Level level);
+
+    // Writes out everything buffered so far and waits until it reached the output streams.
+    void flush();
+
+    // A single log line. Info and verbose lines are collected in a per-thread buffer
+    // which is written out asynchronously, warnings and errors are written immediately.
+    class Line {
+        public:
+            explicit Line(Level level);
+            ~Line();
+
+            Line(const Line&) = delete;
+            Line& operator=(const Line&) = delete;
+
+            template <typename T>
+            Line& operator<<(const T& value) {
+                if (stream)
+                    *stream << value;
+                return *this;
+            }
+
+        private:
+            Level level;
+            std::optional<std::ostringstream> stream;
+    };
+
+    inline Line error() { return Line(Level::Error); }
+    inline Line warning() { return Line(Level::Warning); }
+    inline Line info() { return Line(Level::Info); }
+    inline Line verbose() { return Line(Level::Verbose); }
+}
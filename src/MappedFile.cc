@@ -0,0 +1,98 @@
+#include "MappedFile.hh"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+#ifdef _WIN32
+    auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+
+    data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        close();
+        return false;
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+
+    auto mapped = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    data = static_cast<const unsigned char*>(mapped);
+    size = static_cast<size_t>(status.st_size);
+    identity = Identity::of(status);
+#endif
+    return true;
+}
+
+bool MappedFile::isStale(const std::filesystem::path& path) const {
+#ifdef _WIN32
+    (void)path;
+    return false;
+#else
+    struct stat status;
+    return ::stat(path.c_str(), &status) != 0 || !(Identity::of(status) == identity);
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (data != nullptr)
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+#ifndef _WIN32
+MappedFile::Identity MappedFile::Identity::of(const struct stat& status) {
+#ifdef __APPLE__
+    return { status.st_dev, status.st_ino, status.st_size, status.st_mtimespec };
+#else
+    return { status.st_dev, status.st_ino, status.st_size, status.st_mtim };
+#endif
+}
+
+bool MappedFile::Identity::operator==(const Identity& other) const {
+    return device == other.device && inode == other.inode && size == other.size
+        && modified.tv_sec == other.modified.tv_sec && modified.tv_nsec == other.modified.tv_nsec;
+}
+#endif
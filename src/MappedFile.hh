@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+// Read-only memory mapping of a whole file. Empty files cannot be mapped.
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::filesystem::path& path);
+        // Whether the file at path was replaced or rewritten since it was mapped. Pages of a mapping whose
+        // file was truncated fault when touched. Windows refuses to truncate mapped files.
+        bool isStale(const std::filesystem::path& path) const;
+        void close();
+
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+
+    private:
+#ifdef _WIN32
+        // The file mapping HANDLE.
+        void* mapping = nullptr;
+#else
+        struct Identity {
+            dev_t device = 0;
+            ino_t inode = 0;
+            off_t size = 0;
+            timespec modified {};
+
+            static Identity of(const struct stat& status);
+            bool operator==(const Identity& other) const;
+        };
+
+        Identity identity;
+#endif
+};
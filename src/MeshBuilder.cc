@@ -0,0 +1,353 @@
+#include "MeshBuilder.hh"
+#include "Log.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+
+namespace {
+    // Where an element's components live in the interleaved attribute buffer.
+    struct ElementLayout {
+        const MeshElement* element;
+        size_t offset;
+        size_t width;
+    };
+
+    bool appendLayouts(const std::vector<MeshElement>& elements, std::vector<ElementLayout>& layouts, size_t& width) {
+        for (const auto& element : elements) {
+            auto elementWidth = element.values.empty() ? 0 : element.values[0].size();
+            for (const auto& value : element.values) {
+                if (value.size() != elementWidth) {
+                    Log::error() << "Error: layer element values have different sizes.";
+                    return false;
+                }
+            }
+
+            layouts.push_back({ &element, width, elementWidth });
+            width += elementWidth;
+        }
+        return true;
+    }
+
+    // Resolves the direct array entry a triangle corner uses, -1 if the element does not cover it.
+    int64_t resolve(const MeshElement& element, size_t controlPoint, size_t corner, size_t polygon) {
+        size_t index;
+        switch (element.mapping) {
+            case ElementMapping::ByControlPoint:
+                index = controlPoint;
+                break;
+            case ElementMapping::ByPolygonVertex:
+                index = corner;
+                break;
+            case ElementMapping::ByPolygon:
+                index = polygon;
+                break;
+            default:
+                index = 0;
+                break;
+        }
+
+        if (!element.indices.empty()) {
+            if (index >= element.indices.size())
+                return -1;
+            index = static_cast<size_t>(element.indices[index]);
+        }
+
+        return index < element.values.size() ? static_cast<int64_t>(index) : -1;
+    }
+
+    bool gather(const std::vector<ElementLayout>& layouts, size_t controlPoint, size_t corner, size_t polygon, double* tuple) {
+        for (const auto& layout : layouts) {
+            if (layout.width == 0)
+                continue;
+
+            auto index = resolve(*layout.element, controlPoint, corner, polygon);
+            if (index < 0)
+                return false;
+
+            const auto& value = layout.element->values[index];
+            std::copy(value.begin(), value.end(), tuple + layout.offset);
+        }
+        return true;
+    }
+
+    bool equal(const double* a, const double* b, size_t width, double tolerance) {
+        for (size_t i = 0; i < width; i++) {
+            if (a[i] != b[i] && !(std::abs(a[i] - b[i]) <= tolerance))
+                return false;
+        }
+        return true;
+    }
+
+    uint64_t combineHash(uint64_t seed, uint64_t value) {
+        return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
+
+    // Hashes values snapped to cells the size of the weld tolerance, so values within the tolerance usually share
+    // a key. Values on either side of a cell border get different keys and stay separate vertices.
+    uint64_t weldKey(const double* values, size_t count, double tolerance, uint64_t seed) {
+        for (size_t i = 0; i < count; i++) {
+            auto value = tolerance > 0 ? std::floor(values[i] / tolerance) : values[i];
+            // -0 and 0 compare equal, so they have to hash the same.
+            if (value == 0)
+                value = 0;
+            seed = combineHash(seed, std::bit_cast<uint64_t>(value));
+        }
+        return combineHash(seed, count);
+    }
+
+    void extract(const std::vector<ElementLayout>& layouts, size_t first, size_t count, const std::vector<double>& attributes, size_t width, size_t vertexCount, std::vector<std::vector<std::vector<double>>>& sets) {
+        sets.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const auto& layout = layouts[first + i];
+            auto& set = sets[i];
+            if (layout.width == 0) {
+                set.clear();
+                continue;
+            }
+
+            set.resize(vertexCount);
+            for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+                auto values = &attributes[vertex * width + layout.offset];
+                set[vertex].assign(values, values + layout.width);
+            }
+        }
+    }
+}
+
+size_t limitInfluences(MeshSource& source, const InfluenceLimits& limits) {
+    size_t pruned = 0;
+
+    // Scratch space shared by all vertices, so the pass allocates only when a vertex has more influences than any before.
+    std::vector<size_t> order;
+    std::vector<double> remainders;
+
+    for (size_t vertex = 0; vertex < source.weights.size(); vertex++) {
+        auto& names = source.boneNames[vertex];
+        auto& weights = source.weights[vertex];
+        auto count = std::min(names.size(), weights.size());
+        if (count == 0)
+            continue;
+
+        if (limits.maxInfluences != 0 && count > limits.maxInfluences) {
+            order.resize(count);
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return weights[a] > weights[b]; });
+
+            // The kept influences stay in their original order.
+            std::sort(order.begin(), order.begin() + limits.maxInfluences);
+            for (size_t i = 0; i < limits.maxInfluences; i++) {
+                if (order[i] == i)
+                    continue;
+
+                names[i] = std::move(names[order[i]]);
+                weights[i] = weights[order[i]];
+            }
+
+            pruned += count - limits.maxInfluences;
+            count = limits.maxInfluences;
+        }
+
+        names.resize(count);
+        weights.resize(count);
+
+        auto sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+        if (!(sum > 0))
+            continue;
+
+        for (auto& weight : weights)
+            weight /= sum;
+
+        if (limits.weightSteps == 0)
+            continue;
+
+        // Largest remainder rounding, the steps always add up to weightSteps.
+        remainders.resize(count);
+        long long remaining = limits.weightSteps;
+        for (size_t i = 0; i < count; i++) {
+            auto scaled = weights[i] * limits.weightSteps;
+            weights[i] = std::floor(scaled);
+            remainders[i] = scaled - weights[i];
+            remaining -= static_cast<long long>(weights[i]);
+        }
+
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return remainders[a] > remainders[b]; });
+        for (size_t i = 0; i < count && remaining > 0; i++, remaining--)
+            weights[order[i]] += 1;
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (weights[i] == 0)
+                continue;
+
+            if (kept != i)
+                names[kept] = std::move(names[i]);
+            weights[kept] = weights[i] / limits.weightSteps;
+            kept++;
+        }
+
+        pruned += count - kept;
+        names.resize(kept);
+        weights.resize(kept);
+    }
+
+    return pruned;
+}
+
+bool buildMesh(const MeshSource& source, const Triangulation& triangulation, double weldTolerance, Badger::Mesh& mesh) {
+    auto controlPointCount = source.positions.size();
+    auto hasSkin = !source.weights.empty();
+    if (hasSkin && (source.weights.size() != controlPointCount || source.boneNames.size() != controlPointCount)) {
+        Log::error() << "Error: skin data does not match the control points.";
+        return false;
+    }
+
+    std::vector<ElementLayout> layouts;
+    size_t width = 0;
+    if (!appendLayouts(source.normals, layouts, width) || !appendLayouts(source.uvs, layouts, width) || !appendLayouts(source.colors, layouts, width))
+        return false;
+
+    // Without per corner or per polygon elements every corner of a control point has the same tuple,
+    // so each control point is welded once.
+    auto perControlPoint = std::all_of(layouts.begin(), layouts.end(), [](const ElementLayout& layout) {
+        auto mapping = layout.element->mapping;
+        return layout.width == 0 || mapping == ElementMapping::ByControlPoint || mapping == ElementMapping::AllSame;
+    });
+
+    auto sameControlPointData = [&](size_t a, size_t b) {
+        if (a == b)
+            return true;
+
+        const auto& positionA = source.positions[a];
+        const auto& positionB = source.positions[b];
+        if (positionA.size() != positionB.size() || !equal(positionA.data(), positionB.data(), positionA.size(), weldTolerance))
+            return false;
+
+        if (!hasSkin)
+            return true;
+
+        const auto& weightsA = source.weights[a];
+        const auto& weightsB = source.weights[b];
+        return source.boneNames[a] == source.boneNames[b] && weightsA.size() == weightsB.size()
+            && equal(weightsA.data(), weightsB.data(), weightsA.size(), weldTolerance);
+    };
+
+    // Vertices are created in the order corners first reference them, so unreferenced control points are dropped.
+    // Vertices whose keys collide form a chain that is searched with the exact tolerance check.
+    std::vector<size_t> vertexControlPoints;
+    std::vector<double> attributes;
+    std::vector<int> nextVertex;
+    std::unordered_map<uint64_t, int> firstVertex;
+    std::vector<int> controlPointVertices(perControlPoint ? controlPointCount : 0, -1);
+    std::vector<double> tuple(width);
+
+    mesh.triangles.resize(triangulation.triangles.size());
+    for (size_t corner = 0; corner < triangulation.triangles.size(); corner++) {
+        auto controlPoint = static_cast<size_t>(triangulation.triangles[corner]);
+        if (controlPoint >= controlPointCount) {
+            Log::error() << "Error: triangle corner " << corner << " uses a control point out of range.";
+            return false;
+        }
+
+        if (perControlPoint && controlPointVertices[controlPoint] >= 0) {
+            mesh.triangles[corner] = controlPointVertices[controlPoint];
+            continue;
+        }
+
+        auto sourceCorner = static_cast<size_t>(triangulation.corners[corner]);
+        auto polygon = static_cast<size_t>(triangulation.polygons[corner / 3]);
+        if (!gather(layouts, controlPoint, sourceCorner, polygon, tuple.data())) {
+            Log::error() << "Error: layer element does not cover polygon vertex " << sourceCorner << ".";
+            return false;
+        }
+
+        auto key = weldKey(source.positions[controlPoint].data(), source.positions[controlPoint].size(), weldTolerance, 0);
+        key = weldKey(tuple.data(), width, weldTolerance, key);
+        if (hasSkin) {
+            key = weldKey(source.weights[controlPoint].data(), source.weights[controlPoint].size(), weldTolerance, key);
+            for (const auto& bone : source.boneNames[controlPoint])
+                key = combineHash(key, std::hash<Symbol>()(bone));
+        }
+
+        auto [head, inserted] = firstVertex.try_emplace(key, -1);
+        auto vertex = head->second;
+        auto last = -1;
+        while (vertex >= 0 && !(sameControlPointData(vertexControlPoints[vertex], controlPoint)
+            && equal(attributes.data() + vertex * width, tuple.data(), width, weldTolerance))) {
+            last = vertex;
+            vertex = nextVertex[vertex];
+        }
+
+        if (vertex < 0) {
+            vertex = static_cast<int>(vertexControlPoints.size());
+            vertexControlPoints.push_back(controlPoint);
+            attributes.insert(attributes.end(), tuple.begin(), tuple.end());
+            nextVertex.push_back(-1);
+            if (last < 0)
+                head->second = vertex;
+            else
+                nextVertex[last] = vertex;
+        }
+
+        if (perControlPoint)
+            controlPointVertices[controlPoint] = vertex;
+        mesh.triangles[corner] = vertex;
+    }
+
+    auto vertexCount = vertexControlPoints.size();
+    mesh.positions.resize(vertexCount);
+    for (size_t vertex = 0; vertex < vertexCount; vertex++)
+        mesh.positions[vertex] = source.positions[vertexControlPoints[vertex]];
+
+    extract(layouts, 0, source.normals.size(), attributes, width, vertexCount, mesh.normals);
+    extract(layouts, source.normals.size(), source.uvs.size(), attributes, width, vertexCount, mesh.uvs);
+    extract(layouts, source.normals.size() + source.uvs.size(), source.colors.size(), attributes, width, vertexCount, mesh.colors);
+
+    if (hasSkin) {
+        mesh.indices.resize(vertexCount);
+        mesh.weights.resize(vertexCount);
+        for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+            mesh.indices[vertex] = source.boneNames[vertexControlPoints[vertex]];
+            mesh.weights[vertex] = source.weights[vertexControlPoints[vertex]];
+        }
+    } else {
+        mesh.indices.clear();
+        mesh.weights.clear();
+    }
+
+    return true;
+}
+
+bool buildSkinClusters(const Badger::Mesh& mesh, std::vector<SkinCluster>& clusters) {
+    clusters.clear();
+    if (mesh.indices.size() > mesh.weights.size()) {
+        Log::error() << "Error: Invalid mesh indices/weights detected.";
+        return false;
+    }
+
+    std::unordered_map<Symbol, size_t> clusterIndices;
+    for (size_t i = 0; i < mesh.indices.size(); i++) {
+        const auto& boneNames = mesh.indices[i];
+        if (boneNames.size() > mesh.weights[i].size()) {
+            Log::error() << "Error: Invalid mesh indices/weights detected.";
+            return false;
+        }
+
+        for (size_t j = 0; j < boneNames.size(); j++) {
+            auto [it, inserted] = clusterIndices.try_emplace(boneNames[j], clusters.size());
+            if (inserted)
+                clusters.push_back({ .bone = boneNames[j], .indices = {}, .weights = {} });
+
+            auto& cluster = clusters[it->second];
+            cluster.indices.push_back(static_cast<int32_t>(i));
+            cluster.weights.push_back(mesh.weights[i][j]);
+        }
+    }
+
+    return true;
+}
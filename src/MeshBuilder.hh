@@ -0,0 +1,58 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "Triangulator.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One layer element as it is stored in the file: a direct array and, for indexed references, an index array.
+struct MeshElement {
+    ElementMapping mapping = ElementMapping::ByControlPoint;
+    // Already in the Badger layout, e.g. flipped UVs or 4 component normals.
+    std::vector<std::vector<double>> values;
+    // Empty for direct references.
+    std::vector<int> indices;
+};
+
+// Control point data of a mesh before de-indexing.
+struct MeshSource {
+    std::vector<std::vector<double>> positions;
+    // Skin influences per control point, empty for meshes without a skin.
+    std::vector<std::vector<Symbol>> boneNames;
+    std::vector<std::vector<double>> weights;
+    std::vector<MeshElement> normals;
+    std::vector<MeshElement> uvs;
+    std::vector<MeshElement> colors;
+};
+
+struct InfluenceLimits {
+    // Influences kept per vertex, the heaviest win. 0 keeps all of them.
+    size_t maxInfluences = 4;
+    // Weights are rounded to multiples of 1 / weightSteps without changing their sum, e.g. 255 for 8-bit weights.
+    // 0 keeps full precision.
+    unsigned weightSteps = 0;
+};
+
+// Caps the skin influences of every control point, renormalizes the kept weights to sum to 1 and optionally
+// quantizes them. Influences that quantize to 0 are dropped as well. Returns the number of pruned influences.
+size_t limitInfluences(MeshSource& source, const InfluenceLimits& limits);
+
+// Builds the Badger vertex layout, where every attribute is per vertex, from a triangulated mesh. Triangle
+// corners with the same position, normals, UVs, colors and skin influences share a vertex, values closer than
+// weldTolerance count as equal unless they fall on either side of a weld cell. Corners of different control
+// points are welded too, and control points no triangle uses are dropped. Vertices are numbered in the order
+// corners first use them.
+bool buildMesh(const MeshSource& source, const Triangulation& triangulation, double weldTolerance, Badger::Mesh& mesh);
+
+// The skin influences of one bone, as an FBX cluster stores them.
+struct SkinCluster {
+    Symbol bone;
+    std::vector<int32_t> indices;
+    std::vector<double> weights;
+};
+
+// Groups the per-vertex influences of a Badger mesh by bone. Clusters are kept in the order their bone is first
+// referenced, so the output does not depend on hash map order.
+bool buildSkinClusters(const Badger::Mesh& mesh, std::vector<SkinCluster>& clusters);
@@ -0,0 +1,1277 @@
+#include "NativeFbxExporter.hh"
+#include "AnimationSampler.hh"
+#include "Log.hh"
+#include "NativeFbxWriter.hh"
+#include "Parallel.hh"
+#include "Shadergraph.hh"
+#include "Version.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+
+namespace {
+    constexpr int64_t TICKS_PER_SECOND = 46186158000;
+    // Outside the range nextId() hands out.
+    constexpr int64_t DOCUMENT_ID = 1;
+
+    constexpr int INHERIT_RSRS = 1;
+    constexpr int INHERIT_RRS = 2;
+
+    constexpr int32_t KEY_INTERPOLATION_LINEAR = 0x00000004;
+    // FbxAnimCurveDef::eInterpolationCubic with eTangentBreak, user tangents that may differ on either side.
+    constexpr int32_t KEY_INTERPOLATION_CUBIC_BREAK = 0x00000c08;
+    // Default tangent weights and velocities, as the SDK writes them for non-cubic keys.
+    constexpr std::array<float, 4> KEY_ATTRIBUTE_DATA { 0.0f, 0.0f, 9.419963346924634e-30f, 0.0f };
+
+    enum class MayaType { Int, Float, Double2, Double3 };
+
+    struct MayaProperty {
+        const char* name;
+        MayaType type;
+    };
+
+    // The Stingray PBS properties in the order FbxConverter creates them, which is also the binding table order.
+    constexpr MayaProperty MAYA_PROPERTIES[] = {
+        { "TypeId", MayaType::Int },
+        { "TEX_global_diffuse_cube", MayaType::Double3 },
+        { "TEX_global_specular_cube", MayaType::Double3 },
+        { "TEX_brdf_lut", MayaType::Double3 },
+        { "use_normal_map", MayaType::Float },
+        { "uv_offset", MayaType::Double2 },
+        { "uv_scale", MayaType::Double2 },
+        { "TEX_normal_map", MayaType::Double3 },
+        { "use_color_map", MayaType::Float },
+        { "TEX_color_map", MayaType::Double3 },
+        { "base_color", MayaType::Double3 },
+        { "use_metallic_map", MayaType::Float },
+        { "TEX_metallic_map", MayaType::Double3 },
+        { "metallic", MayaType::Float },
+        { "use_roughness_map", MayaType::Float },
+        { "TEX_roughness_map", MayaType::Double3 },
+        { "roughness", MayaType::Float },
+        { "use_emissive_map", MayaType::Float },
+        { "TEX_emissive_map", MayaType::Double3 },
+        { "emissive", MayaType::Double3 },
+        { "emissive_intensity", MayaType::Float },
+        { "use_ao_map", MayaType::Float },
+        { "TEX_ao_map", MayaType::Double3 }
+    };
+
+    std::string objectName(const std::string& name, const char* objectClass) {
+        std::string result(name);
+        result.push_back('\0');
+        result.push_back('\x01');
+        result.append(objectClass);
+        return result;
+    }
+
+    template <typename... Values>
+    void property(NativeFbxWriter& writer, std::string_view name, std::string_view type, std::string_view label, std::string_view flags, const Values&... values) {
+        writer.node("P", name, type, label, flags, values...);
+    }
+
+    void vectorProperty(NativeFbxWriter& writer, std::string_view name, std::string_view type, const std::array<double, 3>& value) {
+        property(writer, name, type, "", "A", value[0], value[1], value[2]);
+    }
+
+    bool toVector3(const Badger::Vector3f& source, std::array<double, 3>& target) {
+        if (source.size() < 3)
+            return false;
+
+        target = { source[0], source[1], source[2] };
+        return true;
+    }
+
+    int64_t secondsToTicks(double seconds) {
+        return std::llround(seconds * TICKS_PER_SECOND);
+    }
+}
+
+NativeFbxExporter::NativeFbxExporter(const char* resourcePacksDir) : NativeFbxExporter(new ResourceLoader(resourcePacksDir), true) {
+
+}
+
+NativeFbxExporter::NativeFbxExporter(ResourceLoader& loader) : NativeFbxExporter(&loader, false) {
+
+}
+
+NativeFbxExporter::NativeFbxExporter(ResourceLoader* loader, bool ownsLoader) : loader(loader), ownsLoader(ownsLoader) {
+    reset();
+}
+
+NativeFbxExporter::~NativeFbxExporter() {
+    if (ownsLoader)
+        delete loader;
+}
+
+void NativeFbxExporter::reset() {
+    // 0 is the scene root, ids only have to be unique within the file.
+    lastId = 1000000;
+    nodes.clear();
+    transforms.clear();
+    boneIndices.clear();
+    locatorIndices.clear();
+    meshes.clear();
+    materials.clear();
+    materialIndices.clear();
+    textures.clear();
+    implementationId = 0;
+    bindingTableId = 0;
+    animations.clear();
+    curveNodes.clear();
+    curves.clear();
+    connections.clear();
+}
+
+void NativeFbxExporter::connect(int64_t child, int64_t parent, const char* property) {
+    connections.push_back({ child, parent, property });
+}
+
+bool NativeFbxExporter::convertToFbx(const char* model, const char* output) {
+    reset();
+    timings.clear();
+    Stopwatch stopwatch;
+    // Textures from archive packs are extracted next to the output, the file can only refer to paths on disk.
+    textureDirectory = std::filesystem::path(output).parent_path();
+
+    Log::info() << "Parsing model JSON.";
+
+    std::string modelName(model);
+    auto prefetched = loader->prefetch(modelName);
+    if (!prefetched.model.get()) {
+        return false;
+    }
+
+    auto modelData = loader->getModel(modelName);
+    if (!modelData) {
+        return false;
+    }
+
+    if (modelData->geometry.size() != 1) {
+        Log::error() << "Error: model has more than one geometry - this is not supported.";
+        return false;
+    }
+    const auto& geometry = modelData->geometry.at(0);
+    timings.record("parse", stopwatch);
+
+    Log::info() << "Importing bones.";
+
+    for (const auto& bone : geometry.bones) {
+        Log::verbose() << "Importing bone " << bone.name;
+        if (!addBone(bone)) {
+            Log::error() << "Error: failed to import bone.";
+            return false;
+        }
+    }
+    timings.record("bones", stopwatch);
+
+    Log::info() << "Importing materials.";
+
+    prefetched.materials.wait();
+    for (const auto& mesh : geometry.meshes) {
+        if (addMaterial(mesh.material) < 0) {
+            Log::error() << "Error: failed to import material " << mesh.material << ".";
+            return false;
+        }
+    }
+    timings.record("materials", stopwatch);
+
+    Log::info() << "Importing meshes.";
+
+    std::vector<Mesh> preparedMeshes;
+    if (!prepareMeshes(geometry.meshes, preparedMeshes)) {
+        return false;
+    }
+    timings.record("mesh_prepare", stopwatch);
+
+    for (size_t meshId = 0; meshId < preparedMeshes.size(); meshId++) {
+        if (!attachMesh(preparedMeshes[meshId])) {
+            Log::error() << "Error: failed to import mesh #" << meshId;
+            return false;
+        }
+    }
+    timings.record("meshes", stopwatch);
+
+    auto entity = prefetched.entity.get() ? loader->getEntity(modelName) : nullptr;
+    if (entity && entity->info.components.faceAnimation) {
+        Log::info() << "Setting UV offset and scale for face material.";
+        auto matName = "mat_" + modelName + "_face";
+        if (auto it = materialIndices.find(matName); it == materialIndices.end()) {
+            Log::error() << "Failed to find face material " << matName << ".";
+            return false;
+        } else {
+            auto& faceMaterial = materials[it->second];
+            auto faceAnim = entity->info.components.faceAnimation.value();
+            auto widthOffset = 1.0 / faceAnim.colums;
+            auto heightOffset = 1.0 / faceAnim.rows;
+            faceMaterial.uvScale = { widthOffset, heightOffset };
+            faceMaterial.uvOffset = { widthOffset * faceAnim.defaultFrame, heightOffset * faceAnim.defaultFrame };
+        }
+    }
+
+    auto animationData = prefetched.animations.get() ? loader->getAnimations(modelName) : nullptr;
+    if (animationData != nullptr) {
+        Log::info() << "Importing animations.";
+        for (const auto& animation : animationData->animations) {
+            auto name = animation.first;
+            if (name.starts_with("animation."))
+                name = name.substr(10);
+
+            addAnimation(name, animation.second);
+        }
+    }
+    timings.record("animations", stopwatch);
+
+    Log::info() << "Exporting model.";
+
+    if (!write(output))
+        return false;
+    timings.record("write", stopwatch);
+
+    Log::info() << "Export finished.";
+
+    return true;
+}
+
+bool NativeFbxExporter::addBone(const Badger::Bone& badgerBone) {
+    auto isRootBone = badgerBone.parent.empty();
+
+    Node node {
+        .id = nextId(),
+        .attributeId = nextId(),
+        .name = badgerBone.name,
+        .attributeName = badgerBone.name.str() + "_bone",
+        .type = isRootBone ? "Root" : "LimbNode",
+        .parent = 0,
+        .translation = {},
+        .rotation = {},
+        .scale = {},
+        .inheritType = INHERIT_RSRS,
+        .rotationActive = true
+    };
+
+    if (!toVector3(badgerBone.pivot, node.translation) || !toVector3(badgerBone.info.bindPoseRotation, node.rotation) || !toVector3(badgerBone.scale, node.scale)) {
+        Log::error() << "Error: bone " << badgerBone.name << " has an invalid transform.";
+        return false;
+    }
+
+    auto parentIndex = TransformTable::NO_PARENT;
+    if (!isRootBone) {
+        auto parent = boneIndices.find(badgerBone.parent);
+        if (parent == boneIndices.end()) {
+            Log::error() << "Error: could not find parent bone " << badgerBone.parent << ".";
+            return false;
+        }
+
+        parentIndex = parent->second;
+        node.parent = nodes[parentIndex].id;
+    }
+
+    connect(node.attributeId, node.id);
+    connect(node.id, node.parent);
+
+    auto boneId = node.id;
+    auto boneIndex = transforms.add(Matrix4::compose(node.translation, node.rotation, node.scale), parentIndex);
+    if (!boneIndices.try_emplace(badgerBone.name, boneIndex).second)
+        Log::warning() << "Warning: bone " << badgerBone.name << " is defined more than once, meshes and animations use the first one.";
+    else if (locatorIndices.contains(badgerBone.name))
+        Log::warning() << "Warning: bone " << badgerBone.name << " has the name of a locator, animations of it move the bone.";
+    nodes.push_back(std::move(node));
+
+    if (!badgerBone.locators.empty()) {
+        Log::verbose() << "Importing locators.";
+
+        for (const auto& locatorPair : badgerBone.locators) {
+            const auto& info = locatorPair.second;
+
+            Node locator {
+                .id = nextId(),
+                .attributeId = nextId(),
+                .name = locatorPair.first,
+                .attributeName = locatorPair.first + "_locator",
+                .type = "Null",
+                .parent = boneId,
+                .translation = {},
+                .rotation = {},
+                .scale = { 1, 1, 1 },
+                .inheritType = info.discardScale ? INHERIT_RRS : INHERIT_RSRS,
+                .rotationActive = true
+            };
+
+            if (!toVector3(info.offset, locator.translation) || !toVector3(info.rotation, locator.rotation)) {
+                Log::error() << "Error: locator " << locatorPair.first << " has an invalid transform.";
+                return false;
+            }
+
+            connect(locator.attributeId, locator.id);
+            connect(locator.id, boneId);
+
+            auto locatorIndex = transforms.add(Matrix4::compose(locator.translation, locator.rotation, locator.scale), boneIndex, !info.discardScale);
+            if (boneIndices.contains(locatorPair.first))
+                Log::warning() << "Warning: locator " << locatorPair.first << " has the name of a bone, animations of it move the bone.";
+            else if (!locatorIndices.try_emplace(locatorPair.first, locatorIndex).second)
+                Log::warning() << "Warning: locator " << locatorPair.first << " is defined more than once, animations use the first one.";
+            nodes.push_back(std::move(locator));
+        }
+    }
+
+    return true;
+}
+
+bool NativeFbxExporter::prepareMeshes(const std::vector<Badger::Mesh>& meshData, std::vector<Mesh>& prepared) {
+    prepared.clear();
+    prepared.resize(meshData.size());
+    std::vector<char> succeeded(meshData.size(), false);
+
+    parallelFor(meshData.size(), threads, [&](size_t meshId) {
+        Log::verbose() << "Preparing mesh #" << meshId;
+        succeeded[meshId] = prepareMesh(meshData[meshId], meshId, prepared[meshId]);
+    });
+
+    for (size_t meshId = 0; meshId < meshData.size(); meshId++) {
+        if (!succeeded[meshId]) {
+            Log::error() << "Error: failed to import mesh #" << meshId;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool NativeFbxExporter::prepareMesh(const Badger::Mesh& meshData, size_t meshId, Mesh& prepared) {
+    auto positionsCount = meshData.positions.size();
+    if (positionsCount != meshData.weights.size()) {
+        Log::error() << "Error: Invalid mesh positions/weights detected.";
+        return false;
+    }
+
+    if (!meshData.indices.empty() && positionsCount != meshData.indices.size()) {
+        Log::error() << "Error: Invalid mesh positions/indices detected.";
+        return false;
+    }
+
+    if (!loader->getMaterial(meshData.material))
+        return false;
+
+    prepared.nodeName = "meshNode_" + std::to_string(meshId);
+    prepared.meshName = "mesh_" + std::to_string(meshId);
+    prepared.name = meshData.name;
+    prepared.material = meshData.material;
+
+    if (!meshData.name.empty()) {
+        prepared.nodeName.append("_" + meshData.name);
+        prepared.meshName.append("_" + meshData.name);
+    }
+
+    prepared.vertices.reserve(positionsCount * 3);
+    for (const auto& position : meshData.positions) {
+        if (position.size() < 3) {
+            Log::error() << "Error: Invalid mesh position detected.";
+            return false;
+        }
+        prepared.vertices.insert(prepared.vertices.end(), position.begin(), position.begin() + 3);
+    }
+
+    // The last index of every polygon is stored as its one's complement.
+    auto triangleCount = meshData.triangles.size() - meshData.triangles.size() % 3;
+    prepared.polygonVertexIndex.resize(triangleCount);
+    for (size_t i = 0; i < triangleCount; i++) {
+        auto index = meshData.triangles[i];
+        if (index < 0 || static_cast<size_t>(index) >= positionsCount) {
+            Log::error() << "Error: triangle index " << index << " is out of range.";
+            return false;
+        }
+        prepared.polygonVertexIndex[i] = i % 3 == 2 ? ~index : index;
+    }
+
+    for (const auto& normalSet : meshData.normals) {
+        if (positionsCount != normalSet.size()) {
+            Log::error() << "Error: Invalid normal set detected. ";
+            return false;
+        }
+
+        auto& normals = prepared.normals.emplace_back();
+        normals.reserve(positionsCount * 3);
+        for (const auto& normal : normalSet) {
+            if (normal.size() < 3) {
+                Log::error() << "Error: Invalid mesh normal detected.";
+                return false;
+            }
+            normals.insert(normals.end(), { normal[0], normal[1], normal[2] });
+        }
+    }
+
+    for (const auto& uvSet : meshData.uvs) {
+        if (positionsCount != uvSet.size()) {
+            Log::error() << "Error: Invalid UV set detected. ";
+            return false;
+        }
+
+        auto& uvs = prepared.uvs.emplace_back();
+        uvs.reserve(positionsCount * 2);
+        for (const auto& uv : uvSet) {
+            if (uv.size() < 2) {
+                Log::error() << "Error: Invalid mesh UV detected.";
+                return false;
+            }
+            uvs.insert(uvs.end(), { uv[0], 1 - uv[1] });
+        }
+    }
+
+    for (const auto& colorSet : meshData.colors) {
+        if (positionsCount != colorSet.size()) {
+            Log::error() << "Error: Invalid color set detected. ";
+            return false;
+        }
+
+        auto& colors = prepared.colors.emplace_back();
+        colors.reserve(positionsCount * 4);
+        for (const auto& color : colorSet) {
+            if (color.size() < 4) {
+                Log::error() << "Error: Invalid mesh color detected.";
+                return false;
+            }
+            colors.insert(colors.end(), { color[0], color[1], color[2], color[3] });
+        }
+    }
+
+    std::vector<SkinCluster> skinClusters;
+    if (!buildSkinClusters(meshData, skinClusters))
+        return false;
+
+    for (auto& skin : skinClusters)
+        prepared.clusters.push_back({ .id = 0, .node = 0, .skin = std::move(skin) });
+
+    return true;
+}
+
+bool NativeFbxExporter::attachMesh(Mesh& prepared) {
+    Node node {
+        .id = nextId(),
+        .attributeId = 0,
+        .name = prepared.nodeName,
+        .attributeName = {},
+        .type = "Mesh",
+        .parent = 0,
+        .translation = { 0, 0, 0 },
+        .rotation = { 0, 0, 0 },
+        .scale = { 1, 1, 1 },
+        .inheritType = INHERIT_RSRS,
+        .rotationActive = false
+    };
+
+    prepared.node = transforms.add(Matrix4::identity());
+    prepared.geometryId = nextId();
+    connect(prepared.geometryId, node.id);
+    connect(node.id, 0);
+
+    if (!prepared.clusters.empty()) {
+        prepared.skinId = nextId();
+        connect(prepared.skinId, prepared.geometryId);
+
+        for (auto& cluster : prepared.clusters) {
+            auto bone = boneIndices.find(cluster.skin.bone);
+            if (bone == boneIndices.end()) {
+                Log::error() << "Error: could not find bone " << cluster.skin.bone << " in the scene.";
+                return false;
+            }
+
+            cluster.id = nextId();
+            cluster.node = bone->second;
+            connect(cluster.id, prepared.skinId);
+            connect(nodes[bone->second].id, cluster.id);
+        }
+    }
+
+    auto material = addMaterial(prepared.material);
+    if (material < 0) {
+        return false;
+    }
+    connect(materials[material].id, node.id);
+
+    nodes.push_back(std::move(node));
+    meshes.push_back(std::move(prepared));
+    return true;
+}
+
+int NativeFbxExporter::addMaterial(const std::string& name) {
+    if (auto it = materialIndices.find(name); it != materialIndices.end())
+        return static_cast<int>(it->second);
+
+    Log::verbose() << "Importing material " << name << ".";
+
+    auto materialData = loader->getMaterial(name);
+    if (!materialData) {
+        return -1;
+    }
+
+    const auto& materialInfo = materialData->info.textures;
+
+    Material material {
+        .id = nextId(),
+        .name = materialData->baseName.empty() ? materialData->name : (materialData->name + "___" + materialData->baseName),
+        .useColorMap = !materialInfo.diffuse.empty(),
+        .useNormalMap = !materialInfo.normal.empty(),
+        .useCoefficientMap = !materialInfo.coeff.empty(),
+        .useEmissiveMap = !materialInfo.emissive.empty(),
+        .uvOffset = { 0, 0 },
+        .uvScale = { 1, 1 }
+    };
+
+    auto addTexture = [&](const std::string& textureName, const std::string& path, std::initializer_list<const char*> properties) {
+        Texture texture {
+            .id = nextId(),
+            .videoId = nextId(),
+            .name = textureName,
+            .path = loader->extractFile(path, textureDirectory)
+        };
+
+        for (auto property : properties)
+            connect(texture.id, material.id, property);
+        connect(texture.videoId, texture.id);
+
+        textures.push_back(std::move(texture));
+    };
+
+    if (material.useColorMap)
+        addTexture(name + "_diffuse", materialInfo.diffuse + ".png", { "Maya|TEX_color_map" });
+
+    if (material.useNormalMap)
+        addTexture(name + "_normal", materialInfo.normal + ".png", { "Maya|TEX_normal_map" });
+
+    if (material.useCoefficientMap)
+        addTexture(name + "_coeff", materialInfo.coeff + ".png", { "Maya|TEX_metallic_map", "Maya|TEX_roughness_map" });
+
+    if (material.useEmissiveMap)
+        addTexture(name + "_emissive", materialInfo.emissive + ".hdr", { "Maya|TEX_emissive_map" });
+
+    if (implementationId == 0) {
+        if (decompressedShadergraph().empty())
+            return -1;
+
+        implementationId = nextId();
+        bindingTableId = nextId();
+        connect(bindingTableId, implementationId);
+    }
+    connect(implementationId, material.id);
+
+    materialIndices.insert({name, materials.size()});
+    materials.push_back(std::move(material));
+    return static_cast<int>(materials.size() - 1);
+}
+
+bool NativeFbxExporter::addAnimation(const std::string& name, const Badger::Animation& badgerAnimation) {
+    // Bones are sorted so the written curves do not depend on the hash map order.
+    std::vector<std::pair<size_t, const Badger::AnimationBone*>> bones;
+    for (const auto& boneAnimation : badgerAnimation.bones) {
+        // Locators are animated like bones, a bone of the same name takes precedence.
+        auto node = boneIndices.find(boneAnimation.first);
+        if (node == boneIndices.end()) {
+            node = locatorIndices.find(boneAnimation.first);
+            if (node == locatorIndices.end()) {
+                Log::error() << "Error: could not find bone " << boneAnimation.first << " in the scene.";
+                return false;
+            }
+        }
+        bones.emplace_back(node->second, &boneAnimation.second);
+    }
+
+    std::sort(bones.begin(), bones.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    Animation animation {
+        .stackId = nextId(),
+        .layerId = nextId(),
+        .name = name,
+        .stop = 0
+    };
+    connect(animation.layerId, animation.stackId);
+
+    auto addCurves = [&](size_t nodeIndex, const char* curveNodeName, const char* propertyName, const Vector3& original, const std::unordered_map<double, Badger::AnimationProperty>& keyframeInfo) {
+        std::vector<std::pair<double, const Badger::AnimationProperty*>> keyframes;
+        keyframes.reserve(keyframeInfo.size());
+        for (const auto& keyframe : keyframeInfo) {
+            if (keyframe.second.post.size() >= 3)
+                keyframes.emplace_back(keyframe.first, &keyframe.second);
+        }
+
+        if (keyframes.empty())
+            return;
+
+        std::sort(keyframes.begin(), keyframes.end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        });
+
+        std::vector<double> times;
+        std::vector<char> smooth;
+        for (const auto& keyframe : keyframes) {
+            times.push_back(keyframe.first);
+            smooth.push_back(keyframe.second->lerpMode == "catmullrom");
+        }
+
+        CurveNode curveNode {
+            .id = nextId(),
+            .name = curveNodeName,
+            .property = propertyName,
+            .node = nodeIndex,
+            .defaults = original,
+            .curves = {}
+        };
+
+        connect(curveNode.id, animation.layerId);
+        connect(curveNode.id, nodes[nodeIndex].id, propertyName);
+
+        static constexpr const char* CHANNELS[] = { "d|X", "d|Y", "d|Z" };
+        for (auto axis = 0; axis < 3; axis++) {
+            Curve curve {
+                .id = nextId(),
+                .defaultValue = original[axis],
+                .times = {},
+                .values = {},
+                .attributeFlags = {},
+                .attributeData = {},
+                .attributeRefCounts = {}
+            };
+
+            std::vector<double> values;
+            values.reserve(keyframes.size());
+            for (const auto& keyframe : keyframes)
+                values.push_back(original[axis] + keyframe.second->post[axis]);
+
+            // Catmull-Rom segments become cubic keys with matching tangents, linear runs share one attribute.
+            auto tangents = catmullRomTangents(times, values, smooth);
+
+            curve.times.reserve(keyframes.size());
+            curve.values.reserve(keyframes.size());
+            for (size_t i = 0; i < keyframes.size(); i++) {
+                curve.times.push_back(secondsToTicks(times[i]));
+                curve.values.push_back(static_cast<float>(values[i]));
+
+                auto flags = tangents[i].cubic ? KEY_INTERPOLATION_CUBIC_BREAK : KEY_INTERPOLATION_LINEAR;
+                auto data = KEY_ATTRIBUTE_DATA;
+                if (tangents[i].cubic) {
+                    data[0] = static_cast<float>(tangents[i].rightSlope);
+                    data[1] = static_cast<float>(tangents[i].nextLeftSlope);
+                }
+
+                if (!curve.attributeFlags.empty() && curve.attributeFlags.back() == flags && std::equal(data.begin(), data.end(), curve.attributeData.end() - 4)) {
+                    curve.attributeRefCounts.back()++;
+                } else {
+                    curve.attributeFlags.push_back(flags);
+                    curve.attributeData.insert(curve.attributeData.end(), data.begin(), data.end());
+                    curve.attributeRefCounts.push_back(1);
+                }
+            }
+
+            animation.stop = std::max(animation.stop, curve.times.back());
+
+            connect(curve.id, curveNode.id, CHANNELS[axis]);
+            curveNode.curves[axis] = curves.size();
+            curves.push_back(std::move(curve));
+        }
+
+        curveNodes.push_back(curveNode);
+    };
+
+    for (const auto& [nodeIndex, boneAnimation] : bones) {
+        const auto& node = nodes[nodeIndex];
+        addCurves(nodeIndex, "T", "Lcl Translation", node.translation, boneAnimation->position);
+        addCurves(nodeIndex, "R", "Lcl Rotation", node.rotation, boneAnimation->rotation);
+        addCurves(nodeIndex, "S", "Lcl Scaling", node.scale, boneAnimation->scale);
+    }
+
+    animations.push_back(std::move(animation));
+    return true;
+}
+
+bool NativeFbxExporter::write(const char* output) {
+    NativeFbxWriter writer;
+    if (!writer.open(output))
+        return false;
+
+    writeHeader(writer, output);
+    writeDefinitions(writer);
+
+    writer.beginNode("Objects");
+    writeNodes(writer);
+    writeMeshes(writer);
+    writeMaterials(writer);
+    writeAnimations(writer);
+    writer.endNode();
+
+    writeConnections(writer);
+
+    writer.beginNode("Takes");
+    writer.node("Current", "");
+    for (const auto& animation : animations) {
+        writer.beginNode("Take");
+        writer.addString(animation.name);
+        writer.node("FileName", animation.name + ".tak");
+        writer.node("LocalTime", int64_t(0), animation.stop);
+        writer.node("ReferenceTime", int64_t(0), animation.stop);
+        writer.endNode();
+    }
+    writer.endNode();
+
+    return writer.close();
+}
+
+void NativeFbxExporter::writeHeader(NativeFbxWriter& writer, const char* output) const {
+    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm time {};
+#ifdef _WIN32
+    localtime_s(&time, &now);
+#else
+    localtime_r(&now, &time);
+#endif
+
+    const std::string creator = "FbxConverter " FBX_CONVERTER_VERSION;
+
+    writer.beginNode("FBXHeaderExtension");
+    writer.node("FBXHeaderVersion", 1003);
+    writer.node("FBXVersion", 7400);
+    writer.node("EncryptionType", 0);
+
+    writer.beginNode("CreationTimeStamp");
+    writer.node("Version", 1000);
+    writer.node("Year", time.tm_year + 1900);
+    writer.node("Month", time.tm_mon + 1);
+    writer.node("Day", time.tm_mday);
+    writer.node("Hour", time.tm_hour);
+    writer.node("Minute", time.tm_min);
+    writer.node("Second", time.tm_sec);
+    writer.node("Millisecond", 0);
+    writer.endNode();
+
+    writer.node("Creator", creator);
+
+    writer.beginNode("SceneInfo");
+    writer.addString(objectName("GlobalInfo", "SceneInfo"));
+    writer.addString("UserData");
+    writer.node("Type", "UserData");
+    writer.node("Version", 100);
+    writer.beginNode("MetaData");
+    writer.node("Version", 100);
+    for (auto field : { "Title", "Subject", "Author", "Keywords", "Revision", "Comment" })
+        writer.node(field, "");
+    writer.endNode();
+    writer.beginNode("Properties70");
+    property(writer, "DocumentUrl", "KString", "Url", "", output);
+    property(writer, "SrcDocumentUrl", "KString", "Url", "", output);
+    property(writer, "Original", "Compound", "", "");
+    property(writer, "Original|ApplicationVendor", "KString", "", "", "FbxConverter");
+    property(writer, "Original|ApplicationName", "KString", "", "", "FbxConverter");
+    property(writer, "Original|ApplicationVersion", "KString", "", "", FBX_CONVERTER_VERSION);
+    property(writer, "LastSaved", "Compound", "", "");
+    property(writer, "LastSaved|ApplicationVendor", "KString", "", "", "FbxConverter");
+    property(writer, "LastSaved|ApplicationName", "KString", "", "", "FbxConverter");
+    property(writer, "LastSaved|ApplicationVersion", "KString", "", "", FBX_CONVERTER_VERSION);
+    writer.endNode();
+    writer.endNode();
+
+    writer.endNode();
+
+    writer.beginNode("FileId");
+    writer.addRaw(NativeFbxWriter::FILE_ID);
+    writer.endNode();
+    writer.node("CreationTime", NativeFbxWriter::CREATION_TIME);
+    writer.node("Creator", creator);
+
+    int64_t timeSpanStop = 0;
+    for (const auto& animation : animations)
+        timeSpanStop = std::max(timeSpanStop, animation.stop);
+
+    writer.beginNode("GlobalSettings");
+    writer.node("Version", 1000);
+    writer.beginNode("Properties70");
+    property(writer, "UpAxis", "int", "Integer", "", 1);
+    property(writer, "UpAxisSign", "int", "Integer", "", 1);
+    property(writer, "FrontAxis", "int", "Integer", "", 2);
+    property(writer, "FrontAxisSign", "int", "Integer", "", 1);
+    property(writer, "CoordAxis", "int", "Integer", "", 0);
+    property(writer, "CoordAxisSign", "int", "Integer", "", 1);
+    property(writer, "OriginalUpAxis", "int", "Integer", "", -1);
+    property(writer, "OriginalUpAxisSign", "int", "Integer", "", 1);
+    property(writer, "UnitScaleFactor", "double", "Number", "", 1.0);
+    property(writer, "OriginalUnitScaleFactor", "double", "Number", "", 1.0);
+    property(writer, "AmbientColor", "ColorRGB", "Color", "", 0.0, 0.0, 0.0);
+    property(writer, "DefaultCamera", "KString", "", "", "Producer Perspective");
+    property(writer, "TimeMode", "enum", "", "", 6);
+    property(writer, "TimeSpanStart", "KTime", "Time", "", int64_t(0));
+    property(writer, "TimeSpanStop", "KTime", "Time", "", timeSpanStop);
+    property(writer, "CustomFrameRate", "double", "Number", "", -1.0);
+    writer.endNode();
+    writer.endNode();
+
+    writer.beginNode("Documents");
+    writer.node("Count", 1);
+    writer.beginNode("Document");
+    writer.addLong(DOCUMENT_ID);
+    writer.addString("");
+    writer.addString("Scene");
+    writer.beginNode("Properties70");
+    property(writer, "SourceObject", "object", "", "");
+    property(writer, "ActiveAnimStackName", "KString", "", "", "");
+    writer.endNode();
+    writer.node("RootNode", int64_t(0));
+    writer.endNode();
+    writer.endNode();
+
+    writer.beginNode("References");
+    writer.endNode();
+}
+
+void NativeFbxExporter::writeDefinitions(NativeFbxWriter& writer) const {
+    size_t attributes = 0;
+    size_t deformers = 0;
+    for (const auto& node : nodes) {
+        if (node.attributeId != 0)
+            attributes++;
+    }
+    for (const auto& mesh : meshes) {
+        if (mesh.skinId != 0)
+            deformers += 1 + mesh.clusters.size();
+    }
+
+    auto hasMaterials = !materials.empty() ? 1 : 0;
+    const std::pair<const char*, size_t> objectTypes[] = {
+        { "GlobalSettings", 1 },
+        { "NodeAttribute", attributes },
+        { "Model", nodes.size() },
+        { "Geometry", meshes.size() },
+        { "Deformer", deformers },
+        { "Material", materials.size() },
+        { "Texture", textures.size() },
+        { "Video", textures.size() },
+        { "Implementation", hasMaterials },
+        { "BindingTable", hasMaterials },
+        { "AnimationStack", animations.size() },
+        { "AnimationLayer", animations.size() },
+        { "AnimationCurveNode", curveNodes.size() },
+        { "AnimationCurve", curves.size() }
+    };
+
+    size_t total = 0;
+    for (const auto& objectType : objectTypes)
+        total += objectType.second;
+
+    writer.beginNode("Definitions");
+    writer.node("Version", 100);
+    writer.node("Count", static_cast<int32_t>(total));
+    for (const auto& [name, count] : objectTypes) {
+        if (count == 0)
+            continue;
+
+        writer.beginNode("ObjectType");
+        writer.addString(name);
+        writer.node("Count", static_cast<int32_t>(count));
+        writer.endNode();
+    }
+    writer.endNode();
+}
+
+void NativeFbxExporter::writeNodes(NativeFbxWriter& writer) const {
+    for (const auto& node : nodes) {
+        if (node.attributeId == 0)
+            continue;
+
+        writer.beginNode("NodeAttribute");
+        writer.addLong(node.attributeId);
+        writer.addString(objectName(node.attributeName, "NodeAttribute"));
+        writer.addString(node.type);
+
+        writer.beginNode("Properties70");
+        writer.endNode();
+
+        std::string_view type(node.type);
+        if (type == "Root")
+            writer.node("TypeFlags", "Null", "Skeleton", "Root");
+        else if (type == "LimbNode")
+            writer.node("TypeFlags", "Skeleton");
+        else
+            writer.node("TypeFlags", "Null");
+
+        writer.endNode();
+    }
+
+    for (const auto& node : nodes) {
+        writer.beginNode("Model");
+        writer.addLong(node.id);
+        writer.addString(objectName(node.name, "Model"));
+        writer.addString(node.type);
+
+        writer.node("Version", 232);
+
+        writer.beginNode("Properties70");
+        if (node.rotationActive)
+            property(writer, "RotationActive", "bool", "", "", 1);
+        property(writer, "InheritType", "enum", "", "", node.inheritType);
+        property(writer, "DefaultAttributeIndex", "int", "Integer", "", 0);
+        vectorProperty(writer, "Lcl Translation", "Lcl Translation", node.translation);
+        vectorProperty(writer, "Lcl Rotation", "Lcl Rotation", node.rotation);
+        vectorProperty(writer, "Lcl Scaling", "Lcl Scaling", node.scale);
+        writer.endNode();
+
+        writer.node("MultiLayer", 0);
+        writer.node("MultiTake", 0);
+        writer.node("Shading", true);
+        writer.node("Culling", "CullingOff");
+
+        writer.endNode();
+    }
+}
+
+void NativeFbxExporter::writeMeshes(NativeFbxWriter& writer) const {
+    for (const auto& mesh : meshes) {
+        writer.beginNode("Geometry");
+        writer.addLong(mesh.geometryId);
+        writer.addString(objectName(mesh.meshName, "Geometry"));
+        writer.addString("Mesh");
+
+        writer.beginNode("Properties70");
+        writer.endNode();
+
+        writer.node("GeometryVersion", 124);
+
+        writer.beginNode("Vertices");
+        writer.addArray(std::span<const double>(mesh.vertices));
+        writer.endNode();
+
+        writer.beginNode("PolygonVertexIndex");
+        writer.addArray(std::span<const int32_t>(mesh.polygonVertexIndex));
+        writer.endNode();
+
+        auto writeLayerElement = [&](const char* element, int32_t index, const char* name, const char* arrayName, const std::vector<double>& values) {
+            writer.beginNode(element);
+            writer.addInt(index);
+            writer.node("Version", 101);
+            writer.node("Name", name);
+            writer.node("MappingInformationType", "ByVertice");
+            writer.node("ReferenceInformationType", "Direct");
+            writer.beginNode(arrayName);
+            writer.addArray(std::span<const double>(values));
+            writer.endNode();
+            writer.endNode();
+        };
+
+        for (size_t i = 0; i < mesh.normals.size(); i++)
+            writeLayerElement("LayerElementNormal", static_cast<int32_t>(i), "", "Normals", mesh.normals[i]);
+
+        for (size_t i = 0; i < mesh.uvs.size(); i++)
+            writeLayerElement("LayerElementUV", static_cast<int32_t>(i), "UVs", "UV", mesh.uvs[i]);
+
+        for (size_t i = 0; i < mesh.colors.size(); i++)
+            writeLayerElement("LayerElementColor", static_cast<int32_t>(i), "", "Colors", mesh.colors[i]);
+
+        const int32_t materialIndices[] = { 0 };
+        writer.beginNode("LayerElementMaterial");
+        writer.addInt(0);
+        writer.node("Version", 101);
+        writer.node("Name", "");
+        writer.node("MappingInformationType", "AllSame");
+        writer.node("ReferenceInformationType", "IndexToDirect");
+        writer.beginNode("Materials");
+        writer.addArray(std::span<const int32_t>(materialIndices));
+        writer.endNode();
+        writer.endNode();
+
+        // Every further set of an element lives in the next layer, like the SDK's CreateElement* places them.
+        auto layerCount = std::max({ size_t(1), mesh.normals.size(), mesh.uvs.size(), mesh.colors.size() });
+        for (size_t layer = 0; layer < layerCount; layer++) {
+            writer.beginNode("Layer");
+            writer.addInt(static_cast<int32_t>(layer));
+            writer.node("Version", 100);
+
+            auto layerElement = [&](const char* type) {
+                writer.beginNode("LayerElement");
+                writer.node("Type", type);
+                writer.node("TypedIndex", static_cast<int32_t>(layer));
+                writer.endNode();
+            };
+
+            if (layer < mesh.normals.size())
+                layerElement("LayerElementNormal");
+            if (layer == 0)
+                layerElement("LayerElementMaterial");
+            if (layer < mesh.colors.size())
+                layerElement("LayerElementColor");
+            if (layer < mesh.uvs.size())
+                layerElement("LayerElementUV");
+
+            writer.endNode();
+        }
+
+        writer.endNode();
+    }
+
+    for (const auto& mesh : meshes) {
+        if (mesh.skinId == 0)
+            continue;
+
+        writer.beginNode("Deformer");
+        writer.addLong(mesh.skinId);
+        // Unnamed meshes would all share one skin name, their mesh id keeps them apart.
+        writer.addString(objectName((mesh.name.empty() ? mesh.meshName : mesh.name) + "_skin", "Deformer"));
+        writer.addString("Skin");
+        writer.node("Version", 101);
+        writer.node("Link_DeformAcuracy", 50.0);
+        writer.endNode();
+
+        // Meshes are placed at the origin, so the cluster transform is the identity.
+        const auto& meshGlobal = transforms.global(mesh.node);
+
+        for (const auto& cluster : mesh.clusters) {
+            writer.beginNode("Deformer");
+            writer.addLong(cluster.id);
+            writer.addString(objectName(mesh.name + "_" + cluster.skin.bone.str() + "_cluster", "SubDeformer"));
+            writer.addString("Cluster");
+            writer.node("Version", 100);
+            writer.node("UserData", "", "");
+            writer.node("Mode", "Total1");
+
+            writer.beginNode("Indexes");
+            writer.addArray(std::span<const int32_t>(cluster.skin.indices));
+            writer.endNode();
+
+            writer.beginNode("Weights");
+            writer.addArray(std::span<const double>(cluster.skin.weights));
+            writer.endNode();
+
+            writer.beginNode("Transform");
+            writer.addArray(std::span<const double>(meshGlobal.values));
+            writer.endNode();
+
+            writer.beginNode("TransformLink");
+            writer.addArray(std::span<const double>(transforms.global(cluster.node).values));
+            writer.endNode();
+
+            writer.endNode();
+        }
+    }
+}
+
+void NativeFbxExporter::writeMaterials(NativeFbxWriter& writer) const {
+    for (const auto& material : materials) {
+        writer.beginNode("Material");
+        writer.addLong(material.id);
+        writer.addString(objectName(material.name, "Material"));
+        writer.addString("");
+
+        writer.node("Version", 102);
+        writer.node("ShadingModel", "unknown");
+        writer.node("MultiLayer", 0);
+
+        writer.beginNode("Properties70");
+        property(writer, "Maya", "Compound", "", "");
+        for (const auto& mayaProperty : MAYA_PROPERTIES) {
+            auto name = std::string("Maya|") + mayaProperty.name;
+            std::string_view shortName(mayaProperty.name);
+
+            switch (mayaProperty.type) {
+                case MayaType::Int:
+                    property(writer, name, "int", "Integer", "", 1166017);
+                    break;
+                case MayaType::Float: {
+                    auto value = 0.0;
+                    if (shortName == "use_normal_map")
+                        value = material.useNormalMap;
+                    else if (shortName == "use_color_map")
+                        value = material.useColorMap;
+                    else if (shortName == "use_metallic_map" || shortName == "use_roughness_map")
+                        value = material.useCoefficientMap;
+                    else if (shortName == "use_emissive_map")
+                        value = material.useEmissiveMap;
+                    else if (shortName == "emissive_intensity")
+                        value = 1.0;
+
+                    property(writer, name, "float", "", "", value);
+                    break;
+                }
+                case MayaType::Double2: {
+                    const auto& value = shortName == "uv_scale" ? material.uvScale : material.uvOffset;
+                    property(writer, name, "Vector2D", "Vector2", "", value[0], value[1]);
+                    break;
+                }
+                case MayaType::Double3:
+                    property(writer, name, "Vector3D", "Vector", "", 0.0, 0.0, 0.0);
+                    break;
+            }
+        }
+        writer.endNode();
+
+        writer.endNode();
+    }
+
+    for (const auto& texture : textures) {
+        writer.beginNode("Texture");
+        writer.addLong(texture.id);
+        writer.addString(objectName(texture.name, "Texture"));
+        writer.addString("");
+
+        writer.node("Type", "TextureVideoClip");
+        writer.node("Version", 202);
+        writer.node("TextureName", objectName(texture.name, "Texture"));
+        writer.beginNode("Properties70");
+        property(writer, "UseMaterial", "bool", "", "", 1);
+        writer.endNode();
+        writer.node("Media", objectName(texture.name, "Video"));
+        writer.node("FileName", texture.path);
+        writer.node("RelativeFilename", texture.path);
+        writer.node("ModelUVTranslation", 0.0, 0.0);
+        writer.node("ModelUVScaling", 1.0, 1.0);
+        writer.node("Texture_Alpha_Source", "None");
+        writer.node("Cropping", 0, 0, 0, 0);
+
+        writer.endNode();
+    }
+
+    // Media is embedded like the SDK does with EXP_FBX_EMBEDDED, when the file can be found.
+    std::vector<unsigned char> content;
+    for (const auto& texture : textures) {
+        writer.beginNode("Video");
+        writer.addLong(texture.videoId);
+        writer.addString(objectName(texture.name, "Video"));
+        writer.addString("Clip");
+
+        writer.node("Type", "Clip");
+        writer.beginNode("Properties70");
+        property(writer, "Path", "KString", "XRefUrl", "", texture.path);
+        writer.endNode();
+        writer.node("UseMipMap", 0);
+        writer.node("Filename", texture.path);
+        writer.node("RelativeFilename", texture.path);
+
+        std::ifstream file(texture.path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (file) {
+            content.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            if (file.read(reinterpret_cast<char*>(content.data()), static_cast<std::streamsize>(content.size()))) {
+                writer.beginNode("Content");
+                writer.addRaw(content);
+                writer.endNode();
+            }
+        }
+
+        writer.endNode();
+    }
+
+    if (implementationId == 0)
+        return;
+
+    const auto& shadergraph = decompressedShadergraph();
+
+    writer.beginNode("Implementation");
+    writer.addLong(implementationId);
+    writer.addString(objectName("PBS_Implementation", "Implementation"));
+    writer.addString("");
+    writer.node("Version", 100);
+    writer.beginNode("Properties70");
+    property(writer, "ShaderLanguage", "KString", "", "", "SFX");
+    property(writer, "ShaderLanguageVersion", "KString", "", "", "28");
+    property(writer, "RenderAPI", "KString", "", "", "SFX_PBS_SHADER");
+    property(writer, "RootBindingName", "KString", "", "", "root");
+    writer.beginNode("P");
+    for (auto value : { "ShaderGraph", "Blob", "", "" })
+        writer.addString(value);
+    writer.addInt(static_cast<int32_t>(shadergraph.size()));
+    writer.beginNode("BinaryData");
+    writer.addRaw(shadergraph);
+    writer.endNode();
+    writer.endNode();
+    writer.endNode();
+    writer.endNode();
+
+    writer.beginNode("BindingTable");
+    writer.addLong(bindingTableId);
+    writer.addString(objectName("root", "BindingTable"));
+    writer.addString("");
+    writer.node("Version", 100);
+    writer.beginNode("Properties70");
+    property(writer, "TargetName", "KString", "", "", "root");
+    property(writer, "TargetType", "KString", "", "", "shader");
+    writer.endNode();
+    for (const auto& mayaProperty : MAYA_PROPERTIES)
+        writer.node("Entry", std::string("Maya|") + mayaProperty.name, "FbxPropertyEntry", mayaProperty.name, "FbxSemanticEntry");
+    writer.endNode();
+}
+
+void NativeFbxExporter::writeAnimations(NativeFbxWriter& writer) const {
+    for (const auto& animation : animations) {
+        writer.beginNode("AnimationStack");
+        writer.addLong(animation.stackId);
+        writer.addString(objectName(animation.name, "AnimStack"));
+        writer.addString("");
+        writer.beginNode("Properties70");
+        property(writer, "LocalStop", "KTime", "Time", "", animation.stop);
+        property(writer, "ReferenceStop", "KTime", "Time", "", animation.stop);
+        writer.endNode();
+        writer.endNode();
+    }
+
+    for (const auto& animation : animations) {
+        writer.beginNode("AnimationLayer");
+        writer.addLong(animation.layerId);
+        writer.addString(objectName(animation.name + "_baseLayer", "AnimLayer"));
+        writer.addString("");
+        writer.endNode();
+    }
+
+    for (const auto& curveNode : curveNodes) {
+        writer.beginNode("AnimationCurveNode");
+        writer.addLong(curveNode.id);
+        writer.addString(objectName(curveNode.name, "AnimCurveNode"));
+        writer.addString("");
+        writer.beginNode("Properties70");
+        property(writer, "d|X", "Number", "", "A", curveNode.defaults[0]);
+        property(writer, "d|Y", "Number", "", "A", curveNode.defaults[1]);
+        property(writer, "d|Z", "Number", "", "A", curveNode.defaults[2]);
+        writer.endNode();
+        writer.endNode();
+    }
+
+    for (const auto& curve : curves) {
+        writer.beginNode("AnimationCurve");
+        writer.addLong(curve.id);
+        writer.addString(objectName("", "AnimCurve"));
+        writer.addString("");
+        writer.node("Default", curve.defaultValue);
+        writer.node("KeyVer", 4008);
+
+        writer.beginNode("KeyTime");
+        writer.addArray(std::span<const int64_t>(curve.times));
+        writer.endNode();
+
+        writer.beginNode("KeyValueFloat");
+        writer.addArray(std::span<const float>(curve.values));
+        writer.endNode();
+
+        writer.beginNode("KeyAttrFlags");
+        writer.addArray(std::span<const int32_t>(curve.attributeFlags));
+        writer.endNode();
+
+        writer.beginNode("KeyAttrDataFloat");
+        writer.addArray(std::span<const float>(curve.attributeData));
+        writer.endNode();
+
+        writer.beginNode("KeyAttrRefCount");
+        writer.addArray(std::span<const int32_t>(curve.attributeRefCounts));
+        writer.endNode();
+
+        writer.endNode();
+    }
+}
+
+void NativeFbxExporter::writeConnections(NativeFbxWriter& writer) const {
+    writer.beginNode("Connections");
+    for (const auto& connection : connections) {
+        if (connection.property == nullptr)
+            writer.node("C", "OO", connection.child, connection.parent);
+        else
+            writer.node("C", "OP", connection.child, connection.parent, connection.property);
+    }
+    writer.endNode();
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "MeshBuilder.hh"
+#include "ResourceLoader.hh"
+#include "Stopwatch.hh"
+#include "Transform.hh"
+
+#include <array>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class NativeFbxWriter;
+
+// Writes Badger models to binary FBX without the FBX SDK. It emits exactly the objects FbxConverter
+// builds: skeleton and locator nodes, meshes with their layer elements, skins, the Stingray PBS
+// materials with their textures, and one anim stack per animation.
+class NativeFbxExporter {
+    public:
+        explicit NativeFbxExporter(const char* resourcePacksDir);
+        explicit NativeFbxExporter(ResourceLoader& loader);
+        ~NativeFbxExporter();
+
+        bool convertToFbx(const char* model, const char* output);
+        const PhaseTimings& getTimings() const { return timings; }
+
+        // Worker threads used to prepare meshes, 0 uses one per hardware thread.
+        size_t threads = 0;
+    private:
+        using Vector3 = std::array<double, 3>;
+
+        struct Node {
+            int64_t id;
+            int64_t attributeId;
+            std::string name;
+            std::string attributeName;
+            // Model and node attribute subclass: Root, LimbNode, Null or Mesh.
+            const char* type;
+            int64_t parent;
+            Vector3 translation;
+            Vector3 rotation;
+            Vector3 scale;
+            int inheritType;
+            bool rotationActive;
+        };
+
+        struct Cluster {
+            int64_t id = 0;
+            size_t node = 0;
+            SkinCluster skin;
+        };
+
+        // Geometry in the layout it is written in, computed without touching the scene.
+        struct Mesh {
+            std::string nodeName;
+            std::string meshName;
+            std::string name;
+            std::string material;
+            int64_t geometryId = 0;
+            int64_t skinId = 0;
+            size_t node = 0;
+            std::vector<double> vertices;
+            std::vector<int32_t> polygonVertexIndex;
+            std::vector<std::vector<double>> normals;
+            std::vector<std::vector<double>> uvs;
+            std::vector<std::vector<double>> colors;
+            std::vector<Cluster> clusters;
+        };
+
+        struct Texture {
+            int64_t id;
+            int64_t videoId;
+            std::string name;
+            std::string path;
+        };
+
+        struct Material {
+            int64_t id;
+            std::string name;
+            bool useColorMap;
+            bool useNormalMap;
+            bool useCoefficientMap;
+            bool useEmissiveMap;
+            std::array<double, 2> uvOffset;
+            std::array<double, 2> uvScale;
+        };
+
+        struct Curve {
+            int64_t id;
+            double defaultValue;
+            std::vector<int64_t> times;
+            std::vector<float> values;
+            // Run-length encoded key attributes: flags and four data floats each, and how many keys in a row use them.
+            std::vector<int32_t> attributeFlags;
+            std::vector<float> attributeData;
+            std::vector<int32_t> attributeRefCounts;
+        };
+
+        struct CurveNode {
+            int64_t id;
+            const char* name;
+            const char* property;
+            size_t node;
+            Vector3 defaults;
+            std::array<size_t, 3> curves;
+        };
+
+        struct Animation {
+            int64_t stackId;
+            int64_t layerId;
+            std::string name;
+            int64_t stop;
+        };
+
+        struct Connection {
+            int64_t child;
+            int64_t parent;
+            const char* property;
+        };
+
+        NativeFbxExporter(ResourceLoader* loader, bool ownsLoader);
+        void reset();
+        int64_t nextId() { return lastId++; }
+        void connect(int64_t child, int64_t parent, const char* property = nullptr);
+
+        bool addBone(const Badger::Bone& badgerBone);
+        bool prepareMeshes(const std::vector<Badger::Mesh>& meshes, std::vector<Mesh>& prepared);
+        bool prepareMesh(const Badger::Mesh& meshData, size_t meshId, Mesh& prepared);
+        bool attachMesh(Mesh& prepared);
+        int addMaterial(const std::string& name);
+        bool addAnimation(const std::string& name, const Badger::Animation& badgerAnimation);
+
+        bool write(const char* output);
+        void writeHeader(NativeFbxWriter& writer, const char* output) const;
+        void writeDefinitions(NativeFbxWriter& writer) const;
+        void writeNodes(NativeFbxWriter& writer) const;
+        void writeMeshes(NativeFbxWriter& writer) const;
+        void writeMaterials(NativeFbxWriter& writer) const;
+        void writeAnimations(NativeFbxWriter& writer) const;
+        void writeConnections(NativeFbxWriter& writer) const;
+
+        ResourceLoader* loader;
+        bool ownsLoader;
+        int64_t lastId;
+        // Every node has the global bind transform with its index in transforms, parents come first.
+        std::vector<Node> nodes;
+        TransformTable transforms;
+        // Bones and locators are named in separate indices, meshes only bind to bones.
+        std::unordered_map<Symbol, size_t> boneIndices;
+        std::unordered_map<Symbol, size_t> locatorIndices;
+        std::vector<Mesh> meshes;
+        std::vector<Material> materials;
+        std::unordered_map<Symbol, size_t> materialIndices;
+        std::vector<Texture> textures;
+        int64_t implementationId;
+        int64_t bindingTableId;
+        std::vector<Animation> animations;
+        std::vector<CurveNode> curveNodes;
+        std::vector<Curve> curves;
+        std::vector<Connection> connections;
+        std::filesystem::path textureDirectory;
+        PhaseTimings timings;
+};
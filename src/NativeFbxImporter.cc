@@ -0,0 +1,740 @@
+#include "NativeFbxImporter.hh"
+#include "BadgerWriter.hh"
+#include "Log.hh"
+#include "Parallel.hh"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+    constexpr double TICKS_PER_SECOND = 46186158000.0;
+
+    // FbxTransform::eInheritRrs, the inherit type FbxConverter gives locators that discard scale.
+    constexpr int64_t INHERIT_RRS = 2;
+
+    std::string_view objectName(const NativeFbxReader::Node& node) {
+        auto property = node.property(1);
+        if (property == nullptr)
+            return {};
+
+        // Names are stored as "name\0\x01Class".
+        auto name = property->asString();
+        return name.substr(0, name.find(std::string_view("\0\x01", 2)));
+    }
+
+    ElementMapping elementMapping(const NativeFbxReader::Node& element) {
+        auto mapping = element.child("MappingInformationType");
+        if (mapping == nullptr || mapping->properties.empty())
+            return ElementMapping::ByControlPoint;
+
+        auto mode = mapping->properties[0].asString();
+        if (mode == "ByPolygonVertex")
+            return ElementMapping::ByPolygonVertex;
+        if (mode == "ByPolygon")
+            return ElementMapping::ByPolygon;
+        if (mode == "AllSame")
+            return ElementMapping::AllSame;
+        return ElementMapping::ByControlPoint;
+    }
+
+    bool isIndexed(const NativeFbxReader::Node& element) {
+        auto reference = element.child("ReferenceInformationType");
+        return reference != nullptr && !reference->properties.empty() && reference->properties[0].asString() != "Direct";
+    }
+
+    // Layer elements of one kind ordered by their index, like FbxLayerContainer::GetElement*(i).
+    std::vector<const NativeFbxReader::Node*> layerElements(const NativeFbxReader::Node& geometry, std::string_view name) {
+        std::vector<const NativeFbxReader::Node*> elements;
+        for (const auto& child : geometry.children) {
+            if (child.name == name)
+                elements.push_back(&child);
+        }
+
+        std::stable_sort(elements.begin(), elements.end(), [](const auto* a, const auto* b) {
+            auto indexA = a->property(0) ? a->property(0)->asLong() : 0;
+            auto indexB = b->property(0) ? b->property(0)->asLong() : 0;
+            return indexA < indexB;
+        });
+        return elements;
+    }
+}
+
+void NativeFbxImporter::reset() {
+    objects.clear();
+    rootChildren.clear();
+    model = {};
+    model.formatVersion = "1.14.0";
+    exportedMaterials.clear();
+    exportedAnimations.clear();
+}
+
+bool NativeFbxImporter::convertToBadger(const char* fbx, const char* outputDirectory) {
+    reset();
+    timings.clear();
+    Stopwatch stopwatch;
+
+    auto fbxFilename = std::filesystem::path(fbx).stem().string();
+
+    Log::info() << "Reading fbx.";
+
+    if (!reader.read(fbx) || !indexObjects())
+        return false;
+    timings.record("read", stopwatch);
+
+    Badger::Geometry geometry;
+    geometry.description.identifier = "geometry." + fbxFilename;
+
+    // One pre-order walk from the scene root, bones are exported as they are reached. A model has a single parent,
+    // so one reached twice means the connections form a cycle.
+    std::vector<int64_t> meshModels;
+    std::unordered_set<int64_t> visited;
+    std::vector<std::pair<int64_t, int64_t>> pending;
+    for (auto it = rootChildren.rbegin(); it != rootChildren.rend(); it++)
+        pending.emplace_back(*it, 0);
+
+    while (!pending.empty()) {
+        auto [id, parent] = pending.back();
+        pending.pop_back();
+
+        auto object = findObject(id);
+        if (object == nullptr || object->node->name != "Model")
+            continue;
+
+        if (!visited.insert(id).second) {
+            Log::error() << "Error: fbx model " << object->name << " is connected more than once.";
+            return false;
+        }
+
+        auto kind = kindOf(*object);
+        if (kind == ObjectKind::Skeleton) {
+            Log::verbose() << "Node: " << object->name << " - exporting bone.";
+            if (!exportBone(geometry, id, parent)) {
+                Log::error() << "Error: failed to export bone.";
+                return false;
+            }
+        } else if (kind == ObjectKind::Mesh) {
+            Log::verbose() << "Node: " << object->name << " - collecting mesh.";
+            meshModels.push_back(id);
+        }
+
+        for (auto it = object->sources.rbegin(); it != object->sources.rend(); it++) {
+            if (it->property.empty())
+                pending.emplace_back(it->id, id);
+        }
+    }
+
+    timings.record("bones", stopwatch);
+
+    Log::info() << "Exporting " << meshModels.size() << " meshes.";
+    if (!exportMeshes(geometry, meshModels))
+        return false;
+    timings.record("extract", stopwatch);
+
+    // Stacks are taken in file order, which is the order the SDK lists them in.
+    std::vector<const Object*> stacks;
+    for (const auto& node : reader.section("Objects")->children) {
+        if (node.name == "AnimationStack" && !node.properties.empty()) {
+            if (auto stack = findObject(node.properties[0].asLong()); stack != nullptr)
+                stacks.push_back(stack);
+        }
+    }
+
+    if (!stacks.empty()) {
+        Log::info() << "Exporting animations.";
+        for (auto stack : stacks) {
+            if (!exportAnimation(*stack)) {
+                Log::error() << "Error: failed to export animation.";
+                return false;
+            }
+        }
+    }
+    timings.record("animations", stopwatch);
+
+    if (geometry.bones.empty()) {
+        Badger::Bone bone {
+            .info {
+                .bindPoseRotation {
+                    0, 0, 0
+                }
+            },
+            .locators = {},
+            .name = "minecraft:geometry_root_bone",
+            .parent = "",
+            .pivot = {
+                0, 0, 0
+            },
+            .scale {
+                1, 1, 1
+            }
+        };
+
+        geometry.bones.push_back(bone);
+    }
+
+    model.geometry.push_back(geometry);
+
+    if (!writeBadgerPack(outputDirectory, fbxFilename, model, exportedMaterials, exportedAnimations))
+        return false;
+
+    timings.record("write", stopwatch);
+
+    Log::info() << "Export finished.";
+
+    return true;
+}
+
+bool NativeFbxImporter::indexObjects() {
+    auto objectsSection = reader.section("Objects");
+    auto connectionsSection = reader.section("Connections");
+    if (objectsSection == nullptr || connectionsSection == nullptr) {
+        Log::error() << "Error: fbx file has no objects or connections.";
+        return false;
+    }
+
+    objects.reserve(objectsSection->children.size());
+    for (const auto& node : objectsSection->children) {
+        auto id = node.property(0);
+        if (id == nullptr || !id->isNumber())
+            continue;
+
+        auto subclass = node.property(2);
+        objects[id->asLong()] = Object {
+            .node = &node,
+            .name = objectName(node),
+            .subclass = subclass ? subclass->asString() : std::string_view(),
+            .sources = {},
+            .destinations = {}
+        };
+    }
+
+    for (const auto& connection : connectionsSection->children) {
+        if (connection.name != "C" || connection.properties.size() < 3)
+            continue;
+
+        auto type = connection.properties[0].asString();
+        auto child = connection.properties[1].asLong();
+        auto parent = connection.properties[2].asLong();
+        std::string_view property;
+        if (type == "OP" && connection.properties.size() > 3)
+            property = connection.properties[3].asString();
+        else if (type != "OO")
+            continue;
+
+        if (auto it = objects.find(child); it != objects.end())
+            it->second.destinations.push_back({ parent, property });
+
+        if (parent == 0) {
+            if (property.empty())
+                rootChildren.push_back(child);
+        } else if (auto it = objects.find(parent); it != objects.end()) {
+            it->second.sources.push_back({ child, property });
+        }
+    }
+
+    return true;
+}
+
+const NativeFbxImporter::Object* NativeFbxImporter::findObject(int64_t id) const {
+    auto it = objects.find(id);
+    return it == objects.end() ? nullptr : &it->second;
+}
+
+const NativeFbxReader::Node* NativeFbxImporter::findProperty(const Object& object, std::string_view name) const {
+    auto properties = object.node->child("Properties70");
+    if (properties == nullptr)
+        return nullptr;
+
+    for (const auto& property : properties->children) {
+        if (property.name == "P" && !property.properties.empty() && property.properties[0].asString() == name)
+            return &property;
+    }
+    return nullptr;
+}
+
+std::array<double, 3> NativeFbxImporter::getVector(const Object& object, std::string_view name, const std::array<double, 3>& fallback) const {
+    // P records hold name, type, label and flags before the values.
+    auto property = findProperty(object, name);
+    if (property == nullptr || property->properties.size() < 7)
+        return fallback;
+
+    return {
+        property->properties[4].asDouble(),
+        property->properties[5].asDouble(),
+        property->properties[6].asDouble()
+    };
+}
+
+const NativeFbxImporter::Object* NativeFbxImporter::findSource(const Object& object, std::string_view nodeName, std::string_view subclass, std::string_view property) const {
+    for (const auto& source : object.sources) {
+        if (source.property != property)
+            continue;
+
+        auto sourceObject = findObject(source.id);
+        if (sourceObject != nullptr && sourceObject->node->name == nodeName && (subclass.empty() || sourceObject->subclass == subclass))
+            return sourceObject;
+    }
+    return nullptr;
+}
+
+NativeFbxImporter::ObjectKind NativeFbxImporter::kindOf(const Object& model) const {
+    // The node attribute decides the type, like FbxNode::GetNodeAttribute()->GetAttributeType().
+    if (auto attribute = findSource(model, "NodeAttribute"); attribute != nullptr) {
+        if (attribute->subclass == "LimbNode" || attribute->subclass == "Root" || attribute->subclass == "Limb")
+            return ObjectKind::Skeleton;
+        if (attribute->subclass == "Null")
+            return ObjectKind::Null;
+        return ObjectKind::Other;
+    }
+
+    if (findSource(model, "Geometry", "Mesh") != nullptr)
+        return ObjectKind::Mesh;
+
+    if (model.subclass == "LimbNode" || model.subclass == "Root" || model.subclass == "Limb")
+        return ObjectKind::Skeleton;
+    if (model.subclass == "Null")
+        return ObjectKind::Null;
+    return ObjectKind::Other;
+}
+
+bool NativeFbxImporter::exportBone(Badger::Geometry& geometry, int64_t id, int64_t parent) {
+    const auto& node = *findObject(id);
+
+    auto convertVector = [](const std::array<double, 3>& vec) -> std::vector<double> {
+        return std::vector<double>(vec.begin(), vec.end());
+    };
+
+    Badger::Bone badgerBone {};
+    badgerBone.name = node.name;
+
+    badgerBone.scale = convertVector(getVector(node, "Lcl Scaling", { 1, 1, 1 }));
+    badgerBone.pivot = convertVector(getVector(node, "Lcl Translation", { 0, 0, 0 }));
+    badgerBone.info.bindPoseRotation = convertVector(getVector(node, "Lcl Rotation", { 0, 0, 0 }));
+
+    if (auto parentObject = findObject(parent); parentObject != nullptr && kindOf(*parentObject) == ObjectKind::Skeleton)
+        badgerBone.parent = parentObject->name;
+
+    for (const auto& source : node.sources) {
+        auto child = findObject(source.id);
+        if (!source.property.empty() || child == nullptr || child->node->name != "Model" || kindOf(*child) != ObjectKind::Null)
+            continue;
+
+        auto inheritType = findProperty(*child, "InheritType");
+
+        Badger::BoneLocator locator {};
+        locator.discardScale = inheritType != nullptr && inheritType->properties.size() > 4 && inheritType->properties[4].asLong() == INHERIT_RRS;
+        locator.offset = convertVector(getVector(*child, "Lcl Translation", { 0, 0, 0 }));
+        locator.rotation = convertVector(getVector(*child, "Lcl Rotation", { 0, 0, 0 }));
+        badgerBone.locators.insert({std::string(child->name), locator});
+    }
+
+    geometry.bones.push_back(badgerBone);
+    return true;
+}
+
+bool NativeFbxImporter::exportMeshes(Badger::Geometry& geometry, const std::vector<int64_t>& meshModels) {
+    std::vector<Badger::Mesh> meshes(meshModels.size());
+    std::vector<const Object*> materials(meshModels.size(), nullptr);
+    std::vector<char> succeeded(meshModels.size(), false);
+
+    parallelFor(meshModels.size(), threads, [&](size_t i) {
+        const auto& node = *findObject(meshModels[i]);
+        Log::verbose() << "Node: " << node.name << " - exporting mesh.";
+        succeeded[i] = exportMesh(meshes[i], materials[i], node);
+    });
+
+    for (size_t i = 0; i < meshModels.size(); i++) {
+        if (!succeeded[i]) {
+            Log::error() << "Error: failed to export mesh " << findObject(meshModels[i])->name << ".";
+            return false;
+        }
+
+        if (!exportMaterial(*materials[i]))
+            return false;
+
+        meshes[i].material = exportedMaterials.at(std::string(materials[i]->name)).name;
+        geometry.meshes.push_back(std::move(meshes[i]));
+    }
+
+    return true;
+}
+
+bool NativeFbxImporter::exportMesh(Badger::Mesh& badgerMesh, const Object*& material, const Object& model) const {
+    auto geometryObject = findSource(model, "Geometry", "Mesh");
+    const auto& geometry = *geometryObject->node;
+
+    auto verticesNode = geometry.child("Vertices");
+    auto polygonsNode = geometry.child("PolygonVertexIndex");
+    if (verticesNode == nullptr || verticesNode->properties.empty() || polygonsNode == nullptr || polygonsNode->properties.empty()) {
+        Log::error() << "Error: mesh has no vertices or polygons.";
+        return false;
+    }
+
+    Log::verbose() << "Exporting positions.";
+
+    std::vector<double> values;
+    if (!reader.readArray(verticesNode->properties[0], values))
+        return false;
+
+    auto controlPointCount = values.size() / 3;
+    MeshSource meshSource;
+    meshSource.positions.resize(controlPointCount);
+    for (size_t i = 0; i < controlPointCount; i++)
+        meshSource.positions[i] = { values[i * 3], values[i * 3 + 1], values[i * 3 + 2] };
+
+    Log::verbose() << "Exporting triangles.";
+
+    std::vector<int32_t> polygonVertices;
+    if (!reader.readArray(polygonsNode->properties[0], polygonVertices))
+        return false;
+
+    // The last index of every polygon is stored as its one's complement.
+    std::vector<int> polygonSizes;
+    size_t polygonStart = 0;
+    for (size_t i = 0; i < polygonVertices.size(); i++) {
+        if (polygonVertices[i] >= 0)
+            continue;
+
+        polygonVertices[i] = ~polygonVertices[i];
+        polygonSizes.push_back(static_cast<int>(i + 1 - polygonStart));
+        polygonStart = i + 1;
+    }
+
+    // A trailing polygon without its end marker is ignored.
+    polygonVertices.resize(polygonStart);
+
+    Triangulation triangulation;
+    if (!triangulatePolygons(polygonVertices, polygonSizes, values.data(), controlPointCount, 3, triangulation)) {
+        Log::error() << "Error: failed to triangulate mesh, a polygon vertex is out of range.";
+        return false;
+    }
+
+    if (triangulation.splitPolygons != 0)
+        Log::verbose() << "Triangulated " << triangulation.splitPolygons << " polygons.";
+
+    // Elements are kept as they are stored, buildMesh resolves their mapping and index arrays.
+    auto readElements = [&](std::string_view elementName, std::string_view arrayName, std::string_view indexName, size_t components, auto&& convert, std::vector<MeshElement>& elements) -> bool {
+        for (auto element : layerElements(geometry, elementName)) {
+            auto array = element->child(arrayName);
+            if (array == nullptr || array->properties.empty() || !reader.readArray(array->properties[0], values))
+                return false;
+
+            MeshElement meshElement;
+            meshElement.mapping = elementMapping(*element);
+
+            auto count = values.size() / components;
+            meshElement.values.resize(count);
+            for (size_t j = 0; j < count; j++)
+                meshElement.values[j] = convert(&values[j * components]);
+
+            if (isIndexed(*element)) {
+                auto indexArray = element->child(indexName);
+                std::vector<int32_t> indices;
+                if (indexArray == nullptr || indexArray->properties.empty() || !reader.readArray(indexArray->properties[0], indices))
+                    return false;
+                meshElement.indices.assign(indices.begin(), indices.end());
+            }
+
+            elements.push_back(std::move(meshElement));
+        }
+        return true;
+    };
+
+    Log::verbose() << "Exporting normals.";
+
+    if (!readElements("LayerElementNormal", "Normals", "NormalsIndex", 3, [](const double* normal) { return std::vector<double> { normal[0], normal[1], normal[2], 1.0 }; }, meshSource.normals)) {
+        Log::error() << "Error: invalid normal layer element.";
+        return false;
+    }
+
+    Log::verbose() << "Exporting UVs.";
+
+    if (!readElements("LayerElementUV", "UV", "UVIndex", 2, [](const double* uv) { return std::vector<double> { uv[0], 1 - uv[1] }; }, meshSource.uvs)) {
+        Log::error() << "Error: invalid UV layer element.";
+        return false;
+    }
+
+    Log::verbose() << "Exporting vertex colors.";
+
+    if (!readElements("LayerElementColor", "Colors", "ColorIndex", 4, [](const double* color) { return std::vector<double>(color, color + 4); }, meshSource.colors)) {
+        Log::error() << "Error: invalid color layer element.";
+        return false;
+    }
+
+    // Only the first deformer is considered, like mesh->GetDeformer(0).
+    const Object* skin = nullptr;
+    for (const auto& source : geometryObject->sources) {
+        auto deformer = findObject(source.id);
+        if (deformer != nullptr && deformer->node->name == "Deformer") {
+            skin = deformer->subclass == "Skin" ? deformer : nullptr;
+            break;
+        }
+    }
+
+    if (skin != nullptr) {
+        Log::verbose() << "Exporting skin information.";
+
+        meshSource.weights.resize(controlPointCount);
+        meshSource.boneNames.resize(controlPointCount);
+
+        std::vector<int32_t> indices;
+        std::vector<double> weights;
+        for (const auto& source : skin->sources) {
+            auto cluster = findObject(source.id);
+            if (cluster == nullptr || cluster->node->name != "Deformer" || cluster->subclass != "Cluster")
+                continue;
+
+            auto link = findSource(*cluster, "Model");
+            if (link == nullptr) {
+                Log::error() << "Error: skin cluster had no bone linked to it.";
+                return false;
+            }
+
+            auto indicesNode = cluster->node->child("Indexes");
+            auto weightsNode = cluster->node->child("Weights");
+            if (indicesNode == nullptr && weightsNode == nullptr)
+                continue;
+
+            if (indicesNode == nullptr || indicesNode->properties.empty() || !reader.readArray(indicesNode->properties[0], indices)) {
+                Log::error() << "Error: skin cluster has no indices.";
+                return false;
+            }
+
+            if (weightsNode == nullptr || weightsNode->properties.empty() || !reader.readArray(weightsNode->properties[0], weights) || weights.size() != indices.size()) {
+                Log::error() << "Error: skin cluster has no weights.";
+                return false;
+            }
+
+            Symbol boneName(link->name);
+
+            for (size_t j = 0; j < indices.size(); j++) {
+                auto controlPointIndex = indices[j];
+                if (controlPointIndex < 0 || static_cast<size_t>(controlPointIndex) >= controlPointCount) {
+                    Log::error() << "Error: skin cluster contains control point index which is greater than the total control point count.";
+                    return false;
+                }
+
+                meshSource.boneNames[controlPointIndex].push_back(boneName);
+                meshSource.weights[controlPointIndex].push_back(weights[j]);
+            }
+        }
+
+        if (auto pruned = limitInfluences(meshSource, influenceLimits); pruned != 0)
+            Log::info() << "Pruned " << pruned << " skin influences from mesh " << model.name << ".";
+    }
+
+    Log::verbose() << "Building vertices.";
+
+    if (!buildMesh(meshSource, triangulation, weldTolerance, badgerMesh))
+        return false;
+
+    Log::verbose() << "Exporting material.";
+
+    auto materialElements = layerElements(geometry, "LayerElementMaterial");
+    if (materialElements.empty()) {
+        Log::error() << "Error: mesh has no material.";
+        return false;
+    } else if (materialElements.size() > 1) {
+        Log::warning() << "Warning: mesh has more than one material, using first.";
+    }
+
+    std::vector<int32_t> materialIndices;
+    auto materialsNode = materialElements[0]->child("Materials");
+    if (materialsNode == nullptr || materialsNode->properties.empty() || !reader.readArray(materialsNode->properties[0], materialIndices) || materialIndices.empty()) {
+        Log::error() << "Error: mesh has no material.";
+        return false;
+    }
+
+    // The index refers to the materials connected to the model node, in connection order.
+    auto materialIndex = materialIndices[0];
+    int32_t current = 0;
+    material = nullptr;
+    for (const auto& source : model.sources) {
+        auto sourceObject = findObject(source.id);
+        if (source.property.empty() && sourceObject != nullptr && sourceObject->node->name == "Material" && current++ == materialIndex) {
+            material = sourceObject;
+            break;
+        }
+    }
+
+    if (material == nullptr) {
+        Log::error() << "Error: mesh material index " << materialIndex << " is out of range.";
+        return false;
+    }
+
+    return true;
+}
+
+bool NativeFbxImporter::exportMaterial(const Object& material) {
+    const std::string name(material.name);
+    if (auto it = exportedMaterials.find(name); it != exportedMaterials.end())
+        return true;
+
+    Badger::MetaMaterial metaMaterial;
+    auto matDelim = name.rfind("___");
+    if (matDelim != std::string::npos) {
+        metaMaterial.name = name.substr(0, matDelim);
+        metaMaterial.baseName = name.substr(matDelim + 3);
+    } else {
+        metaMaterial.name = name;
+    }
+
+    metaMaterial.formatVersion = "1.8.0";
+    metaMaterial.info.culling = "none";
+
+    auto assignTextureName = [&](const char* isUsedProperty, const char* texProperty, std::string& badgerProp) -> bool {
+        auto usedProp = findProperty(material, isUsedProperty);
+        if (usedProp == nullptr || usedProp->properties.size() < 5) {
+            Log::error() << "Could not find property " << isUsedProperty << " on material.";
+            return false;
+        }
+
+        if (usedProp->properties[4].asDouble() != 0) {
+            auto connectedTexture = findSource(material, "Texture", {}, texProperty);
+            if (connectedTexture == nullptr) {
+                Log::error() << "Material has no connected texture for property " << texProperty;
+                return false;
+            }
+
+            auto fileName = connectedTexture->node->child("FileName");
+            if (fileName == nullptr || fileName->properties.empty())
+                fileName = connectedTexture->node->child("RelativeFilename");
+
+            if (fileName != nullptr && !fileName->properties.empty())
+                badgerProp = fileName->properties[0].asString();
+        }
+
+        return true;
+    };
+
+    assignTextureName("Maya|use_color_map", "Maya|TEX_color_map", metaMaterial.info.textures.diffuse);
+    assignTextureName("Maya|use_normal_map", "Maya|TEX_normal_map", metaMaterial.info.textures.normal);
+    assignTextureName("Maya|use_metallic_map", "Maya|TEX_metallic_map", metaMaterial.info.textures.coeff);
+    assignTextureName("Maya|use_emissive_map", "Maya|TEX_emissive_map", metaMaterial.info.textures.emissive);
+
+    exportedMaterials.insert({name, metaMaterial});
+    return true;
+}
+
+bool NativeFbxImporter::exportAnimation(const Object& stack) {
+    std::string name(stack.name);
+
+    if (!name.starts_with("animation."))
+        name = "animation." + name;
+
+    Badger::Animation badgerAnimation {
+        .animTimeUpdate = "(query.anim_time + (query.delta_time * 1))",
+        .blendWeight = "1",
+        .bones = {}
+    };
+
+    auto baseLayer = findSource(stack, "AnimationLayer");
+    if (baseLayer == nullptr) {
+        Log::error() << "Error: animation has no base layer!";
+        return false;
+    }
+
+    std::vector<int64_t> keyTimes;
+    std::vector<float> keyValues;
+
+    for (const auto& layerSource : baseLayer->sources) {
+        auto curveNode = findObject(layerSource.id);
+        if (curveNode == nullptr || curveNode->node->name != "AnimationCurveNode")
+            continue;
+
+        const Object* bone = nullptr;
+        std::string_view propertyName;
+        for (const auto& destination : curveNode->destinations) {
+            if (!destination.property.empty()) {
+                bone = findObject(destination.id);
+                propertyName = destination.property;
+                break;
+            }
+        }
+
+        if (bone == nullptr) {
+            Log::warning() << "Warning: unsupported curve node in animation.";
+            continue;
+        }
+
+        auto isTranslation = propertyName == "Lcl Translation";
+        auto isRotation = !isTranslation && propertyName == "Lcl Rotation";
+        auto isScale = !isTranslation && !isRotation && propertyName == "Lcl Scaling";
+
+        if (!isTranslation && !isRotation && !isScale) {
+            Log::warning() << "Warning: unsupported connected curve property (" << propertyName << ") in animation. Only translation, rotation and scale is supported.";
+            continue;
+        }
+
+        auto curveX = findSource(*curveNode, "AnimationCurve", {}, "d|X");
+        auto curveY = findSource(*curveNode, "AnimationCurve", {}, "d|Y");
+        auto curveZ = findSource(*curveNode, "AnimationCurve", {}, "d|Z");
+
+        auto defaultValues = getVector(*bone, propertyName, isScale ? std::array<double, 3> { 1, 1, 1 } : std::array<double, 3> { 0, 0, 0 });
+
+        if (curveX == nullptr || curveY == nullptr || curveZ == nullptr) {
+            Log::error() << "Error: one or more required curve components are missing.";
+            return false;
+        }
+
+        // Times are shared by index between the channels, like KeyGet(j) on each curve.
+        std::array<std::vector<float>, 3> values;
+        std::array<const Object*, 3> curves { curveX, curveY, curveZ };
+        for (auto axis = 0; axis < 3; axis++) {
+            auto timesNode = curves[axis]->node->child("KeyTime");
+            auto valuesNode = curves[axis]->node->child("KeyValueFloat");
+            if (timesNode == nullptr || valuesNode == nullptr || timesNode->properties.empty() || valuesNode->properties.empty()
+                || !reader.readArray(valuesNode->properties[0], values[axis]) || (axis == 0 && !reader.readArray(timesNode->properties[0], keyTimes))) {
+                Log::error() << "Error: invalid animation curve.";
+                return false;
+            }
+        }
+
+        auto xKeyCount = values[0].size();
+        auto yKeyCount = values[1].size();
+        auto zKeyCount = values[2].size();
+
+        if (xKeyCount != yKeyCount || zKeyCount != xKeyCount || keyTimes.size() != xKeyCount) {
+            Log::error() << "Error: key count mismatch between the x/y/z animation curves. (" << xKeyCount << "/" << yKeyCount << "/" << zKeyCount << ")";
+            Log::warning() << "Hint: if you are exporting this model from blender, setting \"Simplify\" to 0.0 will fix this issue.";
+            return false;
+        }
+
+        std::unordered_map<double, Badger::AnimationProperty> keyframeData;
+        keyframeData.reserve(xKeyCount);
+
+        for (size_t j = 0; j < xKeyCount; j++) {
+            keyframeData.insert({
+                keyTimes[j] / TICKS_PER_SECOND,
+                {
+                    .lerpMode = "catmullrom",
+                    .post = {
+                        values[0][j] - defaultValues[0],
+                        values[1][j] - defaultValues[1],
+                        values[2][j] - defaultValues[2]
+                    }
+                }
+            });
+        }
+
+        std::string boneName(bone->name);
+
+        if (!badgerAnimation.bones.contains(boneName)) {
+            badgerAnimation.bones.insert({boneName, {
+                .lodDistance = 0,
+                .rotation = {},
+                .position = {},
+                .scale = {}
+            }});
+        }
+
+        if (isTranslation)
+            badgerAnimation.bones[boneName].position = keyframeData;
+        else if (isRotation)
+            badgerAnimation.bones[boneName].rotation = keyframeData;
+        else if (isScale)
+            badgerAnimation.bones[boneName].scale = keyframeData;
+    }
+
+    exportedAnimations.insert({name, badgerAnimation});
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "MeshBuilder.hh"
+#include "NativeFbxReader.hh"
+#include "Stopwatch.hh"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Imports binary FBX files into the Badger format from the records NativeFbxReader parses, without
+// building an FBX SDK scene. Extracts the same data BadgerConverter does: the skeleton with its
+// locators, meshes with their layer elements and skins, Stingray PBS materials and animation curves.
+class NativeFbxImporter {
+    public:
+        bool convertToBadger(const char* fbx, const char* outputFolder);
+        const PhaseTimings& getTimings() const { return timings; }
+
+        // Worker threads used to extract meshes, 0 uses one per hardware thread.
+        size_t threads = 0;
+        // Corners whose positions, normals, UVs, colors and weights differ by no more than this share a vertex, 0 welds
+        // exact matches only.
+        double weldTolerance = 1e-6;
+        // Applied to skinned meshes before their vertices are built.
+        InfluenceLimits influenceLimits;
+    private:
+        enum class ObjectKind { Other, Skeleton, Null, Mesh };
+
+        struct Connection {
+            int64_t id;
+            std::string_view property;
+        };
+
+        // A parsed object record with the connections that reference it, in file order.
+        struct Object {
+            const NativeFbxReader::Node* node = nullptr;
+            std::string_view name;
+            std::string_view subclass;
+            std::vector<Connection> sources;
+            std::vector<Connection> destinations;
+        };
+
+        void reset();
+        bool indexObjects();
+        const Object* findObject(int64_t id) const;
+        const NativeFbxReader::Node* findProperty(const Object& object, std::string_view name) const;
+        std::array<double, 3> getVector(const Object& object, std::string_view name, const std::array<double, 3>& fallback) const;
+        const Object* findSource(const Object& object, std::string_view nodeName, std::string_view subclass = {}, std::string_view property = {}) const;
+        ObjectKind kindOf(const Object& model) const;
+
+        bool exportBone(Badger::Geometry& geometry, int64_t id, int64_t parent);
+        bool exportMeshes(Badger::Geometry& geometry, const std::vector<int64_t>& meshModels);
+        bool exportMesh(Badger::Mesh& badgerMesh, const Object*& material, const Object& model) const;
+        bool exportMaterial(const Object& material);
+        bool exportAnimation(const Object& stack);
+
+        NativeFbxReader reader;
+        std::unordered_map<int64_t, Object> objects;
+        // Children of the scene root, which is not an object itself.
+        std::vector<int64_t> rootChildren;
+        std::unordered_map<std::string, Badger::MetaMaterial> exportedMaterials;
+        std::unordered_map<std::string, Badger::Animation> exportedAnimations;
+        Badger::Model model;
+        PhaseTimings timings;
+};
@@ -0,0 +1,386 @@
+#include "NativeFbxReader.hh"
+#include "Log.hh"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+    constexpr std::string_view HEADER_MAGIC { "Kaydara FBX Binary  \0", 21 };
+    constexpr size_t HEADER_LENGTH = 27;
+    // Starting with 7.5 the record header offsets are 64 bit wide.
+    constexpr uint32_t LARGE_OFFSETS_VERSION = 7500;
+    // Deeper nesting than this does not occur in files written by any exporter.
+    constexpr size_t MAX_DEPTH = 64;
+    // The smallest property, a type code and a 1 byte value.
+    constexpr size_t MIN_PROPERTY_LENGTH = 2;
+    // Deflate never compresses better than about 1032:1, larger claimed array sizes are corrupt.
+    constexpr size_t MAX_INFLATE_RATIO = 1032;
+
+    constexpr std::array<std::string_view, 3> SECTIONS { "GlobalSettings", "Objects", "Connections" };
+
+    template <typename T>
+    T readUnaligned(const unsigned char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    size_t elementSize(char type) {
+        switch (type) {
+            case 'b':
+                return 1;
+            case 'i':
+            case 'f':
+                return 4;
+            case 'l':
+            case 'd':
+                return 8;
+            default:
+                return 0;
+        }
+    }
+
+    template <typename T>
+    constexpr char arrayType() {
+        if constexpr (std::is_same_v<T, double>)
+            return 'd';
+        else if constexpr (std::is_same_v<T, float>)
+            return 'f';
+        else if constexpr (std::is_same_v<T, int64_t>)
+            return 'l';
+        else
+            return 'i';
+    }
+
+    template <typename T>
+    T convertElement(char type, const unsigned char* element) {
+        switch (type) {
+            case 'b':
+                return static_cast<T>(*element);
+            case 'i':
+                return static_cast<T>(readUnaligned<int32_t>(element));
+            case 'f':
+                return static_cast<T>(readUnaligned<float>(element));
+            case 'l':
+                return static_cast<T>(readUnaligned<int64_t>(element));
+            default:
+                return static_cast<T>(readUnaligned<double>(element));
+        }
+    }
+}
+
+bool NativeFbxReader::Property::isArray() const {
+    return elementSize(type) != 0;
+}
+
+bool NativeFbxReader::Property::isNumber() const {
+    return type == 'C' || type == 'Y' || type == 'I' || type == 'L' || type == 'F' || type == 'D';
+}
+
+int64_t NativeFbxReader::Property::asLong() const {
+    switch (type) {
+        case 'C':
+            return *data;
+        case 'Y':
+            return readUnaligned<int16_t>(data);
+        case 'I':
+            return readUnaligned<int32_t>(data);
+        case 'L':
+            return readUnaligned<int64_t>(data);
+        case 'F':
+            return static_cast<int64_t>(readUnaligned<float>(data));
+        case 'D':
+            return static_cast<int64_t>(readUnaligned<double>(data));
+        default:
+            return 0;
+    }
+}
+
+double NativeFbxReader::Property::asDouble() const {
+    switch (type) {
+        case 'F':
+            return readUnaligned<float>(data);
+        case 'D':
+            return readUnaligned<double>(data);
+        default:
+            return static_cast<double>(asLong());
+    }
+}
+
+std::string_view NativeFbxReader::Property::asString() const {
+    if (type != 'S' && type != 'R')
+        return {};
+
+    return std::string_view(reinterpret_cast<const char*>(data), length);
+}
+
+const NativeFbxReader::Node* NativeFbxReader::Node::child(std::string_view childName) const {
+    for (const auto& node : children) {
+        if (node.name == childName)
+            return &node;
+    }
+    return nullptr;
+}
+
+const NativeFbxReader::Property* NativeFbxReader::Node::property(size_t index) const {
+    return index < properties.size() ? &properties[index] : nullptr;
+}
+
+bool NativeFbxReader::read(const std::filesystem::path& path) {
+    file.close();
+    sections.clear();
+    version = 0;
+
+    // Mapped rather than read, so only the pages of the sections that are parsed and the arrays that are
+    // decoded are ever loaded.
+    if (!file.open(path)) {
+        Log::error() << "Error: could not open " << path.string() << ".";
+        return false;
+    }
+
+    if (file.size < HEADER_LENGTH || !std::equal(HEADER_MAGIC.begin(), HEADER_MAGIC.end(), file.data)) {
+        Log::warning() << "Warning: " << path.string() << " is not a binary fbx file.";
+        return false;
+    }
+
+    version = readUnaligned<uint32_t>(&file.data[23]);
+    if (version < 7000) {
+        Log::warning() << "Warning: fbx version " << version << " is not supported by the native reader.";
+        return false;
+    }
+
+    size_t offset = HEADER_LENGTH;
+    while (offset < file.size) {
+        Node node;
+        bool isNull;
+        auto start = offset;
+        if (!parseNode(offset, file.size, node, isNull, 0))
+            return false;
+
+        if (isNull)
+            break;
+
+        // Unused sections are dropped after parsing the record header, parseNode skips their children.
+        if (std::find(SECTIONS.begin(), SECTIONS.end(), node.name) != SECTIONS.end())
+            sections.push_back(std::move(node));
+
+        if (offset <= start)
+            break;
+    }
+
+    return true;
+}
+
+const NativeFbxReader::Node* NativeFbxReader::section(std::string_view name) const {
+    for (const auto& node : sections) {
+        if (node.name == name)
+            return &node;
+    }
+    return nullptr;
+}
+
+bool NativeFbxReader::parseNode(size_t& offset, size_t end, Node& node, bool& isNull, size_t depth) {
+    auto largeOffsets = version >= LARGE_OFFSETS_VERSION;
+    size_t headerLength = largeOffsets ? 25 : 13;
+
+    if (offset > end || headerLength > end - offset || depth > MAX_DEPTH) {
+        Log::error() << "Error: truncated fbx node record at offset " << offset << ".";
+        return false;
+    }
+
+    uint64_t endOffset, propertyCount, propertyListLength;
+    if (largeOffsets) {
+        endOffset = readUnaligned<uint64_t>(&file.data[offset]);
+        propertyCount = readUnaligned<uint64_t>(&file.data[offset + 8]);
+        propertyListLength = readUnaligned<uint64_t>(&file.data[offset + 16]);
+    } else {
+        endOffset = readUnaligned<uint32_t>(&file.data[offset]);
+        propertyCount = readUnaligned<uint32_t>(&file.data[offset + 4]);
+        propertyListLength = readUnaligned<uint32_t>(&file.data[offset + 8]);
+    }
+    uint8_t nameLength = file.data[offset + headerLength - 1];
+
+    isNull = endOffset == 0;
+    if (isNull) {
+        offset += headerLength;
+        return true;
+    }
+
+    // Lengths come straight from the file, so they are compared with the bytes left instead of added up.
+    // The property count is checked against the list length before it sizes the property vector.
+    auto nameStart = offset + headerLength;
+    if (endOffset > end || endOffset <= offset || headerLength + nameLength > endOffset - offset) {
+        Log::error() << "Error: invalid fbx node record at offset " << offset << ".";
+        return false;
+    }
+
+    auto propertiesStart = nameStart + nameLength;
+    if (propertyListLength > endOffset - propertiesStart || propertyCount > propertyListLength / MIN_PROPERTY_LENGTH) {
+        Log::error() << "Error: invalid fbx node record at offset " << offset << ".";
+        return false;
+    }
+    auto propertiesEnd = propertiesStart + propertyListLength;
+
+    node.name = std::string_view(reinterpret_cast<const char*>(&file.data[nameStart]), nameLength);
+
+    // Top level sections that are not needed keep only their name.
+    if (depth == 0 && std::find(SECTIONS.begin(), SECTIONS.end(), node.name) == SECTIONS.end()) {
+        offset = endOffset;
+        return true;
+    }
+
+    offset = propertiesStart;
+    node.properties.resize(propertyCount);
+    for (auto& property : node.properties) {
+        if (!parseProperty(offset, propertiesEnd, property))
+            return false;
+    }
+
+    offset = propertiesEnd;
+    while (offset < endOffset) {
+        Node child;
+        bool childIsNull;
+        if (!parseNode(offset, endOffset, child, childIsNull, depth + 1))
+            return false;
+
+        if (childIsNull)
+            break;
+
+        node.children.push_back(std::move(child));
+    }
+
+    offset = endOffset;
+    return true;
+}
+
+bool NativeFbxReader::parseProperty(size_t& offset, size_t end, Property& property) {
+    if (offset >= end)
+        return false;
+
+    property = { .type = static_cast<char>(file.data[offset]), .data = nullptr, .length = 0, .count = 0, .encoding = 0 };
+    offset++;
+
+    size_t length;
+    switch (property.type) {
+        case 'C':
+            length = 1;
+            break;
+        case 'Y':
+            length = 2;
+            break;
+        case 'I':
+        case 'F':
+            length = 4;
+            break;
+        case 'L':
+        case 'D':
+            length = 8;
+            break;
+        case 'S':
+        case 'R':
+            if (4 > end - offset)
+                return false;
+            property.length = readUnaligned<uint32_t>(&file.data[offset]);
+            offset += 4;
+            length = property.length;
+            break;
+        case 'b':
+        case 'i':
+        case 'l':
+        case 'f':
+        case 'd':
+            if (12 > end - offset)
+                return false;
+            property.count = readUnaligned<uint32_t>(&file.data[offset]);
+            property.encoding = readUnaligned<uint32_t>(&file.data[offset + 4]);
+            property.length = readUnaligned<uint32_t>(&file.data[offset + 8]);
+            offset += 12;
+            length = property.length;
+            break;
+        default:
+            Log::error() << "Error: unknown fbx property type '" << property.type << "'.";
+            return false;
+    }
+
+    if (length > end - offset) {
+        Log::error() << "Error: fbx property exceeds its node.";
+        return false;
+    }
+
+    property.data = &file.data[offset];
+    offset += length;
+    return true;
+}
+
+template <typename T>
+bool NativeFbxReader::decodeArray(const Property& property, std::vector<T>& values) const {
+    auto size = elementSize(property.type);
+    if (size == 0) {
+        Log::error() << "Error: fbx property is not an array.";
+        return false;
+    }
+
+    if (property.encoding > 1) {
+        Log::error() << "Error: unsupported fbx array encoding " << property.encoding << ".";
+        return false;
+    }
+
+    // Checked before anything is allocated, the element count comes straight from the file.
+    auto byteLength = static_cast<size_t>(property.count) * size;
+    if ((property.encoding == 0 && property.length != byteLength)
+        || (property.encoding == 1 && byteLength / MAX_INFLATE_RATIO > property.length)) {
+        Log::error() << "Error: fbx array of " << property.count << " elements does not match its stored length.";
+        return false;
+    }
+
+    auto sameType = property.type == arrayType<T>();
+
+    // Arrays of the requested type are inflated straight into the output.
+    std::vector<unsigned char> converted;
+    unsigned char* target;
+    if (sameType) {
+        values.resize(property.count);
+        target = reinterpret_cast<unsigned char*>(values.data());
+    } else {
+        converted.resize(byteLength);
+        target = converted.data();
+    }
+
+    if (property.encoding == 1) {
+        auto length = static_cast<uLongf>(byteLength);
+        if (uncompress(target, &length, property.data, property.length) != Z_OK || length != byteLength) {
+            Log::error() << "Error: failed to inflate fbx array.";
+            return false;
+        }
+    } else {
+        std::memcpy(target, property.data, byteLength);
+    }
+
+    if (!sameType) {
+        values.resize(property.count);
+        for (size_t i = 0; i < values.size(); i++)
+            values[i] = convertElement<T>(property.type, &converted[i * size]);
+    }
+
+    return true;
+}
+
+bool NativeFbxReader::readArray(const Property& property, std::vector<double>& values) const {
+    return decodeArray(property, values);
+}
+
+bool NativeFbxReader::readArray(const Property& property, std::vector<float>& values) const {
+    return decodeArray(property, values);
+}
+
+bool NativeFbxReader::readArray(const Property& property, std::vector<int32_t>& values) const {
+    return decodeArray(property, values);
+}
+
+bool NativeFbxReader::readArray(const Property& property, std::vector<int64_t>& values) const {
+    return decodeArray(property, values);
+}
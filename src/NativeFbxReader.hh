@@ -0,0 +1,63 @@
+#pragma once
+
+#include "MappedFile.hh"
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+// Parses the binary FBX node format (7.x) without the FBX SDK. Only the Objects, Connections and
+// GlobalSettings sections are parsed, everything else is skipped by its end offset. Properties point
+// into the mapped file, arrays are only decoded when read, straight into the caller's buffer.
+class NativeFbxReader {
+    public:
+        struct Property {
+            // FBX type code: C, Y, I, L, F, D, S, R or the array codes b, i, l, f, d.
+            char type;
+            const unsigned char* data;
+            // Byte length of a string, raw or encoded array payload.
+            uint32_t length;
+            // Element count of an array.
+            uint32_t count;
+            // 1 if the array payload is zlib compressed.
+            uint32_t encoding;
+
+            bool isArray() const;
+            bool isNumber() const;
+            int64_t asLong() const;
+            double asDouble() const;
+            std::string_view asString() const;
+        };
+
+        struct Node {
+            std::string_view name;
+            std::vector<Property> properties;
+            std::vector<Node> children;
+
+            const Node* child(std::string_view childName) const;
+            const Property* property(size_t index) const;
+        };
+
+        bool read(const std::filesystem::path& path);
+
+        const Node* section(std::string_view name) const;
+        uint32_t getVersion() const { return version; }
+
+        // Decodes a numeric array property, converting between element types when needed. Safe to call from several threads.
+        bool readArray(const Property& property, std::vector<double>& values) const;
+        bool readArray(const Property& property, std::vector<float>& values) const;
+        bool readArray(const Property& property, std::vector<int32_t>& values) const;
+        bool readArray(const Property& property, std::vector<int64_t>& values) const;
+
+    private:
+        bool parseNode(size_t& offset, size_t end, Node& node, bool& isNull, size_t depth);
+        bool parseProperty(size_t& offset, size_t end, Property& property);
+
+        template <typename T>
+        bool decodeArray(const Property& property, std::vector<T>& values) const;
+
+        MappedFile file;
+        std::vector<Node> sections;
+        uint32_t version = 0;
+};
@@ -0,0 +1,211 @@
+#include "NativeFbxWriter.hh"
+#include "Log.hh"
+
+#include <zlib.h>
+
+#include <array>
+#include <limits>
+
+namespace {
+    constexpr std::string_view HEADER_MAGIC { "Kaydara FBX Binary  \0\x1a\0", 23 };
+    constexpr uint32_t VERSION = 7400;
+    constexpr size_t NULL_RECORD_LENGTH = 13;
+    constexpr size_t FLUSH_SIZE = 1 << 20;
+
+    constexpr std::array<unsigned char, 16> FOOTER_ID {
+        0xfa, 0xbc, 0xab, 0x09, 0xd0, 0xc8, 0xd4, 0x66, 0xb1, 0x76, 0xfb, 0x83, 0x1c, 0xf7, 0x26, 0x7e
+    };
+
+    constexpr std::array<unsigned char, 16> FOOTER_MAGIC {
+        0xf8, 0x5a, 0x8c, 0x6a, 0xde, 0xf5, 0xd9, 0x7e, 0xec, 0xe9, 0x0c, 0xe3, 0x75, 0x8f, 0x29, 0x0b
+    };
+}
+
+bool NativeFbxWriter::open(const std::filesystem::path& path) {
+    this->path = path;
+    file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file) {
+        Log::error() << "Error: could not open " << path.string() << " for writing.";
+        return false;
+    }
+
+    data.reserve(FLUSH_SIZE + FLUSH_SIZE / 4);
+    data.insert(data.end(), HEADER_MAGIC.begin(), HEADER_MAGIC.end());
+    write(VERSION);
+    return true;
+}
+
+void NativeFbxWriter::flushIfFull() {
+    if (data.size() >= FLUSH_SIZE)
+        flush();
+}
+
+void NativeFbxWriter::flush() {
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    flushed += data.size();
+    data.clear();
+}
+
+void NativeFbxWriter::beginNode(std::string_view name) {
+    flushIfFull();
+
+    if (!openNodes.empty() && !openNodes.back().hasChildren) {
+        finishProperties(openNodes.back());
+        openNodes.back().hasChildren = true;
+    }
+
+    OpenNode node {
+        .start = size(),
+        .propertiesStart = 0,
+        .properties = 0,
+        .hasChildren = false,
+        // The SDK always terminates these, even without children.
+        .alwaysTerminated = name == "AnimationStack" || name == "AnimationLayer"
+    };
+
+    // End offset, property count and property list length are patched in later.
+    write(uint32_t(0));
+    write(uint32_t(0));
+    write(uint32_t(0));
+    write(static_cast<uint8_t>(name.size()));
+    data.insert(data.end(), name.begin(), name.end());
+
+    node.propertiesStart = size();
+    openNodes.push_back(node);
+}
+
+void NativeFbxWriter::endNode() {
+    auto& node = openNodes.back();
+    if (!node.hasChildren)
+        finishProperties(node);
+
+    if (node.hasChildren || node.properties == 0 || node.alwaysTerminated)
+        data.resize(data.size() + NULL_RECORD_LENGTH, 0);
+
+    patch(node.start, static_cast<uint32_t>(size()));
+    openNodes.pop_back();
+}
+
+void NativeFbxWriter::finishProperties(OpenNode& node) {
+    patch(node.start + 4, node.properties);
+    patch(node.start + 8, static_cast<uint32_t>(size() - node.propertiesStart));
+}
+
+void NativeFbxWriter::beginProperty(char type) {
+    openNodes.back().properties++;
+    data.push_back(static_cast<unsigned char>(type));
+}
+
+void NativeFbxWriter::addBool(bool value) {
+    beginProperty('C');
+    write(static_cast<uint8_t>(value ? 1 : 0));
+}
+
+void NativeFbxWriter::addInt(int32_t value) {
+    beginProperty('I');
+    write(value);
+}
+
+void NativeFbxWriter::addLong(int64_t value) {
+    beginProperty('L');
+    write(value);
+}
+
+void NativeFbxWriter::addDouble(double value) {
+    beginProperty('D');
+    write(value);
+}
+
+void NativeFbxWriter::addString(std::string_view value) {
+    beginProperty('S');
+    write(static_cast<uint32_t>(value.size()));
+    data.insert(data.end(), value.begin(), value.end());
+}
+
+void NativeFbxWriter::addRaw(std::span<const unsigned char> value) {
+    beginProperty('R');
+    write(static_cast<uint32_t>(value.size()));
+    data.insert(data.end(), value.begin(), value.end());
+}
+
+void NativeFbxWriter::addArray(std::span<const int32_t> values) {
+    writeArray('i', values.data(), values.size(), sizeof(int32_t));
+}
+
+void NativeFbxWriter::addArray(std::span<const int64_t> values) {
+    writeArray('l', values.data(), values.size(), sizeof(int64_t));
+}
+
+void NativeFbxWriter::addArray(std::span<const float> values) {
+    writeArray('f', values.data(), values.size(), sizeof(float));
+}
+
+void NativeFbxWriter::addArray(std::span<const double> values) {
+    writeArray('d', values.data(), values.size(), sizeof(double));
+}
+
+void NativeFbxWriter::writeArray(char type, const void* values, size_t count, size_t elementSize) {
+    beginProperty(type);
+
+    auto bytes = static_cast<const unsigned char*>(values);
+    auto byteLength = count * elementSize;
+
+    write(static_cast<uint32_t>(count));
+
+    if (byteLength >= COMPRESSION_THRESHOLD) {
+        auto compressedLength = compressBound(static_cast<uLong>(byteLength));
+        compressed.resize(compressedLength);
+
+        // Favour speed, the arrays are mostly float data that compresses poorly anyway.
+        if (compress2(compressed.data(), &compressedLength, bytes, static_cast<uLong>(byteLength), Z_BEST_SPEED) == Z_OK) {
+            write(uint32_t(1));
+            write(static_cast<uint32_t>(compressedLength));
+            data.insert(data.end(), compressed.begin(), compressed.begin() + compressedLength);
+            flushIfFull();
+            return;
+        }
+    }
+
+    write(uint32_t(0));
+    write(static_cast<uint32_t>(byteLength));
+    data.insert(data.end(), bytes, bytes + byteLength);
+    flushIfFull();
+}
+
+bool NativeFbxWriter::close() {
+    if (!openNodes.empty()) {
+        Log::error() << "Error: fbx node " << openNodes.size() << " levels deep was not closed.";
+        return false;
+    }
+
+    data.resize(data.size() + NULL_RECORD_LENGTH, 0);
+
+    data.insert(data.end(), FOOTER_ID.begin(), FOOTER_ID.end());
+    data.resize(data.size() + 4, 0);
+
+    // Pads to 16 bytes, a full 16 if already aligned.
+    auto padding = 16 - size() % 16;
+    data.resize(data.size() + padding, 0);
+
+    write(VERSION);
+    data.resize(data.size() + 120, 0);
+    data.insert(data.end(), FOOTER_MAGIC.begin(), FOOTER_MAGIC.end());
+
+    // Node end offsets are 32 bits in 7.4, past 4 GiB they have already wrapped.
+    if (size() > std::numeric_limits<uint32_t>::max()) {
+        Log::error() << "Error: " << path.string() << " would be " << size() << " bytes, more than fbx 7.4 can address.";
+        file.close();
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        return false;
+    }
+
+    flush();
+    file.close();
+    if (!file) {
+        Log::error() << "Error: failed to write " << path.string() << ".";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Writes the binary FBX 7.4 node format in a single forward pass, without the FBX SDK. Records are
+// streamed to the file through a small buffer, the lengths of nodes already flushed are patched in place.
+// Properties of a node must be added before its first child. Numeric arrays are zlib compressed.
+class NativeFbxWriter {
+    public:
+        // Creates the file and writes the header.
+        bool open(const std::filesystem::path& path);
+
+        void beginNode(std::string_view name);
+        void endNode();
+
+        void addBool(bool value);
+        void addInt(int32_t value);
+        void addLong(int64_t value);
+        void addDouble(double value);
+        void addString(std::string_view value);
+        void addRaw(std::span<const unsigned char> value);
+        void addArray(std::span<const int32_t> values);
+        void addArray(std::span<const int64_t> values);
+        void addArray(std::span<const float> values);
+        void addArray(std::span<const double> values);
+
+        void add(bool value) { addBool(value); }
+        void add(int32_t value) { addInt(value); }
+        void add(int64_t value) { addLong(value); }
+        void add(double value) { addDouble(value); }
+        void add(const char* value) { addString(value); }
+        void add(const std::string& value) { addString(value); }
+        void add(std::string_view value) { addString(value); }
+
+        // Writes a node without children holding the given properties.
+        template <typename... Properties>
+        void node(std::string_view name, const Properties&... properties) {
+            beginNode(name);
+            (add(properties), ...);
+            endNode();
+        }
+
+        // Finishes the top level node list and writes the footer, the writer cannot be used afterwards.
+        bool close();
+        // Bytes written so far, including those still buffered.
+        size_t size() const { return flushed + data.size(); }
+
+        // FileId and CreationTime values the SDK accepts together with the footer written by save().
+        static constexpr std::array<unsigned char, 16> FILE_ID {
+            0x28, 0xb3, 0x2a, 0xeb, 0xb6, 0x24, 0xcc, 0xc2, 0xbf, 0xc8, 0xb0, 0x2a, 0xa9, 0x2b, 0xfc, 0xf1
+        };
+        static constexpr std::string_view CREATION_TIME = "1970-01-01 10:00:00:000";
+
+        // Arrays smaller than this are stored uncompressed, like the SDK does.
+        static constexpr size_t COMPRESSION_THRESHOLD = 128;
+
+    private:
+        struct OpenNode {
+            size_t start;
+            size_t propertiesStart;
+            uint32_t properties;
+            bool hasChildren;
+            bool alwaysTerminated;
+        };
+
+        void finishProperties(OpenNode& node);
+        // Writes the buffer out once it is full. Only called between records, so a patched header never
+        // straddles the flushed and the buffered part.
+        void flushIfFull();
+        void flush();
+        void beginProperty(char type);
+        void writeArray(char type, const void* values, size_t count, size_t elementSize);
+
+        template <typename T>
+        void write(T value) {
+            auto bytes = reinterpret_cast<const unsigned char*>(&value);
+            data.insert(data.end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        void patch(size_t offset, T value) {
+            auto bytes = reinterpret_cast<const unsigned char*>(&value);
+            if (offset >= flushed) {
+                std::copy(bytes, bytes + sizeof(T), data.begin() + (offset - flushed));
+                return;
+            }
+
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+            file.seekp(0, std::ios::end);
+        }
+
+        std::ofstream file;
+        std::filesystem::path path;
+        // Bytes written to the file, data holds the ones after them.
+        size_t flushed = 0;
+        std::vector<unsigned char> data;
+        std::vector<OpenNode> openNodes;
+        std::vector<unsigned char> compressed;
+};
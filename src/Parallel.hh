@@ -0,0 +1,36 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Runs task(index) for every index in [0, count) on up to `threads` worker threads.
+// A thread count of 0 uses one thread per hardware thread.
+template <typename Task>
+void parallelFor(size_t count, size_t threads, Task&& task) {
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, count);
+
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; i++)
+            task(i);
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (auto i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+                task(i);
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+}
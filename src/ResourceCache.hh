@@ -0,0 +1,336 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "Log.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ResourceCacheDetail {
+    // Caches and keys of the loads running on the current thread, innermost last.
+    inline thread_local std::vector<std::pair<const void*, std::string>> loadStack;
+
+    // Shared by all caches so entries of different kinds can be ordered by recency.
+    inline std::atomic<uint64_t> useClock = 0;
+
+    // Wait-for graph of the loads in flight across all caches: the thread filling each slot and the slot each
+    // thread is waiting for.
+    struct WaitGraph {
+        std::mutex mutex;
+        std::unordered_map<const void*, std::thread::id> owners;
+        std::unordered_map<std::thread::id, const void*> waits;
+    };
+
+    inline WaitGraph waitGraph;
+
+    inline void setOwner(const void* slot) {
+        std::lock_guard lock(waitGraph.mutex);
+        waitGraph.owners[slot] = std::this_thread::get_id();
+    }
+
+    inline void clearOwner(const void* slot) {
+        std::lock_guard lock(waitGraph.mutex);
+        waitGraph.owners.erase(slot);
+    }
+
+    // Registers the current thread as waiting for the slot, unless following the owners and what they wait
+    // for leads back to the current thread. Waiting would deadlock then and false is returned.
+    inline bool beginWait(const void* slot) {
+        auto self = std::this_thread::get_id();
+        std::lock_guard lock(waitGraph.mutex);
+
+        for (auto current = slot;;) {
+            auto owner = waitGraph.owners.find(current);
+            if (owner == waitGraph.owners.end())
+                break;
+            if (owner->second == self)
+                return false;
+
+            auto wait = waitGraph.waits.find(owner->second);
+            if (wait == waitGraph.waits.end())
+                break;
+            current = wait->second;
+        }
+
+        waitGraph.waits[self] = slot;
+        return true;
+    }
+
+    inline void endWait() {
+        std::lock_guard lock(waitGraph.mutex);
+        waitGraph.waits.erase(std::this_thread::get_id());
+    }
+}
+
+struct CacheStatistics {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    CacheStatistics& operator+=(const CacheStatistics& other);
+};
+
+void to_json(json& j, const CacheStatistics& p);
+
+// Type independent interface used to evict the least recently used entries across several caches.
+class EvictableCache {
+    public:
+        struct Candidate {
+            EvictableCache* cache;
+            std::string key;
+            uint64_t lastUse;
+            size_t bytes;
+        };
+
+        virtual ~EvictableCache() = default;
+
+        // Adds every finished entry that is not referenced outside the cache.
+        virtual void collectCandidates(std::vector<Candidate>& candidates) = 0;
+        // Evicts the candidate unless it was used or referenced since it was collected.
+        virtual bool evict(const Candidate& candidate) = 0;
+        virtual size_t getBytes() const = 0;
+        virtual CacheStatistics getStatistics() const = 0;
+};
+
+// Thread-safe cache of parsed resources, sharded by key. Concurrent requests for the same key
+// share a single load, also when one load requests a key another thread is loading. Only when that wait
+// would deadlock on a cycle of loads does the request parse its own copy. A load that recursively requests
+// its own key fails instead of deadlocking.
+template <typename T>
+class ResourceCache : public EvictableCache {
+    public:
+        struct Entry {
+            T value;
+            // Files the value was loaded from, including those of inherited resources.
+            std::vector<std::string> sources;
+            // Estimated memory held by the value.
+            size_t bytes = 0;
+        };
+
+        using EntryPtr = std::shared_ptr<const Entry>;
+
+        explicit ResourceCache(const char* kind) : kind(kind) {}
+
+        // Returns the cached entry or runs load(), which returns nullptr on failure. Failures are not cached.
+        template <typename Load>
+        EntryPtr get(const std::string& key, Load&& load) {
+            auto& shard = shardFor(key);
+            std::promise<EntryPtr> promise;
+            std::shared_ptr<Slot> slot;
+            auto owner = false;
+
+            {
+                std::lock_guard lock(shard.mutex);
+                if (auto it = shard.entries.find(key); it != shard.entries.end()) {
+                    slot = it->second;
+                } else {
+                    slot = std::make_shared<Slot>(promise.get_future().share());
+                    shard.entries.emplace(key, slot);
+                    ResourceCacheDetail::setOwner(slot.get());
+                    owner = true;
+                }
+            }
+
+            slot->lastUse = ResourceCacheDetail::useClock.fetch_add(1);
+            const auto& future = slot->future;
+
+            if (!owner) {
+                if (isReady(future)) {
+                    hits++;
+                    return future.get();
+                }
+
+                if (isLoadingOnThisThread(key)) {
+                    Log::error() << "Error: " << kind << " " << key << " references itself.";
+                    return nullptr;
+                }
+
+                // The loads on other threads form a cycle back to this one, waiting would never end.
+                // Only then does this thread parse its own copy.
+                if (!ResourceCacheDetail::beginWait(slot.get())) {
+                    misses++;
+                    return runLoad(key, load);
+                }
+
+                hits++;
+                try {
+                    auto entry = future.get();
+                    ResourceCacheDetail::endWait();
+                    return entry;
+                } catch (...) {
+                    ResourceCacheDetail::endWait();
+                    throw;
+                }
+            }
+
+            misses++;
+
+            EntryPtr entry;
+            try {
+                entry = runLoad(key, load);
+            } catch (...) {
+                ResourceCacheDetail::clearOwner(slot.get());
+                promise.set_exception(std::current_exception());
+                eraseSlot(shard, key, slot);
+                throw;
+            }
+
+            if (entry != nullptr) {
+                std::lock_guard lock(shard.mutex);
+                // A concurrent clear() may already have dropped the slot, it must not be accounted then.
+                if (auto it = shard.entries.find(key); it != shard.entries.end() && it->second == slot) {
+                    slot->bytes = entry->bytes;
+                    bytes += entry->bytes;
+                }
+            }
+
+            ResourceCacheDetail::clearOwner(slot.get());
+            promise.set_value(entry);
+            if (entry == nullptr)
+                eraseSlot(shard, key, slot);
+
+            return entry;
+        }
+
+        // Removes every finished entry for which predicate(key, entry) is true.
+        template <typename Predicate>
+        void eraseIf(Predicate&& predicate) {
+            for (auto& shard : shards) {
+                std::lock_guard lock(shard.mutex);
+                std::erase_if(shard.entries, [&](const auto& pair) {
+                    if (!isReady(pair.second->future) || !predicate(pair.first, pair.second->future.get()))
+                        return false;
+
+                    bytes -= pair.second->bytes;
+                    return true;
+                });
+            }
+        }
+
+        void clear() {
+            for (auto& shard : shards) {
+                std::lock_guard lock(shard.mutex);
+                for (const auto& pair : shard.entries)
+                    bytes -= pair.second->bytes;
+                shard.entries.clear();
+            }
+        }
+
+        void collectCandidates(std::vector<Candidate>& candidates) override {
+            for (auto& shard : shards) {
+                std::lock_guard lock(shard.mutex);
+                for (const auto& pair : shard.entries) {
+                    if (isEvictable(*pair.second))
+                        candidates.push_back({this, pair.first, pair.second->lastUse, pair.second->bytes});
+                }
+            }
+        }
+
+        bool evict(const Candidate& candidate) override {
+            auto& shard = shardFor(candidate.key);
+            std::lock_guard lock(shard.mutex);
+
+            auto it = shard.entries.find(candidate.key);
+            if (it == shard.entries.end() || it->second->lastUse != candidate.lastUse || !isEvictable(*it->second))
+                return false;
+
+            bytes -= it->second->bytes;
+            shard.entries.erase(it);
+            evictions++;
+            return true;
+        }
+
+        size_t getBytes() const override {
+            return bytes;
+        }
+
+        CacheStatistics getStatistics() const override {
+            CacheStatistics statistics {
+                .hits = hits,
+                .misses = misses,
+                .evictions = evictions,
+                .bytes = bytes
+            };
+
+            for (auto& shard : shards) {
+                std::lock_guard lock(shard.mutex);
+                statistics.entries += shard.entries.size();
+            }
+
+            return statistics;
+        }
+
+    private:
+        static constexpr size_t SHARD_COUNT = 16;
+
+        struct Slot {
+            std::shared_future<EntryPtr> future;
+            std::atomic<uint64_t> lastUse = 0;
+            size_t bytes = 0;
+        };
+
+        struct Shard {
+            mutable std::mutex mutex;
+            std::unordered_map<std::string, std::shared_ptr<Slot>> entries;
+        };
+
+        Shard& shardFor(const std::string& key) {
+            return shards[std::hash<std::string>{}(key) % SHARD_COUNT];
+        }
+
+        static bool isReady(const std::shared_future<EntryPtr>& future) {
+            return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }
+
+        // Only the future itself may hold the entry, anything else means a caller still uses it.
+        static bool isEvictable(const Slot& slot) {
+            return isReady(slot.future) && slot.future.get().use_count() == 1;
+        }
+
+        bool isLoadingOnThisThread(const std::string& key) const {
+            const auto& stack = ResourceCacheDetail::loadStack;
+            return std::find(stack.begin(), stack.end(), std::pair<const void*, std::string>(this, key)) != stack.end();
+        }
+
+        template <typename Load>
+        EntryPtr runLoad(const std::string& key, Load& load) {
+            auto& stack = ResourceCacheDetail::loadStack;
+            stack.emplace_back(this, key);
+            try {
+                auto entry = load();
+                stack.pop_back();
+                return entry;
+            } catch (...) {
+                stack.pop_back();
+                throw;
+            }
+        }
+
+        static void eraseSlot(Shard& shard, const std::string& key, const std::shared_ptr<Slot>& slot) {
+            std::lock_guard lock(shard.mutex);
+            // The entry may already have been replaced after a clear().
+            if (auto it = shard.entries.find(key); it != shard.entries.end() && it->second == slot)
+                shard.entries.erase(it);
+        }
+
+        const char* kind;
+        std::array<Shard, SHARD_COUNT> shards;
+        std::atomic<size_t> bytes = 0;
+        std::atomic<size_t> hits = 0;
+        std::atomic<size_t> misses = 0;
+        std::atomic<size_t> evictions = 0;
+};
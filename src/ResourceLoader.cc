@@ -1,76 +1,492 @@
 #include "ResourceLoader.hh"
+#include "Arena.hh"
 #include "BadgerModel.hh"
+#include "Log.hh"
 
-#include <fstream>
 #include <filesystem>
+#include <fstream>
 #include <vector>
-#include <iostream>
 #include <optional>
+#include <set>
+#include <algorithm>
+
+namespace {
+    // Approximate heap memory held by parsed resources, used for the cache memory budget.
+    size_t estimateBytes(int) { return 0; }
+    size_t estimateBytes(double) { return 0; }
+    // Interned text is shared by every resource, only the pointer counts and that is part of the owner.
+    size_t estimateBytes(const Symbol&) { return 0; }
+    size_t estimateBytes(const std::string& value);
+    size_t estimateBytes(const Badger::BoneLocator& value);
+    size_t estimateBytes(const Badger::Bone& value);
+    size_t estimateBytes(const Badger::Mesh& value);
+    size_t estimateBytes(const Badger::Geometry& value);
+    size_t estimateBytes(const Badger::Model& value);
+    size_t estimateBytes(const Badger::MetaMaterial& value);
+    size_t estimateBytes(const Badger::Entity& value);
+    size_t estimateBytes(const Badger::AnimationProperty& value);
+    size_t estimateBytes(const Badger::AnimationBone& value);
+    size_t estimateBytes(const Badger::Animation& value);
+    size_t estimateBytes(const Badger::Animations& value);
+
+    template <typename T>
+    size_t estimateBytes(const std::vector<T>& values) {
+        auto bytes = values.capacity() * sizeof(T);
+        for (const auto& value : values)
+            bytes += estimateBytes(value);
+        return bytes;
+    }
+
+    template <typename K, typename V>
+    size_t estimateBytes(const std::unordered_map<K, V>& values) {
+        // Every node holds the pair and a next pointer, plus one bucket pointer per bucket.
+        auto bytes = values.size() * (sizeof(std::pair<const K, V>) + sizeof(void*)) + values.bucket_count() * sizeof(void*);
+        for (const auto& value : values)
+            bytes += estimateBytes(value.first) + estimateBytes(value.second);
+        return bytes;
+    }
+
+    size_t estimateBytes(const std::string& value) {
+        return value.capacity() > 15 ? value.capacity() + 1 : 0;
+    }
+
+    size_t estimateBytes(const Badger::BoneLocator& value) {
+        return estimateBytes(value.offset) + estimateBytes(value.rotation);
+    }
+
+    size_t estimateBytes(const Badger::Bone& value) {
+        return estimateBytes(value.info.bindPoseRotation) + estimateBytes(value.locators) + estimateBytes(value.name)
+            + estimateBytes(value.parent) + estimateBytes(value.pivot) + estimateBytes(value.scale);
+    }
+
+    size_t estimateBytes(const Badger::Mesh& value) {
+        return estimateBytes(value.name) + estimateBytes(value.material) + estimateBytes(value.positions)
+            + estimateBytes(value.triangles) + estimateBytes(value.indices) + estimateBytes(value.weights)
+            + estimateBytes(value.colors) + estimateBytes(value.normals) + estimateBytes(value.uvs);
+    }
+
+    size_t estimateBytes(const Badger::Geometry& value) {
+        return estimateBytes(value.bones) + estimateBytes(value.meshes) + estimateBytes(value.description.identifier);
+    }
+
+    size_t estimateBytes(const Badger::Model& value) {
+        return sizeof(value) + estimateBytes(value.formatVersion) + estimateBytes(value.geometry);
+    }
+
+    size_t estimateBytes(const Badger::MetaMaterial& value) {
+        const auto& textures = value.info.textures;
+        return sizeof(value) + estimateBytes(value.formatVersion) + estimateBytes(value.name) + estimateBytes(value.baseName)
+            + estimateBytes(value.info.material) + estimateBytes(value.info.culling) + estimateBytes(textures.diffuse)
+            + estimateBytes(textures.coeff) + estimateBytes(textures.emissive) + estimateBytes(textures.normal);
+    }
+
+    size_t estimateBytes(const Badger::Entity& value) {
+        return sizeof(value) + estimateBytes(value.formatVersion) + estimateBytes(value.info.components.templates);
+    }
+
+    size_t estimateBytes(const Badger::AnimationProperty& value) {
+        return estimateBytes(value.lerpMode) + estimateBytes(value.post);
+    }
+
+    size_t estimateBytes(const Badger::AnimationBone& value) {
+        return estimateBytes(value.rotation) + estimateBytes(value.position) + estimateBytes(value.scale);
+    }
+
+    size_t estimateBytes(const Badger::Animation& value) {
+        return estimateBytes(value.animTimeUpdate) + estimateBytes(value.blendWeight) + estimateBytes(value.bones);
+    }
+
+    size_t estimateBytes(const Badger::Animations& value) {
+        return sizeof(value) + estimateBytes(value.formatVersion) + estimateBytes(value.animations);
+    }
+
+    // A parsed DOM takes a few times the size of its text, so most files fit in the first block.
+    size_t parseArenaSize(const ResourceData& file) {
+        return std::max<size_t>(file.bytes.size() * 4, 4096);
+    }
+
+    std::string modelFile(const std::string& name) {
+        return "models/entity/" + name + ".model.json";
+    }
+
+    std::string materialFile(const std::string& name) {
+        return "materials/meta_materials/" + name + ".json";
+    }
+
+    std::string entityFile(const std::string& name) {
+        return "entity/" + name + ".entity.json";
+    }
+
+    std::string animationsFile(const std::string& name) {
+        return "animations/" + name + ".animations.json";
+    }
+
+    template <typename T>
+    std::shared_ptr<const typename ResourceCache<T>::Entry> makeEntry(T&& value, std::vector<std::string>&& sources) {
+        auto bytes = estimateBytes(value) + estimateBytes(sources);
+        return std::make_shared<const typename ResourceCache<T>::Entry>(std::move(value), std::move(sources), bytes);
+    }
+}
+
+CacheStatistics& CacheStatistics::operator+=(const CacheStatistics& other) {
+    hits += other.hits;
+    misses += other.misses;
+    evictions += other.evictions;
+    entries += other.entries;
+    bytes += other.bytes;
+    return *this;
+}
+
+void to_json(json& j, const CacheStatistics& p) {
+    j = json {
+        {"hits", p.hits},
+        {"misses", p.misses},
+        {"evictions", p.evictions},
+        {"entries", p.entries},
+        {"bytes", p.bytes}
+    };
+}
 
 ResourceLoader::ResourceLoader(const char* resourcePacksDirectory) {
     for (const auto& entry : std::filesystem::directory_iterator(resourcePacksDirectory)) {
-        if (entry.is_directory()) {
-            resourcePacks.push_back(entry);
+        if (!entry.is_directory() && !ResourcePack::isArchive(entry.path()))
+            continue;
+
+        if (auto pack = ResourcePack::open(entry.path()))
+            resourcePacks.push_back(std::move(pack));
+    };
+}
+
+std::vector<std::filesystem::path> ResourceLoader::getResourcePacks() const {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& pack : resourcePacks)
+        paths.push_back(pack->getPath());
+    return paths;
+}
+
+const ResourcePack* ResourceLoader::findArchive(const std::filesystem::path& path, std::string& file) const {
+    for (const auto& pack : resourcePacks) {
+        if (!pack->isArchive())
+            continue;
+
+        auto relative = path.lexically_relative(pack->getPath());
+        if (!relative.empty() && *relative.begin() != ".." && *relative.begin() != ".") {
+            file = relative.generic_string();
+            return pack.get();
         }
+    }
+
+    return nullptr;
+}
+
+bool ResourceLoader::readFile(const std::string& path, ResourceData& data) const {
+    std::string file;
+    if (auto pack = findArchive(path, file))
+        return pack->read(file, data);
+
+    return ResourcePack::readFile(path, data);
+}
+
+std::string ResourceLoader::extractFile(const std::string& path, const std::filesystem::path& directory) const {
+    std::string file;
+    auto pack = findArchive(path, file);
+    if (!pack)
+        return path;
+
+    ResourceData data;
+    if (!pack->read(file, data)) {
+        Log::warning() << "Warning: could not read " << file << " from archive " << pack->getPath() << ", the output refers to a path that does not exist.";
+        return path;
+    }
+
+    // Entry names come from the archive, a name that leaves the directory is not extracted.
+    auto relative = std::filesystem::path(file).lexically_normal();
+    if (relative.empty() || relative == "." || relative.has_root_path() || *relative.begin() == "..") {
+        Log::warning() << "Warning: " << file << " in archive " << pack->getPath() << " points outside the output directory, it is not extracted.";
+        return path;
+    }
+
+    // Textures are shared between models, an extracted copy of the same size is assumed to be current.
+    auto target = directory / relative;
+    std::error_code error;
+    if (std::filesystem::file_size(target, error) == data.bytes.size() && !error)
+        return target.string();
+
+    std::filesystem::create_directories(target.parent_path(), error);
+    std::ofstream output(target, std::ios::out | std::ios::binary);
+    output.write(data.bytes.data(), static_cast<std::streamsize>(data.bytes.size()));
+    output.close();
+    if (!output) {
+        Log::warning() << "Warning: could not extract " << file << " from archive " << pack->getPath() << " to " << target << ", the output refers to a path that does not exist.";
+        return path;
+    }
+
+    Log::verbose() << "Extracted " << file << " from archive " << pack->getPath() << ".";
+    return target.string();
+}
+
+std::shared_ptr<const Badger::Model> ResourceLoader::getModel(const std::string& name) {
+    return share(fetchModel(name));
+}
+
+std::shared_ptr<const Badger::MetaMaterial> ResourceLoader::getMaterial(const std::string& name) {
+    return share(fetchMaterial(name));
+}
+
+std::shared_ptr<const Badger::Entity> ResourceLoader::getEntity(const std::string& name) {
+    return share(fetchEntity(name));
+}
+
+std::shared_ptr<const Badger::Animations> ResourceLoader::getAnimations(const std::string& name) {
+    return share(fetchAnimations(name));
+}
+
+void ResourceLoader::setParseArenas(bool enabled) {
+    parseArenas = enabled;
+}
+
+void ResourceLoader::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+    enforceMemoryBudget();
+}
+
+CacheStatistics ResourceLoader::getCacheStatistics() const {
+    CacheStatistics statistics;
+    for (auto cache : caches())
+        statistics += cache->getStatistics();
+    return statistics;
+}
+
+void ResourceLoader::enforceMemoryBudget() {
+    auto budget = memoryBudget.load();
+    if (budget == 0)
+        return;
+
+    auto used = [&] {
+        size_t bytes = 0;
+        for (auto cache : caches())
+            bytes += cache->getBytes();
+        return bytes;
     };
+
+    if (used() <= budget)
+        return;
+
+    // One thread evicting is enough, the others would only fight over the same candidates.
+    std::unique_lock lock(evictionMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+        return;
+
+    std::vector<EvictableCache::Candidate> candidates;
+    for (auto cache : caches())
+        cache->collectCandidates(candidates);
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a.lastUse < b.lastUse;
+    });
+
+    auto bytes = used();
+    for (const auto& candidate : candidates) {
+        if (bytes <= budget)
+            break;
+        if (candidate.cache->evict(candidate))
+            bytes -= std::min(bytes, candidate.bytes);
+    }
+
+    if (bytes > budget)
+        Log::verbose() << "Resource cache uses " << bytes << " bytes, all remaining entries are in use.";
+}
+
+template <typename Entry>
+std::shared_ptr<const decltype(Entry::value)> ResourceLoader::share(const std::shared_ptr<const Entry>& entry) {
+    if (entry == nullptr)
+        return nullptr;
+
+    // Keeps the whole entry alive, so it cannot be evicted while the caller holds the value.
+    std::shared_ptr<const decltype(Entry::value)> value(entry, &entry->value);
+    enforceMemoryBudget();
+    return value;
+}
+
+ResourceLoader::ModelEntry ResourceLoader::fetchModel(const std::string& name) {
+    return modelCache.get(name, [&] { return loadModel(name); });
+}
+
+ResourceLoader::MaterialEntry ResourceLoader::fetchMaterial(const std::string& name) {
+    return materialCache.get(name, [&] { return loadMaterial(name); });
+}
+
+ResourceLoader::EntityEntry ResourceLoader::fetchEntity(const std::string& name) {
+    return entityCache.get(name, [&] { return loadEntity(name); });
+}
+
+ResourceLoader::AnimationsEntry ResourceLoader::fetchAnimations(const std::string& name) {
+    return animationCache.get(name, [&] { return loadAnimations(name); });
+}
+
+void ResourceLoader::clearCache() {
+    materialCache.clear();
+    modelCache.clear();
+    entityCache.clear();
+    animationCache.clear();
 }
 
-std::optional<const Badger::Model> ResourceLoader::getModel(const std::string& name) {
-    if (const auto& it = modelCache.find(name); it != modelCache.end())
-        return it->second;
+std::string ResourceLoader::normalizePath(const std::filesystem::path& path) {
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(path, error);
+    return (error ? path : canonical).lexically_normal().string();
+}
 
-    return loadModel(name);
+std::vector<std::string> ResourceLoader::lookupSources(const std::string& file, const ResourcePack* last) const {
+    std::vector<std::string> sources;
+    for (const auto& pack : resourcePacks) {
+        sources.push_back(normalizePath(pack->source(file)));
+        if (pack.get() == last)
+            break;
+    }
+    return sources;
 }
 
-std::optional<const Badger::MetaMaterial> ResourceLoader::getMaterial(const std::string& name) {
-    if (const auto& it = materialCache.find(name); it != materialCache.end())
-        return it->second;
+std::vector<std::string> ResourceLoader::getDependencies(const std::string& model) {
+    std::set<std::string> files;
+    // Resources that failed to load depend on every path they were looked up at, so adding them later counts as a change.
+    auto addSources = [&](const auto& entry, const std::string& file) {
+        if (entry) {
+            files.insert(entry->sources.begin(), entry->sources.end());
+        } else {
+            auto candidates = lookupSources(file, nullptr);
+            files.insert(candidates.begin(), candidates.end());
+        }
+    };
+
+    auto modelEntry = fetchModel(model);
+    addSources(modelEntry, modelFile(model));
+
+    if (modelEntry) {
+        for (const auto& geometry : modelEntry->value.geometry) {
+            for (const auto& mesh : geometry.meshes)
+                addSources(fetchMaterial(mesh.material), materialFile(mesh.material));
+        }
+    }
+
+    addSources(fetchEntity(model), entityFile(model));
+    addSources(fetchAnimations(model), animationsFile(model));
 
-    return loadMaterial(name);
+    return {files.begin(), files.end()};
 }
 
-std::optional<const Badger::Entity> ResourceLoader::getEntity(const std::string& name) {
-    if (const auto& it = entityCache.find(name); it != entityCache.end())
-        return it->second;
+void ResourceLoader::invalidate(const std::vector<std::string>& changedFiles) {
+    std::set<std::string> changed(changedFiles.begin(), changedFiles.end());
+
+    for (const auto& pack : resourcePacks) {
+        if (pack->isArchive() && changed.contains(normalizePath(pack->getPath())) && !pack->reload())
+            Log::warning() << "Warning: could not reload archive " << pack->getPath() << ", keeping the previous contents.";
+    }
+
+    auto isAffected = [&](const std::string&, const auto& entry) {
+        return std::any_of(entry->sources.begin(), entry->sources.end(), [&](const std::string& file) {
+            return changed.contains(file);
+        });
+    };
 
-    return loadEntity(name);
+    materialCache.eraseIf(isAffected);
+    modelCache.eraseIf(isAffected);
+    entityCache.eraseIf(isAffected);
+    animationCache.eraseIf(isAffected);
 }
 
-std::optional<const Badger::Animations> ResourceLoader::getAnimations(const std::string& name) {
-    if (const auto& it = animationCache.find(name); it != animationCache.end())
-        return it->second;
+ResourceLoader::Prefetch ResourceLoader::prefetch(const std::string& model) {
+    Prefetch prefetch;
 
-    return loadAnimations(name);
+    prefetch.model = std::async(std::launch::async, [this, model] {
+        return getModel(model) != nullptr;
+    }).share();
+
+    prefetch.materials = std::async(std::launch::async, [this, model, modelLoaded = prefetch.model] {
+        if (!modelLoaded.get())
+            return false;
+
+        auto modelData = getModel(model);
+        if (!modelData)
+            return false;
+
+        std::set<std::string> materials;
+        for (const auto& geometry : modelData->geometry) {
+            for (const auto& mesh : geometry.meshes)
+                materials.insert(mesh.material);
+        }
+
+        std::vector<std::future<bool>> loads;
+        for (const auto& material : materials) {
+            loads.push_back(std::async(std::launch::async, [this, material] {
+                return getMaterial(material) != nullptr;
+            }));
+        }
+
+        auto loaded = true;
+        for (auto& load : loads)
+            loaded &= load.get();
+        return loaded;
+    }).share();
+
+    prefetch.entity = std::async(std::launch::async, [this, model] {
+        return getEntity(model) != nullptr;
+    }).share();
+
+    prefetch.animations = std::async(std::launch::async, [this, model] {
+        return getAnimations(model) != nullptr;
+    }).share();
+
+    return prefetch;
 }
 
-std::optional<const Badger::Model> ResourceLoader::loadModel(const std::string& name) {
-    auto filename = name + ".model.json";
-    for (const auto& packDirectory : resourcePacks) {
-        auto modelPath = packDirectory / "models" / "entity" / filename;
-        if (!std::filesystem::exists(modelPath)) {
+std::vector<std::string> ResourceLoader::listModels() const {
+    const std::string suffix = ".model.json";
+    std::set<std::string> names;
+
+    for (const auto& pack : resourcePacks) {
+        for (const auto& filename : pack->list("models/entity")) {
+            if (filename.ends_with(suffix))
+                names.insert(filename.substr(0, filename.size() - suffix.size()));
+        }
+    }
+
+    return {names.begin(), names.end()};
+}
+
+ResourceLoader::ModelEntry ResourceLoader::loadModel(const std::string& name) {
+    auto modelPath = modelFile(name);
+    for (const auto& pack : resourcePacks) {
+        if (!pack->exists(modelPath)) {
             continue;
         }
 
-        std::ifstream file(modelPath);
-        if (!file) {
-            std::cerr << "Error: could not open model at path " << modelPath << "." << std::endl;
-            return {};
+        ResourceData file;
+        if (!pack->read(modelPath, file)) {
+            Log::error() << "Error: could not open model at path " << pack->locate(modelPath) << ".";
+            return nullptr;
         }
 
+        // Declared before the DOM, so the DOM is gone by the time the arena is released.
+        Arena arena(parseArenaSize(file));
+        ArenaScope scope(parseArenas ? &arena : nullptr);
         try {
-            auto modelJson = json::parse(file);
+            auto modelJson = ArenaJson::parse(file.bytes.begin(), file.bytes.end());
             std::vector<Badger::Geometry> geometry;
+            auto sources = lookupSources(modelPath, pack.get());
 
-            for (auto geoJson : modelJson.at("minecraft:geometry")) {
+            for (const auto& geoJson : modelJson.at("minecraft:geometry")) {
                 Badger::Geometry geo;
                 geoJson.at("description").get_to(geo.description);
                 geoJson.at("meshes").get_to(geo.meshes);
                 if (geoJson.at("bones").is_string()) {
-                    auto inheritedModel = getModel(geoJson.at("bones").get<std::string>().substr(9));
+                    auto inheritedName = geoJson.at("bones").get<std::string>().substr(9);
+                    auto inheritedModel = fetchModel(inheritedName);
                     if (!inheritedModel)
-                        return {};
+                        return nullptr;
 
-                    geo.bones = inheritedModel->geometry[0].bones;
+                    sources.insert(sources.end(), inheritedModel->sources.begin(), inheritedModel->sources.end());
+                    geo.bones = inheritedModel->value.geometry[0].bones;
                 } else {
                     geoJson.at("bones").get_to(geo.bones);
                 }
@@ -81,136 +497,149 @@ std::optional<const Badger::Model> ResourceLoader::loadModel(const std::string&
                 .formatVersion = "1.8.0",
                 .geometry = geometry
             };
-            modelCache.insert({name, model});
-            return model;
-        } catch (json::exception& e) {
-            std::cerr << "Error: failed to parse json (" << e.what() << ")" << std::endl;
-            return {};
+            return makeEntry(std::move(model), std::move(sources));
+        } catch (ArenaJson::exception& e) {
+            Log::error() << "Error: failed to parse json (" << e.what() << ")";
+            return nullptr;
         }
     }
 
-    std::cerr << "Warning: could not find model " << name << " in any resource pack." << std::endl;
-    return {};
+    Log::warning() << "Warning: could not find model " << name << " in any resource pack.";
+    return nullptr;
 }
 
-std::optional<const Badger::MetaMaterial> ResourceLoader::loadMaterial(const std::string& name) {
-    auto filename = name + ".json";
-    for (const auto& packDirectory : resourcePacks) {
-        auto materialPath = packDirectory / "materials" / "meta_materials" / filename;
-        if (!std::filesystem::exists(materialPath)) {
+ResourceLoader::MaterialEntry ResourceLoader::loadMaterial(const std::string& name) {
+    auto materialPath = materialFile(name);
+    for (const auto& pack : resourcePacks) {
+        if (!pack->exists(materialPath)) {
             continue;
         }
 
-        std::ifstream file(materialPath);
-        if (!file) {
-            std::cerr << "Error: could not open material at path " << materialPath << "." << std::endl;
-            return {};
+        ResourceData file;
+        if (!pack->read(materialPath, file)) {
+            Log::error() << "Error: could not open material at path " << pack->locate(materialPath) << ".";
+            return nullptr;
         }
 
+        Arena arena(parseArenaSize(file));
+        ArenaScope scope(parseArenas ? &arena : nullptr);
         try {
-            auto material = json::parse(file).get<Badger::MetaMaterial>();
+            auto material = ArenaJson::parse(file.bytes.begin(), file.bytes.end()).get<Badger::MetaMaterial>();
             
-            auto texturePackDirectory = packDirectory;
-            if (!std::filesystem::exists(texturePackDirectory / material.info.textures.diffuse)) {
+            // Textures in archives are only recorded as a dependency on the archive, their paths are read with readFile.
+            auto sources = lookupSources(materialPath, pack.get());
+
+            const ResourcePack* texturePack = pack.get();
+            if (!material.info.textures.diffuse.empty() && !texturePack->exists(material.info.textures.diffuse)) {
                 auto texturesFound = false;
-                for (const auto& textureDirectory : resourcePacks) {
-                    if (std::filesystem::exists(textureDirectory / (material.info.textures.diffuse + ".png"))) {
+                for (const auto& candidate : resourcePacks) {
+                    if (candidate->exists(material.info.textures.diffuse + ".png")) {
                         texturesFound = true;
-                        texturePackDirectory = textureDirectory;
+                        texturePack = candidate.get();
                         break;
                     }
                 }
 
                 if (!texturesFound) {
-                    std::cerr << "Warning: failed to find texture " << material.info.textures.diffuse << " in any resource pack." << std::endl;
-                    return {};
+                    Log::warning() << "Warning: failed to find texture " << material.info.textures.diffuse << " in any resource pack.";
+                    return nullptr;
                 }
+
+                auto textureSources = lookupSources(material.info.textures.diffuse + ".png", texturePack);
+                sources.insert(sources.end(), textureSources.begin(), textureSources.end() - 1);
             }
 
-            if (!material.info.textures.diffuse.empty())
-                material.info.textures.diffuse = (texturePackDirectory / material.info.textures.diffuse).string();
-            if (!material.info.textures.coeff.empty())
-                material.info.textures.coeff = (texturePackDirectory / material.info.textures.coeff).string();          
-            if (!material.info.textures.emissive.empty())
-                material.info.textures.emissive = (texturePackDirectory / material.info.textures.emissive).string();
-            if (!material.info.textures.normal.empty())
-                material.info.textures.normal = (texturePackDirectory / material.info.textures.normal).string();
+            auto locateTexture = [&](std::string& texture, const char* extension) {
+                if (texture.empty())
+                    return;
+
+                sources.push_back(normalizePath(texturePack->source(texture + extension)));
+                texture = texturePack->locate(texture).string();
+            };
+
+            locateTexture(material.info.textures.diffuse, ".png");
+            locateTexture(material.info.textures.coeff, ".png");
+            locateTexture(material.info.textures.emissive, ".hdr");
+            locateTexture(material.info.textures.normal, ".png");
 
             // TODO: Add base material importing
-            materialCache.insert({name, material});
-            return material;
-        } catch (json::exception& e) {
-            std::cerr << "Error: failed to parse json (" << e.what() << ")" << std::endl;
-            return {};
+            return makeEntry(std::move(material), std::move(sources));
+        } catch (ArenaJson::exception& e) {
+            Log::error() << "Error: failed to parse json (" << e.what() << ")";
+            return nullptr;
         }
     }
 
-    std::cerr << "Warning: could not find material " << name << " in any resource pack." << std::endl;
-    return {};
+    Log::warning() << "Warning: could not find material " << name << " in any resource pack.";
+    return nullptr;
 }
 
-std::optional<const Badger::Entity> ResourceLoader::loadEntity(const std::string& name) {
-    auto filename = name + ".entity.json";
-    for (const auto& packDirectory : resourcePacks) {
-        auto path = packDirectory / "entity" / filename;
-        if (!std::filesystem::exists(path)) {
+ResourceLoader::EntityEntry ResourceLoader::loadEntity(const std::string& name) {
+    auto entityPath = entityFile(name);
+    for (const auto& pack : resourcePacks) {
+        if (!pack->exists(entityPath)) {
             continue;
         }
 
-        std::ifstream file(path);
-        if (!file) {
-            std::cerr << "Error: could not open entity at path " << path << "." << std::endl;
-            return {};
+        ResourceData file;
+        if (!pack->read(entityPath, file)) {
+            Log::error() << "Error: could not open entity at path " << pack->locate(entityPath) << ".";
+            return nullptr;
         }
 
+        Arena arena(parseArenaSize(file));
+        ArenaScope scope(parseArenas ? &arena : nullptr);
         try {
-            auto entity = json::parse(file).get<Badger::Entity>();
+            auto entity = ArenaJson::parse(file.bytes.begin(), file.bytes.end()).get<Badger::Entity>();
+            auto sources = lookupSources(entityPath, pack.get());
             if (!entity.info.components.templates.empty()) {
                 for (const auto& parent : entity.info.components.templates) {
-                    auto parentEntity = getEntity(parent.substr(parent.find(':') + 1));
+                    auto parentName = parent.substr(parent.find(':') + 1);
+                    auto parentEntity = fetchEntity(parentName);
                     if (!parentEntity) {
-                        return {};
+                        return nullptr;
                     }
-                    entity.applyTemplate(parentEntity.value());
+                    entity.applyTemplate(parentEntity->value);
+                    sources.insert(sources.end(), parentEntity->sources.begin(), parentEntity->sources.end());
                 }
             }
 
-            entityCache.insert({name, entity});
-            return entity;
-        } catch (json::exception& e) {
-            std::cerr << "Error: failed to parse json (" << e.what() << ")" << std::endl;
-            return {};
+            return makeEntry(std::move(entity), std::move(sources));
+        } catch (ArenaJson::exception& e) {
+            Log::error() << "Error: failed to parse json (" << e.what() << ")";
+            return nullptr;
         }
     }
 
-    std::cerr << "Warning: could not find entity " << name << " in any resource pack." << std::endl;
-    return {};
+    Log::warning() << "Warning: could not find entity " << name << " in any resource pack.";
+    return nullptr;
 }
 
-std::optional<const Badger::Animations> ResourceLoader::loadAnimations(const std::string& name) {
-    auto filename = name + ".animations.json";
-    for (const auto& packDirectory : resourcePacks) {
-        auto path = packDirectory / "animations" / filename;
-        if (!std::filesystem::exists(path)) {
+ResourceLoader::AnimationsEntry ResourceLoader::loadAnimations(const std::string& name) {
+    auto animationsPath = animationsFile(name);
+    for (const auto& pack : resourcePacks) {
+        if (!pack->exists(animationsPath)) {
             continue;
         }
 
-        std::ifstream file(path);
-        if (!file) {
-            std::cerr << "Error: could not open animations at path " << path << "." << std::endl;
-            return {};
+        ResourceData file;
+        if (!pack->read(animationsPath, file)) {
+            Log::error() << "Error: could not open animations at path " << pack->locate(animationsPath) << ".";
+            return nullptr;
         }
 
+        Arena arena(parseArenaSize(file));
+        ArenaScope scope(parseArenas ? &arena : nullptr);
         try {
-            auto animations = json::parse(file).get<Badger::Animations>();
-            animationCache.insert({name, animations});
-            return animations;
-        } catch (json::exception& e) {
-            std::cerr << "Error: failed to parse json (" << e.what() << ")" << std::endl;
-            return {};
+            auto animations = ArenaJson::parse(file.bytes.begin(), file.bytes.end()).get<Badger::Animations>();
+            auto sources = lookupSources(animationsPath, pack.get());
+            return makeEntry(std::move(animations), std::move(sources));
+        } catch (ArenaJson::exception& e) {
+            Log::error() << "Error: failed to parse json (" << e.what() << ")";
+            return nullptr;
         }
     }
 
-    std::cerr << "Warning: could not find animations for " << name << " in any resource pack." << std::endl;
-    return {};
+    Log::warning() << "Warning: could not find animations for " << name << " in any resource pack.";
+    return nullptr;
 }
\ No newline at end of file
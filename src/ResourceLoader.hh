@@ -1,26 +1,96 @@
+#pragma once
+
 #include "BadgerModel.hh"
+#include "ResourceCache.hh"
+#include "ResourcePack.hh"
 
+#include <array>
+#include <atomic>
 #include <vector>
 #include <filesystem>
-#include <optional>
+#include <future>
+#include <memory>
+#include <mutex>
 
 class ResourceLoader {
     public:
+        // Completes once the respective resources are cached, resolving to false if they could not be loaded.
+        struct Prefetch {
+            std::shared_future<bool> model;
+            std::shared_future<bool> materials;
+            std::shared_future<bool> entity;
+            std::shared_future<bool> animations;
+        };
+
+        // Every directory and .zip or .mcpack archive in the given directory is a resource pack.
         explicit ResourceLoader(const char* resourcePacksDirectory);
-        std::optional<const Badger::Model> getModel(const std::string& name);
-        std::optional<const Badger::MetaMaterial> getMaterial(const std::string& name);
-        std::optional<const Badger::Entity> getEntity(const std::string& name);
-        std::optional<const Badger::Animations> getAnimations(const std::string& name);
+        // Returned resources stay cached, and are never evicted, for as long as the caller holds them.
+        std::shared_ptr<const Badger::Model> getModel(const std::string& name);
+        std::shared_ptr<const Badger::MetaMaterial> getMaterial(const std::string& name);
+        std::shared_ptr<const Badger::Entity> getEntity(const std::string& name);
+        std::shared_ptr<const Badger::Animations> getAnimations(const std::string& name);
+        std::vector<std::string> listModels() const;
+
+        // Loads the model with its inherited bones, its meta-materials, its entity template chain and
+        // its animations on background threads. Materials are requested as soon as the model is parsed.
+        Prefetch prefetch(const std::string& model);
+        std::vector<std::filesystem::path> getResourcePacks() const;
+        // Reads a file such as a texture path of a loaded material, which may point into an archive pack.
+        bool readFile(const std::string& path, ResourceData& data) const;
+        // Returns a path other tools can open for such a file. Files in archive packs are copied to the same
+        // path relative to directory, files on disk are returned unchanged.
+        std::string extractFile(const std::string& path, const std::filesystem::path& directory) const;
+
+        // Every file the model, its meta-materials, textures, entity and animations were loaded from, plus the
+        // paths in higher priority packs that would shadow them and the paths of files that were not found.
+        std::vector<std::string> getDependencies(const std::string& model);
+        // Drops all cached resources that were loaded from one of the given files.
+        void invalidate(const std::vector<std::string>& changedFiles);
+        void clearCache();
+
+        // Evicts the least recently used unreferenced resources once the cache exceeds the budget. 0 disables the limit.
+        void setMemoryBudget(size_t bytes);
+        CacheStatistics getCacheStatistics() const;
+        // Parses each file's JSON into an arena that is released in one step, instead of node by node on the heap.
+        void setParseArenas(bool enabled);
+
+        static std::string normalizePath(const std::filesystem::path& path);
 
     private:
-        std::optional<const Badger::Model> loadModel(const std::string& name);
-        std::optional<const Badger::MetaMaterial> loadMaterial(const std::string& name);
-        std::optional<const Badger::Entity> loadEntity(const std::string& name);
-        std::optional<const Badger::Animations> loadAnimations(const std::string& name);
-
-        std::vector<std::filesystem::path> resourcePacks;
-        std::unordered_map<std::string, Badger::MetaMaterial> materialCache;
-        std::unordered_map<std::string, Badger::Model> modelCache;
-        std::unordered_map<std::string, Badger::Entity> entityCache;
-        std::unordered_map<std::string, Badger::Animations> animationCache;
+        using ModelEntry = ResourceCache<Badger::Model>::EntryPtr;
+        using MaterialEntry = ResourceCache<Badger::MetaMaterial>::EntryPtr;
+        using EntityEntry = ResourceCache<Badger::Entity>::EntryPtr;
+        using AnimationsEntry = ResourceCache<Badger::Animations>::EntryPtr;
+
+        template <typename Entry>
+        std::shared_ptr<const decltype(Entry::value)> share(const std::shared_ptr<const Entry>& entry);
+        void enforceMemoryBudget();
+        std::array<EvictableCache*, 4> caches() const {
+            return { &materialCache, &modelCache, &entityCache, &animationCache };
+        }
+
+        ModelEntry fetchModel(const std::string& name);
+        MaterialEntry fetchMaterial(const std::string& name);
+        EntityEntry fetchEntity(const std::string& name);
+        AnimationsEntry fetchAnimations(const std::string& name);
+
+        ModelEntry loadModel(const std::string& name);
+        MaterialEntry loadMaterial(const std::string& name);
+        EntityEntry loadEntity(const std::string& name);
+        AnimationsEntry loadAnimations(const std::string& name);
+
+        // The archive pack holding path and the path inside it, nullptr if path is not inside an archive pack.
+        const ResourcePack* findArchive(const std::filesystem::path& path, std::string& file) const;
+        // Where file is read from in every pack up to and including last, or in every pack if last is null,
+        // whether it exists there or not. Adding the file to one of the earlier packs changes what is loaded.
+        std::vector<std::string> lookupSources(const std::string& file, const ResourcePack* last) const;
+
+        std::vector<std::unique_ptr<ResourcePack>> resourcePacks;
+        mutable ResourceCache<Badger::MetaMaterial> materialCache { "material" };
+        mutable ResourceCache<Badger::Model> modelCache { "model" };
+        mutable ResourceCache<Badger::Entity> entityCache { "entity" };
+        mutable ResourceCache<Badger::Animations> animationCache { "animations" };
+        std::atomic<size_t> memoryBudget = 0;
+        std::atomic<bool> parseArenas = true;
+        std::mutex evictionMutex;
 };
\ No newline at end of file
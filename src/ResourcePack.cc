@@ -0,0 +1,440 @@
+#include "ResourcePack.hh"
+#include "Log.hh"
+#include "MappedFile.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+#include <zlib.h>
+
+namespace {
+    // Deflate never compresses better than about 1032:1, larger claimed sizes are corrupt.
+    constexpr uint64_t MAX_INFLATE_RATIO = 1032;
+    // Nothing in a resource pack comes close, this bounds what a single entry can allocate.
+    constexpr uint64_t MAX_ENTRY_SIZE = uint64_t(1) << 30;
+
+    uint16_t read16(const unsigned char* p) {
+        return static_cast<uint16_t>(p[0] | p[1] << 8);
+    }
+
+    uint32_t read32(const unsigned char* p) {
+        return static_cast<uint32_t>(read16(p)) | static_cast<uint32_t>(read16(p + 2)) << 16;
+    }
+
+    uint64_t read64(const unsigned char* p) {
+        return static_cast<uint64_t>(read32(p)) | static_cast<uint64_t>(read32(p + 4)) << 32;
+    }
+
+    constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    constexpr uint32_t END_SIGNATURE = 0x06054b50;
+    constexpr uint32_t ZIP64_END_SIGNATURE = 0x06064b50;
+    constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+    constexpr size_t LOCAL_HEADER_SIZE = 30;
+    constexpr size_t CENTRAL_HEADER_SIZE = 46;
+    constexpr size_t END_SIZE = 22;
+    constexpr size_t ZIP64_END_SIZE = 56;
+    constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+    constexpr uint16_t METHOD_STORED = 0;
+    constexpr uint16_t METHOD_DEFLATED = 8;
+
+    // A mapped zip archive with its central directory indexed by entry name.
+    class ZipArchive {
+        public:
+            bool open(const std::filesystem::path& archivePath) {
+                path = archivePath;
+                if (!file.open(path)) {
+                    Log::error() << "Error: could not map archive " << path << ".";
+                    return false;
+                }
+
+                return indexCentralDirectory();
+            }
+
+            bool isStale() const {
+                return file.isStale(path);
+            }
+
+            bool contains(const std::string& name) const {
+                return entries.contains(name);
+            }
+
+            bool read(const std::string& name, ResourceData& data) const {
+                auto it = entries.find(name);
+                if (it == entries.end())
+                    return false;
+
+                const auto& entry = it->second;
+                if (entry.flags & 1) {
+                    Log::error() << "Error: " << name << " in " << path << " is encrypted.";
+                    return false;
+                }
+
+                // The local header repeats the name and may have a different extra field than the central directory.
+                if (file.size < LOCAL_HEADER_SIZE || entry.localHeader > file.size - LOCAL_HEADER_SIZE || read32(file.data + entry.localHeader) != LOCAL_HEADER_SIGNATURE) {
+                    Log::error() << "Error: " << name << " in " << path << " has no valid local header.";
+                    return false;
+                }
+
+                auto header = file.data + entry.localHeader;
+                auto offset = entry.localHeader + LOCAL_HEADER_SIZE + read16(header + 26) + read16(header + 28);
+                if (offset > file.size || entry.compressedSize > file.size - offset) {
+                    Log::error() << "Error: " << name << " in " << path << " extends past the end of the archive.";
+                    return false;
+                }
+
+                auto compressed = file.data + offset;
+                if (entry.method == METHOD_STORED) {
+                    data.storage.clear();
+                    data.bytes = std::string_view(reinterpret_cast<const char*>(compressed), entry.compressedSize);
+                    return true;
+                }
+
+                if (entry.method != METHOD_DEFLATED) {
+                    Log::error() << "Error: " << name << " in " << path << " uses unsupported compression method " << entry.method << ".";
+                    return false;
+                }
+
+                return inflateEntry(name, entry, compressed, data);
+            }
+
+            std::vector<std::string> list(const std::string& directory) const {
+                auto prefix = directory.empty() || directory.ends_with('/') ? directory : directory + "/";
+                std::set<std::string> names;
+                for (const auto& entry : entries) {
+                    const auto& name = entry.first;
+                    if (name.size() > prefix.size() && name.starts_with(prefix) && name.find('/', prefix.size()) == std::string::npos)
+                        names.insert(name.substr(prefix.size()));
+                }
+                return { names.begin(), names.end() };
+            }
+
+        private:
+            struct Entry {
+                uint64_t localHeader;
+                uint64_t compressedSize;
+                uint64_t size;
+                uint32_t crc;
+                uint16_t method;
+                uint16_t flags;
+            };
+
+            bool indexCentralDirectory() {
+                if (file.size < END_SIZE)
+                    return fail("is not a zip archive");
+
+                // The end record is followed by a comment of at most 65535 bytes.
+                auto end = file.size - END_SIZE;
+                auto searchEnd = file.size > END_SIZE + 0xffff ? file.size - END_SIZE - 0xffff : 0;
+                while (read32(file.data + end) != END_SIGNATURE) {
+                    if (end == searchEnd)
+                        return fail("is not a zip archive");
+                    end--;
+                }
+
+                auto record = file.data + end;
+                uint64_t entryCount = read16(record + 10);
+                uint64_t directorySize = read32(record + 12);
+                uint64_t directoryOffset = read32(record + 16);
+
+                if ((entryCount == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff) && end >= ZIP64_LOCATOR_SIZE) {
+                    auto locator = record - ZIP64_LOCATOR_SIZE;
+                    if (read32(locator) == ZIP64_LOCATOR_SIGNATURE) {
+                        auto zip64End = read64(locator + 8);
+                        if (file.size < ZIP64_END_SIZE || zip64End > file.size - ZIP64_END_SIZE || read32(file.data + zip64End) != ZIP64_END_SIGNATURE)
+                            return fail("has a broken zip64 end record");
+
+                        entryCount = read64(file.data + zip64End + 32);
+                        directorySize = read64(file.data + zip64End + 40);
+                        directoryOffset = read64(file.data + zip64End + 48);
+                    }
+                }
+
+                if (directoryOffset > file.size || directorySize > file.size - directoryOffset)
+                    return fail("has a central directory past the end of the file");
+
+                std::vector<std::pair<std::string, Entry>> indexed;
+                indexed.reserve(static_cast<size_t>(std::min<uint64_t>(entryCount, directorySize / CENTRAL_HEADER_SIZE)));
+
+                auto position = file.data + directoryOffset;
+                auto directoryEnd = position + directorySize;
+                for (uint64_t i = 0; i < entryCount; i++) {
+                    if (static_cast<size_t>(directoryEnd - position) < CENTRAL_HEADER_SIZE || read32(position) != CENTRAL_HEADER_SIGNATURE)
+                        return fail("has a broken central directory");
+
+                    auto nameLength = read16(position + 28);
+                    auto extraLength = read16(position + 30);
+                    auto commentLength = read16(position + 32);
+                    if (static_cast<size_t>(directoryEnd - position) < CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength)
+                        return fail("has a broken central directory");
+
+                    Entry entry {
+                        .localHeader = read32(position + 42),
+                        .compressedSize = read32(position + 20),
+                        .size = read32(position + 24),
+                        .crc = read32(position + 16),
+                        .method = read16(position + 10),
+                        .flags = read16(position + 8)
+                    };
+
+                    std::string name(reinterpret_cast<const char*>(position + CENTRAL_HEADER_SIZE), nameLength);
+                    readZip64Extra(position + CENTRAL_HEADER_SIZE + nameLength, extraLength, entry);
+                    position += CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+
+                    // Some Windows tools write backslashes.
+                    std::replace(name.begin(), name.end(), '\\', '/');
+                    if (!name.empty() && !name.ends_with('/'))
+                        indexed.emplace_back(std::move(name), entry);
+                }
+
+                // Packs are often zipped with their folder, in that case the folder holding the manifest is the root.
+                std::string root;
+                size_t rootDepth = SIZE_MAX;
+                for (const auto& [name, entry] : indexed) {
+                    if (name != "manifest.json" && !name.ends_with("/manifest.json"))
+                        continue;
+
+                    auto depth = static_cast<size_t>(std::count(name.begin(), name.end(), '/'));
+                    if (depth < rootDepth) {
+                        rootDepth = depth;
+                        root = name.substr(0, name.size() - std::strlen("manifest.json"));
+                    }
+                }
+
+                entries.reserve(indexed.size());
+                for (auto& [name, entry] : indexed) {
+                    if (name.starts_with(root))
+                        entries.emplace(name.substr(root.size()), entry);
+                }
+
+                Log::verbose() << "Indexed " << entries.size() << " entries of archive " << path << ".";
+                return true;
+            }
+
+            // Sizes and offsets that do not fit in 32 bits are in the zip64 extra field, in this order.
+            static void readZip64Extra(const unsigned char* extra, size_t length, Entry& entry) {
+                while (length >= 4) {
+                    auto id = read16(extra);
+                    auto size = read16(extra + 2);
+                    if (size > length - 4)
+                        return;
+
+                    if (id == 0x0001) {
+                        auto field = extra + 4;
+                        auto fieldEnd = field + size;
+                        for (auto value : { &entry.size, &entry.compressedSize, &entry.localHeader }) {
+                            if (*value != 0xffffffff)
+                                continue;
+                            if (fieldEnd - field < 8)
+                                return;
+                            *value = read64(field);
+                            field += 8;
+                        }
+                        return;
+                    }
+
+                    extra += 4 + size;
+                    length -= 4 + size;
+                }
+            }
+
+            // Inflates in chunks, zlib counts input and output in 32 bits.
+            bool inflateEntry(const std::string& name, const Entry& entry, const unsigned char* compressed, ResourceData& data) const {
+                // The size comes from the central directory, so it is checked before it sizes the storage.
+                if (entry.size > MAX_ENTRY_SIZE || entry.size > data.storage.max_size()) {
+                    Log::error() << "Error: " << name << " in " << path << " is too large.";
+                    return false;
+                }
+
+                if (entry.size / MAX_INFLATE_RATIO > entry.compressedSize) {
+                    Log::error() << "Error: " << name << " in " << path << " claims a size its compressed data cannot hold.";
+                    return false;
+                }
+                data.storage.resize(static_cast<size_t>(entry.size));
+
+                z_stream stream {};
+                if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+                    Log::error() << "Error: failed to initialize inflate.";
+                    return false;
+                }
+
+                auto output = reinterpret_cast<unsigned char*>(data.storage.data());
+                uint64_t remainingIn = entry.compressedSize;
+                uint64_t remainingOut = entry.size;
+                auto result = Z_OK;
+                while (result == Z_OK) {
+                    if (stream.avail_in == 0 && remainingIn > 0) {
+                        stream.next_in = const_cast<unsigned char*>(compressed);
+                        stream.avail_in = static_cast<uInt>(std::min<uint64_t>(remainingIn, UINT_MAX));
+                        compressed += stream.avail_in;
+                        remainingIn -= stream.avail_in;
+                    }
+                    if (stream.avail_out == 0 && remainingOut > 0) {
+                        stream.next_out = output;
+                        stream.avail_out = static_cast<uInt>(std::min<uint64_t>(remainingOut, UINT_MAX));
+                        output += stream.avail_out;
+                        remainingOut -= stream.avail_out;
+                    }
+
+                    // Z_BUF_ERROR means no progress was possible, the entry is truncated or larger than recorded.
+                    result = inflate(&stream, Z_NO_FLUSH);
+                }
+
+                auto finished = result == Z_STREAM_END && stream.avail_out == 0 && remainingOut == 0;
+                inflateEnd(&stream);
+
+                if (!finished) {
+                    Log::error() << "Error: failed to inflate " << name << " in " << path << ".";
+                    return false;
+                }
+
+                if (crc32_z(0, reinterpret_cast<const unsigned char*>(data.storage.data()), data.storage.size()) != entry.crc) {
+                    Log::error() << "Error: " << name << " in " << path << " has a wrong checksum.";
+                    return false;
+                }
+
+                data.bytes = std::string_view(data.storage.data(), data.storage.size());
+                return true;
+            }
+
+            bool fail(const char* reason) const {
+                Log::error() << "Error: " << path << " " << reason << ".";
+                return false;
+            }
+
+            std::filesystem::path path;
+            MappedFile file;
+            std::unordered_map<std::string, Entry> entries;
+    };
+
+    class DirectoryPack : public ResourcePack {
+        public:
+            explicit DirectoryPack(const std::filesystem::path& path) : ResourcePack(path, false) {}
+
+            bool exists(const std::string& file) const override {
+                return std::filesystem::exists(locate(file));
+            }
+
+            bool read(const std::string& file, ResourceData& data) const override {
+                return readFile(locate(file), data);
+            }
+
+            std::vector<std::string> list(const std::string& directory) const override {
+                std::vector<std::string> names;
+                auto fullPath = locate(directory);
+                if (!std::filesystem::is_directory(fullPath))
+                    return names;
+
+                for (const auto& entry : std::filesystem::directory_iterator(fullPath)) {
+                    if (entry.is_regular_file())
+                        names.push_back(entry.path().filename().string());
+                }
+                return names;
+            }
+
+            std::filesystem::path source(const std::string& file) const override {
+                return locate(file);
+            }
+    };
+
+    // The archive is swapped on reload, reads hold on to the one they started with.
+    class ArchivePack : public ResourcePack {
+        public:
+            explicit ArchivePack(const std::filesystem::path& path) : ResourcePack(path, true) {}
+
+            bool exists(const std::string& file) const override {
+                return current()->contains(file);
+            }
+
+            bool read(const std::string& file, ResourceData& data) const override {
+                // An archive rewritten in place is remapped before anything is read from the old mapping.
+                auto zip = current();
+                if (zip->isStale()) {
+                    Log::verbose() << "Archive " << getPath() << " changed on disk, reloading it.";
+                    if (!load()) {
+                        Log::error() << "Error: archive " << getPath() << " changed on disk and could not be reloaded.";
+                        return false;
+                    }
+                    zip = current();
+                }
+
+                if (!zip->read(file, data))
+                    return false;
+
+                data.owner = std::move(zip);
+                return true;
+            }
+
+            std::vector<std::string> list(const std::string& directory) const override {
+                return current()->list(directory);
+            }
+
+            std::filesystem::path source(const std::string&) const override {
+                return getPath();
+            }
+
+            bool reload() override {
+                return load();
+            }
+
+        private:
+            std::shared_ptr<const ZipArchive> current() const {
+                std::lock_guard lock(mutex);
+                return archive;
+            }
+
+            bool load() const {
+                auto zip = std::make_shared<ZipArchive>();
+                if (!zip->open(getPath()))
+                    return false;
+
+                std::lock_guard lock(mutex);
+                archive = std::move(zip);
+                return true;
+            }
+
+            mutable std::mutex mutex;
+            mutable std::shared_ptr<const ZipArchive> archive;
+    };
+}
+
+std::unique_ptr<ResourcePack> ResourcePack::open(const std::filesystem::path& path) {
+    if (std::filesystem::is_directory(path))
+        return std::make_unique<DirectoryPack>(path);
+
+    if (!isArchive(path) || !std::filesystem::is_regular_file(path))
+        return nullptr;
+
+    auto pack = std::make_unique<ArchivePack>(path);
+    if (!pack->reload())
+        return nullptr;
+    return pack;
+}
+
+bool ResourcePack::isArchive(const std::filesystem::path& path) {
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".zip" || extension == ".mcpack";
+}
+
+bool ResourcePack::readFile(const std::filesystem::path& path, ResourceData& data) {
+    std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    data.storage.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(data.storage.data(), static_cast<std::streamsize>(data.storage.size())))
+        return false;
+
+    data.bytes = std::string_view(data.storage.data(), data.storage.size());
+    data.owner = nullptr;
+    return true;
+}
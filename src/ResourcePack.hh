@@ -0,0 +1,52 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Contents of one file read from a pack. Stored archive entries point straight into the mapped archive,
+// which stays mapped for as long as the data is held, everything else is read into storage. Archives have to
+// be replaced by renaming a new file over them: stored entries of an archive that is truncated or rewritten
+// in place while they are held become invalid.
+struct ResourceData {
+    std::string_view bytes;
+    std::vector<char> storage;
+    std::shared_ptr<const void> owner;
+};
+
+// A resource pack, either an unpacked directory or a zip archive such as a .mcpack. Files are named
+// relative to the pack root with forward slashes, e.g. "models/entity/pig.model.json". Thread-safe.
+class ResourcePack {
+    public:
+        // Opens a directory, or an archive with a .zip or .mcpack extension. Returns nullptr if it is neither.
+        static std::unique_ptr<ResourcePack> open(const std::filesystem::path& path);
+        static bool isArchive(const std::filesystem::path& path);
+        // Reads a file from disk into storage.
+        static bool readFile(const std::filesystem::path& path, ResourceData& data);
+
+        virtual ~ResourcePack() = default;
+
+        virtual bool exists(const std::string& file) const = 0;
+        virtual bool read(const std::string& file, ResourceData& data) const = 0;
+        // Names of the files directly inside a directory.
+        virtual std::vector<std::string> list(const std::string& directory) const = 0;
+        // The file on disk that holds the given file, this is the archive itself for archive packs.
+        virtual std::filesystem::path source(const std::string& file) const = 0;
+        // Picks up changes to an archive on disk. Reads also reload an archive that changed since it was mapped,
+        // so they never touch a stale mapping. Data read before stays valid if the archive was replaced by a rename.
+        virtual bool reload() { return true; }
+
+        bool isArchive() const { return archive; }
+        const std::filesystem::path& getPath() const { return path; }
+        // The path of a file as seen from outside the loader, paths into archives are read with ResourceLoader::readFile.
+        std::filesystem::path locate(const std::string& file) const { return path / file; }
+
+    protected:
+        ResourcePack(const std::filesystem::path& path, bool archive) : path(path), archive(archive) {}
+
+    private:
+        std::filesystem::path path;
+        bool archive;
+};
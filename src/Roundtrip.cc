@@ -0,0 +1,413 @@
+#include "Roundtrip.hh"
+#include "BadgerConverter.hh"
+#include "FbxConverter.hh"
+#include "Log.hh"
+#include "Parallel.hh"
+#include "ResourceLoader.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+namespace {
+    constexpr size_t MAX_REPORTED_ISSUES = 20;
+    constexpr auto MISMATCH = std::numeric_limits<double>::infinity();
+
+    double maxDifference(const std::vector<double>& a, const std::vector<double>& b) {
+        if (a.size() != b.size())
+            return MISMATCH;
+
+        auto difference = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+            difference = std::max(difference, std::abs(a[i] - b[i]));
+        return difference;
+    }
+
+    double maxDifference(const std::vector<std::vector<double>>& a, const std::vector<std::vector<double>>& b) {
+        if (a.size() != b.size())
+            return MISMATCH;
+
+        auto difference = 0.0;
+        for (size_t i = 0; i < a.size(); i++)
+            difference = std::max(difference, maxDifference(a[i], b[i]));
+        return difference;
+    }
+
+    // Removes a work directory when it goes out of scope, on every return path.
+    class DirectoryCleanup {
+        public:
+            DirectoryCleanup(const std::filesystem::path& directory, bool enabled) : directory(directory), enabled(enabled) {}
+            ~DirectoryCleanup() {
+                std::error_code error;
+                if (enabled)
+                    std::filesystem::remove_all(directory, error);
+            }
+
+            DirectoryCleanup(const DirectoryCleanup&) = delete;
+            DirectoryCleanup& operator=(const DirectoryCleanup&) = delete;
+
+        private:
+            std::filesystem::path directory;
+            bool enabled;
+    };
+
+    // Collects the mismatches of a single model, keeping only the first few descriptions.
+    class Checker {
+        public:
+            explicit Checker(RoundtripResult& result) : result(result) {}
+
+            void check(double error, double tolerance, double& maxError, const std::string& what) {
+                if (std::isfinite(error))
+                    maxError = std::max(maxError, error);
+
+                if (!(error <= tolerance)) {
+                    std::ostringstream issue;
+                    issue << what << " (error " << error << ")";
+                    fail(issue.str());
+                }
+            }
+
+            void fail(const std::string& issue) {
+                result.mismatchCount++;
+                if (result.issues.size() < MAX_REPORTED_ISSUES)
+                    result.issues.push_back(issue);
+            }
+
+        private:
+            RoundtripResult& result;
+    };
+
+    std::map<std::string, double> vertexInfluences(const Badger::Mesh& mesh, size_t vertex) {
+        std::map<std::string, double> influences;
+        if (vertex >= mesh.indices.size() || vertex >= mesh.weights.size())
+            return influences;
+
+        const auto& bones = mesh.indices[vertex];
+        const auto& weights = mesh.weights[vertex];
+        for (size_t i = 0; i < bones.size() && i < weights.size(); i++)
+            influences[bones[i]] += weights[i];
+        return influences;
+    }
+
+    std::vector<std::pair<double, const Badger::AnimationProperty*>> sortedKeys(const std::unordered_map<double, Badger::AnimationProperty>& keys) {
+        std::vector<std::pair<double, const Badger::AnimationProperty*>> sorted;
+        sorted.reserve(keys.size());
+        for (const auto& key : keys)
+            sorted.emplace_back(key.first, &key.second);
+
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        return sorted;
+    }
+}
+
+void to_json(json& j, const RoundtripResult& p) {
+    auto timingsJson = [](const PhaseTimings& timings) {
+        json phases = json::object();
+        for (const auto& phase : timings.get())
+            phases[phase.first] = phase.second;
+        phases["total"] = timings.total();
+        return phases;
+    };
+
+    j = json {
+        {"model", p.model},
+        {"converted", p.converted},
+        {"matches", p.matches},
+        {"export_ms", timingsJson(p.exportTimings)},
+        {"import_ms", timingsJson(p.importTimings)},
+        {"compare_ms", p.compareMilliseconds},
+        {"max_position_error", p.maxPositionError},
+        {"max_weight_error", p.maxWeightError},
+        {"max_transform_error", p.maxTransformError},
+        {"max_keyframe_error", p.maxKeyframeError},
+        {"mismatches", p.mismatchCount},
+        {"issues", p.issues}
+    };
+}
+
+RoundtripRunner::RoundtripRunner(const char* resourcePacksDir, const std::filesystem::path& workDirectory, const RoundtripTolerances& tolerances) :
+    resourcePacksDir(resourcePacksDir),
+    workDirectory(workDirectory),
+    tolerances(tolerances) {
+
+}
+
+RoundtripResult RoundtripRunner::run(const std::string& model) const {
+    RoundtripResult result;
+    result.model = model;
+    Checker checker(result);
+
+    // BadgerConverter names its output after the fbx file, so the model keeps its name in the round trip.
+    auto modelDirectory = workDirectory / model;
+    auto fbxPath = modelDirectory / (model + ".fbx");
+    auto packsPath = modelDirectory / "packs";
+    DirectoryCleanup cleanup(modelDirectory, !keepOutput);
+
+    try {
+        std::filesystem::remove_all(modelDirectory);
+        std::filesystem::create_directories(packsPath);
+
+        {
+            FbxConverter exporter(resourcePacksDir.c_str());
+            if (!exporter.convertToFbx(model.c_str(), fbxPath.string().c_str())) {
+                checker.fail("export to fbx failed");
+                return result;
+            }
+            result.exportTimings = exporter.getTimings();
+        }
+
+        {
+            BadgerConverter importer;
+            if (!importer.convertToBadger(fbxPath.string().c_str(), (packsPath / model).string().c_str())) {
+                checker.fail("import from fbx failed");
+                return result;
+            }
+            result.importTimings = importer.getTimings();
+        }
+
+        result.converted = true;
+
+        Stopwatch stopwatch;
+        ResourceLoader originalLoader(resourcePacksDir.c_str());
+        ResourceLoader convertedLoader(packsPath.string().c_str());
+
+        auto originalModel = originalLoader.getModel(model);
+        auto convertedModel = convertedLoader.getModel(model);
+        if (!originalModel || !convertedModel) {
+            checker.fail("could not load the original or the converted model");
+        } else {
+            compare(result, *originalModel, *convertedModel);
+
+            std::unordered_set<Symbol> materials;
+            for (const auto& geometry : originalModel->geometry) {
+                for (const auto& mesh : geometry.meshes)
+                    materials.insert(mesh.material);
+            }
+
+            for (const auto& material : materials) {
+                auto originalMaterial = originalLoader.getMaterial(material.str());
+                auto convertedMaterial = convertedLoader.getMaterial(material.str());
+                if (!originalMaterial || !convertedMaterial) {
+                    checker.fail("could not load the original or the converted material " + material.str());
+                } else {
+                    compare(result, *originalMaterial, *convertedMaterial);
+                }
+            }
+        }
+
+        auto originalAnimations = originalLoader.getAnimations(model);
+        if (originalAnimations && !originalAnimations->animations.empty()) {
+            auto convertedAnimations = convertedLoader.getAnimations(model);
+            if (!convertedAnimations) {
+                checker.fail("animations were lost");
+            } else {
+                compare(result, *originalAnimations, *convertedAnimations);
+            }
+        }
+
+        result.compareMilliseconds = stopwatch.elapsedMilliseconds();
+    } catch (const std::exception& e) {
+        checker.fail(std::string("exception: ") + e.what());
+        return result;
+    }
+
+    result.matches = result.mismatchCount == 0;
+    return result;
+}
+
+std::vector<RoundtripResult> RoundtripRunner::runAll(const std::vector<std::string>& models, size_t jobs) const {
+    std::vector<RoundtripResult> results(models.size());
+
+    parallelFor(models.size(), jobs, [&](size_t i) {
+        results[i] = run(models[i]);
+
+        const auto& result = results[i];
+        if (result.matches) {
+            Log::info() << "Round trip of " << result.model << " matches (export " << result.exportTimings.total()
+                << " ms, import " << result.importTimings.total() << " ms).";
+        } else {
+            Log::warning() << "Warning: round trip of " << result.model << " has " << result.mismatchCount << " mismatches.";
+            for (const auto& issue : result.issues)
+                Log::verbose() << "  " << result.model << ": " << issue;
+        }
+    });
+
+    return results;
+}
+
+void RoundtripRunner::compare(RoundtripResult& result, const Badger::Model& original, const Badger::Model& converted) const {
+    Checker checker(result);
+
+    if (original.geometry.size() != 1 || converted.geometry.size() != 1) {
+        checker.fail("expected exactly one geometry");
+        return;
+    }
+
+    const auto& originalGeometry = original.geometry[0];
+    const auto& convertedGeometry = converted.geometry[0];
+
+    std::unordered_map<Symbol, const Badger::Bone*> convertedBones;
+    for (const auto& bone : convertedGeometry.bones)
+        convertedBones.insert({bone.name, &bone});
+
+    for (const auto& bone : originalGeometry.bones) {
+        auto it = convertedBones.find(bone.name);
+        if (it == convertedBones.end()) {
+            checker.fail("bone " + bone.name.str() + " is missing");
+            continue;
+        }
+
+        const auto& other = *it->second;
+        if (bone.parent != other.parent)
+            checker.fail("bone " + bone.name.str() + " changed parent from '" + bone.parent.str() + "' to '" + other.parent.str() + "'");
+
+        checker.check(maxDifference(bone.pivot, other.pivot), tolerances.transform, result.maxTransformError, "bone " + bone.name.str() + " pivot");
+        checker.check(maxDifference(bone.info.bindPoseRotation, other.info.bindPoseRotation), tolerances.transform, result.maxTransformError, "bone " + bone.name.str() + " rotation");
+        checker.check(maxDifference(bone.scale, other.scale), tolerances.transform, result.maxTransformError, "bone " + bone.name.str() + " scale");
+
+        for (const auto& locator : bone.locators) {
+            auto otherLocator = other.locators.find(locator.first);
+            if (otherLocator == other.locators.end()) {
+                checker.fail("locator " + locator.first + " is missing");
+                continue;
+            }
+
+            checker.check(maxDifference(locator.second.offset, otherLocator->second.offset), tolerances.transform, result.maxTransformError, "locator " + locator.first + " offset");
+            checker.check(maxDifference(locator.second.rotation, otherLocator->second.rotation), tolerances.transform, result.maxTransformError, "locator " + locator.first + " rotation");
+            if (locator.second.discardScale != otherLocator->second.discardScale)
+                checker.fail("locator " + locator.first + " discard_scale changed");
+        }
+    }
+
+    if (originalGeometry.meshes.size() != convertedGeometry.meshes.size()) {
+        checker.fail("mesh count changed from " + std::to_string(originalGeometry.meshes.size()) + " to " + std::to_string(convertedGeometry.meshes.size()));
+        return;
+    }
+
+    for (size_t m = 0; m < originalGeometry.meshes.size(); m++) {
+        const auto& mesh = originalGeometry.meshes[m];
+        const auto& other = convertedGeometry.meshes[m];
+        auto meshName = "mesh #" + std::to_string(m);
+
+        if (mesh.material != other.material)
+            checker.fail(meshName + " material changed from " + mesh.material.str() + " to " + other.material.str());
+
+        if (mesh.normals.size() != other.normals.size() || mesh.uvs.size() != other.uvs.size() || mesh.colors.size() != other.colors.size())
+            checker.fail(meshName + " attribute set counts changed");
+
+        if (mesh.triangles.size() != other.triangles.size()) {
+            checker.fail(meshName + " triangle count changed from " + std::to_string(mesh.triangles.size() / 3) + " to " + std::to_string(other.triangles.size() / 3));
+            continue;
+        }
+
+        // Vertices may be welded or reordered, so every triangle corner is resolved to its attributes on both sides.
+        auto positionError = 0.0, normalError = 0.0, uvError = 0.0, colorError = 0.0, weightError = 0.0;
+        auto setsError = [](const auto& sets, const auto& otherSets, size_t vertex, size_t otherVertex) {
+            auto error = 0.0;
+            for (size_t i = 0; i < sets.size() && i < otherSets.size(); i++) {
+                error = std::max(error, vertex < sets[i].size() && otherVertex < otherSets[i].size()
+                    ? maxDifference(sets[i][vertex], otherSets[i][otherVertex]) : MISMATCH);
+            }
+            return error;
+        };
+
+        for (size_t corner = 0; corner < mesh.triangles.size(); corner++) {
+            auto vertex = static_cast<size_t>(mesh.triangles[corner]);
+            auto otherVertex = static_cast<size_t>(other.triangles[corner]);
+            if (vertex >= mesh.positions.size() || otherVertex >= other.positions.size()) {
+                checker.fail(meshName + " corner " + std::to_string(corner) + " has an invalid vertex index");
+                continue;
+            }
+
+            positionError = std::max(positionError, maxDifference(mesh.positions[vertex], other.positions[otherVertex]));
+            normalError = std::max(normalError, setsError(mesh.normals, other.normals, vertex, otherVertex));
+            uvError = std::max(uvError, setsError(mesh.uvs, other.uvs, vertex, otherVertex));
+            colorError = std::max(colorError, setsError(mesh.colors, other.colors, vertex, otherVertex));
+
+            if (mesh.indices.empty())
+                continue;
+
+            auto influences = vertexInfluences(mesh, vertex);
+            auto otherInfluences = vertexInfluences(other, otherVertex);
+            auto error = influences.size() == otherInfluences.size() ? 0.0 : MISMATCH;
+            for (const auto& influence : influences) {
+                auto it = otherInfluences.find(influence.first);
+                error = std::max(error, it == otherInfluences.end() ? MISMATCH : std::abs(influence.second - it->second));
+            }
+            weightError = std::max(weightError, error);
+        }
+
+        checker.check(positionError, tolerances.position, result.maxPositionError, meshName + " positions");
+        checker.check(normalError, tolerances.position, result.maxPositionError, meshName + " normals");
+        checker.check(uvError, tolerances.position, result.maxPositionError, meshName + " uvs");
+        checker.check(colorError, tolerances.position, result.maxPositionError, meshName + " colors");
+        checker.check(weightError, tolerances.weight, result.maxWeightError, meshName + " weights");
+    }
+}
+
+void RoundtripRunner::compare(RoundtripResult& result, const Badger::MetaMaterial& original, const Badger::MetaMaterial& converted) const {
+    Checker checker(result);
+
+    if (original.name != converted.name || original.baseName != converted.baseName)
+        checker.fail("material " + original.name + " was renamed to " + converted.name);
+
+    // Texture paths move into the output pack, only the texture each slot points at has to survive.
+    auto compareTexture = [&](const char* slot, const std::string& texture, const std::string& otherTexture) {
+        if (std::filesystem::path(texture).stem() != std::filesystem::path(otherTexture).stem())
+            checker.fail("material " + original.name + " " + slot + " texture changed from '" + texture + "' to '" + otherTexture + "'");
+    };
+
+    const auto& textures = original.info.textures;
+    const auto& otherTextures = converted.info.textures;
+    compareTexture("diffuse", textures.diffuse, otherTextures.diffuse);
+    compareTexture("normal", textures.normal, otherTextures.normal);
+    compareTexture("coefficient", textures.coeff, otherTextures.coeff);
+    compareTexture("emissive", textures.emissive, otherTextures.emissive);
+}
+
+void RoundtripRunner::compare(RoundtripResult& result, const Badger::Animations& original, const Badger::Animations& converted) const {
+    Checker checker(result);
+
+    auto compareKeys = [&](const std::string& what, const std::unordered_map<double, Badger::AnimationProperty>& keys, const std::unordered_map<double, Badger::AnimationProperty>* otherKeys) {
+        if (keys.empty())
+            return;
+
+        if (otherKeys == nullptr || keys.size() != otherKeys->size()) {
+            checker.fail(what + " keyframe count changed");
+            return;
+        }
+
+        auto sorted = sortedKeys(keys);
+        auto otherSorted = sortedKeys(*otherKeys);
+        for (size_t i = 0; i < sorted.size(); i++) {
+            auto time = sorted[i].first;
+            if (std::abs(time - otherSorted[i].first) > tolerances.time) {
+                checker.fail(what + " key at " + std::to_string(time) + " moved to " + std::to_string(otherSorted[i].first));
+                continue;
+            }
+
+            checker.check(maxDifference(sorted[i].second->post, otherSorted[i].second->post), tolerances.keyframe, result.maxKeyframeError, what + " key at " + std::to_string(time));
+        }
+    };
+
+    for (const auto& animation : original.animations) {
+        auto it = converted.animations.find(animation.first);
+        if (it == converted.animations.end()) {
+            checker.fail("animation " + animation.first + " is missing");
+            continue;
+        }
+
+        for (const auto& bone : animation.second.bones) {
+            auto otherBone = it->second.bones.find(bone.first);
+            auto what = animation.first + " " + bone.first.str();
+            auto found = otherBone != it->second.bones.end();
+
+            compareKeys(what + " position", bone.second.position, found ? &otherBone->second.position : nullptr);
+            compareKeys(what + " rotation", bone.second.rotation, found ? &otherBone->second.rotation : nullptr);
+            compareKeys(what + " scale", bone.second.scale, found ? &otherBone->second.scale : nullptr);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "BadgerModel.hh"
+#include "Stopwatch.hh"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct RoundtripTolerances {
+    double position = 1e-4;
+    double weight = 1e-4;
+    double transform = 1e-3;
+    double keyframe = 1e-3;
+    double time = 1e-4;
+};
+
+struct RoundtripResult {
+    std::string model;
+    bool converted = false;
+    bool matches = false;
+    PhaseTimings exportTimings;
+    PhaseTimings importTimings;
+    double compareMilliseconds = 0;
+    double maxPositionError = 0;
+    double maxWeightError = 0;
+    double maxTransformError = 0;
+    double maxKeyframeError = 0;
+    size_t mismatchCount = 0;
+    std::vector<std::string> issues;
+};
+
+void to_json(json& j, const RoundtripResult& p);
+
+// Exports models with FbxConverter, imports the result again with BadgerConverter
+// and compares geometry, skinning, materials, bones and keyframes against the source.
+class RoundtripRunner {
+    public:
+        RoundtripRunner(const char* resourcePacksDir, const std::filesystem::path& workDirectory, const RoundtripTolerances& tolerances);
+
+        RoundtripResult run(const std::string& model) const;
+        std::vector<RoundtripResult> runAll(const std::vector<std::string>& models, size_t jobs) const;
+
+        bool keepOutput = false;
+
+    private:
+        void compare(RoundtripResult& result, const Badger::Model& original, const Badger::Model& converted) const;
+        void compare(RoundtripResult& result, const Badger::Animations& original, const Badger::Animations& converted) const;
+        void compare(RoundtripResult& result, const Badger::MetaMaterial& original, const Badger::MetaMaterial& converted) const;
+
+        std::string resourcePacksDir;
+        std::filesystem::path workDirectory;
+        RoundtripTolerances tolerances;
+};
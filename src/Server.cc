@@ -0,0 +1,335 @@
+#include "Server.hh"
+#include "Log.hh"
+#include "Stopwatch.hh"
+
+#include <iostream>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#endif
+
+namespace {
+    json timingsToJson(const PhaseTimings& timings, double total) {
+        json phases = json::object();
+        for (const auto& phase : timings.get())
+            phases[phase.first] = phase.second;
+        phases["total"] = total;
+        return phases;
+    }
+
+#ifndef _WIN32
+    // Reads newline separated lines from a socket.
+    class SocketLineReader {
+        public:
+            explicit SocketLineReader(int socket) : socket(socket) {}
+
+            bool next(std::string& line) {
+                while (true) {
+                    if (auto newline = buffer.find('\n'); newline != std::string::npos) {
+                        line = buffer.substr(0, newline);
+                        buffer.erase(0, newline + 1);
+                        return true;
+                    }
+
+                    char chunk[4096];
+                    auto received = recv(socket, chunk, sizeof(chunk), 0);
+                    if (received < 0 && errno == EINTR)
+                        continue;
+
+                    if (received <= 0) {
+                        line.swap(buffer);
+                        buffer.clear();
+                        return !line.empty();
+                    }
+
+                    buffer.append(chunk, received);
+                }
+            }
+
+        private:
+            int socket;
+            std::string buffer;
+    };
+
+#ifdef MSG_NOSIGNAL
+    constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+    constexpr int SEND_FLAGS = 0;
+#endif
+
+    // A peer that went away fails the send with EPIPE instead of raising SIGPIPE.
+    bool sendAll(int socket, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            auto result = send(socket, data.data() + sent, data.size() - sent, SEND_FLAGS);
+            if (result < 0 && errno == EINTR)
+                continue;
+            if (result < 0 && errno == EPIPE)
+                Log::verbose() << "Peer closed the connection before reading the response.";
+            if (result <= 0)
+                return false;
+            sent += result;
+        }
+        return true;
+    }
+
+    bool connectSocket(int socket, const std::string& socketPath, bool listen) {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            Log::error() << "Error: socket path " << socketPath << " is too long.";
+            return false;
+        }
+        std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+        auto socketAddress = reinterpret_cast<sockaddr*>(&address);
+        if (listen) {
+            unlink(socketPath.c_str());
+            if (bind(socket, socketAddress, sizeof(address)) != 0 || ::listen(socket, 8) != 0) {
+                Log::error() << "Error: could not listen on socket " << socketPath << " (" << std::strerror(errno) << ").";
+                return false;
+            }
+        } else if (connect(socket, socketAddress, sizeof(address)) != 0) {
+            Log::error() << "Error: could not connect to socket " << socketPath << " (" << std::strerror(errno) << ").";
+            return false;
+        }
+
+        return true;
+    }
+#endif
+}
+
+ConversionServer::ConversionServer(const char* defaultResourcePacksDir) :
+    defaultResourcePacksDir(defaultResourcePacksDir != nullptr ? defaultResourcePacksDir : ""),
+    stopping(false) {
+
+}
+
+ResourceLoader& ConversionServer::loaderFor(const std::string& resourcePacksDir) {
+    auto& loader = loaders[resourcePacksDir];
+    if (!loader) {
+        loader = std::make_unique<ResourceLoader>(resourcePacksDir.c_str());
+        loader->setMemoryBudget(memoryBudget);
+    }
+
+    return *loader;
+}
+
+FbxConverter& ConversionServer::exporterFor(const std::string& resourcePacksDir) {
+    auto& exporter = exporters[resourcePacksDir];
+    if (!exporter)
+        exporter = std::make_unique<FbxConverter>(loaderFor(resourcePacksDir));
+
+    return *exporter;
+}
+
+GltfExporter& ConversionServer::gltfExporterFor(const std::string& resourcePacksDir) {
+    auto& exporter = gltfExporters[resourcePacksDir];
+    if (!exporter)
+        exporter = std::make_unique<GltfExporter>(loaderFor(resourcePacksDir));
+
+    return *exporter;
+}
+
+json ConversionServer::handle(const json& request) {
+    Stopwatch stopwatch;
+    json response {
+        {"id", request.contains("id") ? request.at("id") : json()},
+        {"status", "ok"}
+    };
+
+    auto fail = [&](const std::string& error) {
+        response["status"] = "error";
+        response["error"] = error;
+        return response;
+    };
+
+    try {
+        auto command = request.at("command").get<std::string>();
+
+        if (command == "export") {
+            auto packs = request.contains("packs") ? request.at("packs").get<std::string>() : defaultResourcePacksDir;
+            if (packs.empty())
+                return fail("no resource packs given and the server has no default");
+
+            auto model = request.at("model").get<std::string>();
+            auto output = request.at("output").get<std::string>();
+
+            bool converted;
+            if (std::filesystem::path(output).extension() == ".glb") {
+                auto& exporter = gltfExporterFor(packs);
+                converted = exporter.convertToGlb(model.c_str(), output.c_str());
+                response["timings"] = timingsToJson(exporter.getTimings(), stopwatch.elapsedMilliseconds());
+            } else {
+                auto& exporter = exporterFor(packs);
+                exporter.nativeWriter = request.value("writer", "sdk") == "native";
+                converted = exporter.convertToFbx(model.c_str(), output.c_str());
+                response["timings"] = timingsToJson(exporter.getTimings(), stopwatch.elapsedMilliseconds());
+            }
+            if (!converted)
+                return fail("failed to convert model " + model);
+        } else if (command == "import") {
+            auto input = request.at("input").get<std::string>();
+            auto output = request.at("output").get<std::string>();
+
+            InfluenceLimits influenceLimits;
+            influenceLimits.maxInfluences = request.value("max_influences", influenceLimits.maxInfluences);
+            influenceLimits.weightSteps = request.value("weight_steps", influenceLimits.weightSteps);
+
+            bool converted;
+            if (auto extension = std::filesystem::path(input).extension(); extension == ".glb" || extension == ".gltf") {
+                if (!gltfImporter)
+                    gltfImporter = std::make_unique<GltfImporter>();
+
+                gltfImporter->influenceLimits = influenceLimits;
+                converted = gltfImporter->convertToBadger(input.c_str(), output.c_str());
+                response["timings"] = timingsToJson(gltfImporter->getTimings(), stopwatch.elapsedMilliseconds());
+            } else {
+                if (!importer)
+                    importer = std::make_unique<BadgerConverter>();
+
+                importer->nativeReader = request.value("reader", "sdk") == "native";
+                importer->influenceLimits = influenceLimits;
+                converted = importer->convertToBadger(input.c_str(), output.c_str());
+                response["timings"] = timingsToJson(importer->getTimings(), stopwatch.elapsedMilliseconds());
+            }
+            if (!converted)
+                return fail("failed to convert " + input);
+        } else if (command == "reload") {
+            for (auto& loader : loaders)
+                loader.second->clearCache();
+        } else if (command == "stats") {
+            json cache = json::object();
+            for (const auto& loader : loaders)
+                cache[loader.first] = loader.second->getCacheStatistics();
+            response["cache"] = cache;
+        } else if (command == "shutdown") {
+            stopping = true;
+        } else if (command != "ping") {
+            return fail("unknown command " + command);
+        }
+    } catch (const json::exception& e) {
+        return fail(std::string("invalid request (") + e.what() + ")");
+    } catch (const std::exception& e) {
+        return fail(e.what());
+    }
+
+    return response;
+}
+
+json ConversionServer::handleLine(const std::string& line) {
+    try {
+        return handle(json::parse(line));
+    } catch (const json::exception& e) {
+        return json {
+            {"id", nullptr},
+            {"status", "error"},
+            {"error", std::string("invalid request (") + e.what() + ")"}
+        };
+    }
+}
+
+int ConversionServer::serveStream(std::istream& input, std::ostream& output) {
+    Log::info() << "Serving conversion requests on stdin.";
+
+    std::string line;
+    while (!stopping && std::getline(input, line)) {
+        if (line.empty())
+            continue;
+
+        output << handleLine(line).dump() << '\n';
+        output.flush();
+        Log::flush();
+    }
+
+    return 0;
+}
+
+int ConversionServer::serveSocket(const std::string& socketPath) {
+#ifdef _WIN32
+    Log::error() << "Error: serving on a socket is not supported on this platform, use stdin instead.";
+    return -1;
+#else
+    // Platforms without MSG_NOSIGNAL would still be killed by a client that disconnects early.
+    signal(SIGPIPE, SIG_IGN);
+
+    auto listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0 || !connectSocket(listener, socketPath, true)) {
+        if (listener >= 0)
+            close(listener);
+        return -1;
+    }
+
+    Log::info() << "Serving conversion requests on " << socketPath << ".";
+
+    while (!stopping) {
+        auto client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR)
+                continue;
+            Log::error() << "Error: failed to accept connection (" << std::strerror(errno) << ").";
+            break;
+        }
+
+        SocketLineReader reader(client);
+        std::string line;
+        while (!stopping && reader.next(line)) {
+            if (line.empty())
+                continue;
+
+            auto response = handleLine(line).dump() + "\n";
+            Log::flush();
+            if (!sendAll(client, response))
+                break;
+        }
+
+        close(client);
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+    return 0;
+#endif
+}
+
+int runClient(const std::string& socketPath) {
+#ifdef _WIN32
+    Log::error() << "Error: the client is not supported on this platform.";
+    return -1;
+#else
+    auto connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0 || !connectSocket(connection, socketPath, false)) {
+        if (connection >= 0)
+            close(connection);
+        return -1;
+    }
+
+    SocketLineReader reader(connection);
+    std::string request;
+    std::string response;
+    auto result = 0;
+
+    while (std::getline(std::cin, request)) {
+        if (request.empty())
+            continue;
+
+        if (!sendAll(connection, request + "\n") || !reader.next(response)) {
+            Log::error() << "Error: lost connection to " << socketPath << ".";
+            result = -1;
+            break;
+        }
+
+        std::cout << response << std::endl;
+    }
+
+    close(connection);
+    return result;
+#endif
+}
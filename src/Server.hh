@@ -0,0 +1,54 @@
+#pragma once
+
+#include "BadgerConverter.hh"
+#include "BadgerModel.hh"
+#include "FbxConverter.hh"
+#include "GltfExporter.hh"
+#include "GltfImporter.hh"
+#include "ResourceLoader.hh"
+
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Handles JSON-lines conversion requests while keeping resource loaders, FBX managers
+// and the shadergraph alive between them.
+//
+// Requests:  {"id": ..., "command": "export", "packs": "<dir>", "model": "<name>", "output": "<file.fbx | file.glb>",
+//                        "writer": "sdk" | "native"}
+//            {"id": ..., "command": "import", "input": "<file.fbx | file.glb | file.gltf>", "output": "<dir>",
+//                        "reader": "sdk" | "native"}
+//            {"id": ..., "command": "stats"}
+//            {"id": ..., "command": "reload" | "ping" | "shutdown"}
+// Responses: {"id": ..., "status": "ok" | "error", "error": "...", "timings": {"<phase>": ms, ..., "total": ms}}
+//            stats adds {"cache": {"<packs>": {"hits", "misses", "evictions", "entries", "bytes"}}}
+class ConversionServer {
+    public:
+        explicit ConversionServer(const char* defaultResourcePacksDir);
+
+        json handle(const json& request);
+        int serveStream(std::istream& input, std::ostream& output);
+        int serveSocket(const std::string& socketPath);
+
+        // Memory budget in bytes for each resource loader's cache, 0 is unlimited.
+        size_t memoryBudget = 0;
+
+    private:
+        json handleLine(const std::string& line);
+        ResourceLoader& loaderFor(const std::string& resourcePacksDir);
+        FbxConverter& exporterFor(const std::string& resourcePacksDir);
+        GltfExporter& gltfExporterFor(const std::string& resourcePacksDir);
+
+        std::string defaultResourcePacksDir;
+        std::unordered_map<std::string, std::unique_ptr<ResourceLoader>> loaders;
+        std::unordered_map<std::string, std::unique_ptr<FbxConverter>> exporters;
+        std::unordered_map<std::string, std::unique_ptr<GltfExporter>> gltfExporters;
+        std::unique_ptr<BadgerConverter> importer;
+        std::unique_ptr<GltfImporter> gltfImporter;
+        bool stopping;
+};
+
+// Forwards JSON-lines requests from stdin to a serving socket and prints the responses.
+int runClient(const std::string& socketPath);
@@ -0,0 +1,35 @@
+#include "Shadergraph.hh"
+#include "Log.hh"
+
+#include <brotli/decode.h>
+
+namespace {
+    const unsigned char DEFAULT_SFX_SHADERGRAPH_COMPRESSED[] = {
+#include "shadergraph.brotli.hex"
+    };
+    const size_t DEFAULT_SFX_SHADERGRAPH_COMPRESSED_LENGTH = sizeof(DEFAULT_SFX_SHADERGRAPH_COMPRESSED);
+    const size_t DEFAULT_SFX_SHADERGRAPH_DECOMPRESSED_LENGTH = 29285;
+}
+
+const std::vector<unsigned char>& decompressedShadergraph() {
+    static const std::vector<unsigned char> shadergraph = [] {
+        size_t decompressedLength = DEFAULT_SFX_SHADERGRAPH_DECOMPRESSED_LENGTH;
+        std::vector<unsigned char> decompressedData(decompressedLength);
+        auto result = BrotliDecoderDecompress(
+            DEFAULT_SFX_SHADERGRAPH_COMPRESSED_LENGTH,
+            DEFAULT_SFX_SHADERGRAPH_COMPRESSED,
+            &decompressedLength,
+            decompressedData.data()
+        );
+
+        if (result != BrotliDecoderResult::BROTLI_DECODER_RESULT_SUCCESS) {
+            Log::error() << "Error: failed to decompress shadergraph binary. Result: " << result;
+            return std::vector<unsigned char>();
+        }
+
+        decompressedData.resize(decompressedLength);
+        return decompressedData;
+    }();
+
+    return shadergraph;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <vector>
+
+// The Stingray PBS shadergraph embedded in every exported material implementation.
+// It is identical for every scene, so it is only decompressed once per process. Empty on failure.
+const std::vector<unsigned char>& decompressedShadergraph();
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+class Stopwatch {
+    public:
+        Stopwatch() : start(std::chrono::steady_clock::now()) {}
+
+        void restart() {
+            start = std::chrono::steady_clock::now();
+        }
+
+        double elapsedMilliseconds() const {
+            return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+    private:
+        std::chrono::steady_clock::time_point start;
+};
+
+// Named durations of the phases of a single conversion, in the order they ran.
+class PhaseTimings {
+    public:
+        void record(const std::string& phase, Stopwatch& stopwatch) {
+            phases.emplace_back(phase, stopwatch.elapsedMilliseconds());
+            stopwatch.restart();
+        }
+
+        void clear() {
+            phases.clear();
+        }
+
+        double total() const {
+            auto sum = 0.0;
+            for (const auto& phase : phases)
+                sum += phase.second;
+            return sum;
+        }
+
+        const std::vector<std::pair<std::string, double>>& get() const {
+            return phases;
+        }
+
+    private:
+        std::vector<std::pair<std::string, double>> phases;
+};
@@ -0,0 +1,50 @@
+#include "Symbol.hh"
+
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+
+namespace {
+    struct TextHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const noexcept { return std::hash<std::string_view>()(text); }
+    };
+
+    // Nodes of an unordered_set never move, so pointers to the strings stay valid. Nothing is ever removed.
+    struct SymbolTable {
+        std::shared_mutex mutex;
+        std::unordered_set<std::string, TextHash, std::equal_to<>> strings;
+    };
+
+    // Never destroyed, so symbols held by other statics stay valid during shutdown.
+    SymbolTable& table() {
+        static auto instance = new SymbolTable();
+        return *instance;
+    }
+
+    const std::string* intern(std::string_view text) {
+        auto& symbols = table();
+        {
+            std::shared_lock lock(symbols.mutex);
+            auto found = symbols.strings.find(text);
+            if (found != symbols.strings.end())
+                return &*found;
+        }
+
+        std::unique_lock lock(symbols.mutex);
+        return &*symbols.strings.emplace(text).first;
+    }
+}
+
+Symbol::Symbol() {
+    static const auto emptyText = intern({});
+    text = emptyText;
+}
+
+Symbol::Symbol(std::string_view text) : text(intern(text)) {}
+
+size_t Symbol::count() {
+    auto& symbols = table();
+    std::shared_lock lock(symbols.mutex);
+    return symbols.strings.size();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// An interned string. Every distinct text is stored once in a global table that lives for the whole
+// process, so symbols are a single pointer, compare and hash by identity, and are safe to share
+// between threads. Converts to the interned std::string wherever a string is expected.
+class Symbol {
+    public:
+        Symbol();
+        Symbol(std::string_view text);
+        Symbol(const std::string& text) : Symbol(std::string_view(text)) {}
+        Symbol(const char* text) : Symbol(std::string_view(text)) {}
+
+        const std::string& str() const { return *text; }
+        const char* c_str() const { return text->c_str(); }
+        bool empty() const { return text->empty(); }
+        size_t size() const { return text->size(); }
+
+        operator const std::string&() const { return *text; }
+        operator std::string_view() const { return *text; }
+
+        bool operator==(const Symbol& other) const { return text == other.text; }
+        bool operator==(const std::string& other) const { return *text == other; }
+        bool operator==(std::string_view other) const { return *text == other; }
+        bool operator==(const char* other) const { return *text == other; }
+        // Ordered by text, so sorted output does not depend on where strings were interned.
+        std::strong_ordering operator<=>(const Symbol& other) const {
+            return text == other.text ? std::strong_ordering::equal : text->compare(*other.text) <=> 0;
+        }
+
+        // Number of distinct strings interned so far.
+        static size_t count();
+
+    private:
+        friend struct std::hash<Symbol>;
+
+        const std::string* text;
+};
+
+template <>
+struct std::hash<Symbol> {
+    size_t operator()(const Symbol& symbol) const noexcept {
+        return std::hash<const void*>()(symbol.text);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& stream, const Symbol& symbol) {
+    return stream << symbol.str();
+}
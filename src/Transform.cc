@@ -0,0 +1,85 @@
+#include "Transform.hh"
+
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2
+#endif
+
+Matrix4 Matrix4::identity() {
+    return { { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 } };
+}
+
+Matrix4 Matrix4::compose(const std::array<double, 3>& translation, const std::array<double, 3>& rotation, const std::array<double, 3>& scale) {
+    auto toRadians = std::numbers::pi / 180.0;
+    auto cx = std::cos(rotation[0] * toRadians), sx = std::sin(rotation[0] * toRadians);
+    auto cy = std::cos(rotation[1] * toRadians), sy = std::sin(rotation[1] * toRadians);
+    auto cz = std::cos(rotation[2] * toRadians), sz = std::sin(rotation[2] * toRadians);
+
+    return { {
+        cy * cz * scale[0], cy * sz * scale[0], -sy * scale[0], 0,
+        (sx * sy * cz - cx * sz) * scale[1], (sx * sy * sz + cx * cz) * scale[1], sx * cy * scale[1], 0,
+        (cx * sy * cz + sx * sz) * scale[2], (cx * sy * sz - sx * cz) * scale[2], cx * cy * scale[2], 0,
+        translation[0], translation[1], translation[2], 1
+    } };
+}
+
+Matrix4 operator*(const Matrix4& a, const Matrix4& b) {
+    Matrix4 result;
+    auto lhs = a.values.data();
+    auto rhs = b.values.data();
+    auto out = result.values.data();
+
+#ifdef TRANSFORM_SSE2
+    // Every result column is a linear combination of a's columns, two rows per register.
+    __m128d columns[8];
+    for (auto i = 0; i < 8; i++)
+        columns[i] = _mm_load_pd(lhs + i * 2);
+
+    for (auto column = 0; column < 4; column++) {
+        auto low = _mm_setzero_pd();
+        auto high = _mm_setzero_pd();
+        for (auto k = 0; k < 4; k++) {
+            auto factor = _mm_set1_pd(rhs[column * 4 + k]);
+            low = _mm_add_pd(low, _mm_mul_pd(columns[k * 2], factor));
+            high = _mm_add_pd(high, _mm_mul_pd(columns[k * 2 + 1], factor));
+        }
+        _mm_store_pd(out + column * 4, low);
+        _mm_store_pd(out + column * 4 + 2, high);
+    }
+#else
+    for (auto column = 0; column < 4; column++) {
+        for (auto row = 0; row < 4; row++) {
+            auto sum = 0.0;
+            for (auto k = 0; k < 4; k++)
+                sum += lhs[k * 4 + row] * rhs[column * 4 + k];
+            out[column * 4 + row] = sum;
+        }
+    }
+#endif
+
+    return result;
+}
+
+size_t TransformTable::add(const Matrix4& local, size_t parent, bool inheritScale) {
+    if (parent == NO_PARENT) {
+        globals.push_back(local);
+    } else if (inheritScale) {
+        globals.push_back(globals[parent] * local);
+    } else {
+        // Normalized axes leave the parent's rotation and translation.
+        auto unscaled = globals[parent];
+        for (auto column = 0; column < 3; column++) {
+            auto axis = unscaled.values.data() + column * 4;
+            auto length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+            if (length > 0) {
+                for (auto row = 0; row < 3; row++)
+                    axis[row] /= length;
+            }
+        }
+        globals.push_back(unscaled * local);
+    }
+    return globals.size() - 1;
+}
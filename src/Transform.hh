@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Column-major 4x4 matrix, translation in the last column, the memory layout of FbxAMatrix.
+struct alignas(16) Matrix4 {
+    std::array<double, 16> values;
+
+    static Matrix4 identity();
+    // Euler angles in degrees, rotated around X first like FBX's default eEulerXYZ order.
+    static Matrix4 compose(const std::array<double, 3>& translation, const std::array<double, 3>& rotation, const std::array<double, 3>& scale);
+};
+
+// Uses SSE2 where available, the result is identical to the scalar version.
+Matrix4 operator*(const Matrix4& a, const Matrix4& b);
+
+// Global transforms of a node hierarchy, evaluated once. Nodes are added parents first, so every global
+// transform is a single multiply with its parent's instead of a walk up the hierarchy.
+class TransformTable {
+    public:
+        static constexpr size_t NO_PARENT = SIZE_MAX;
+
+        // Returns the index of the new node, parent must be an earlier index or NO_PARENT. Without inheritScale the
+        // parent's scale is dropped, like FBX's eInheritRrs.
+        size_t add(const Matrix4& local, size_t parent = NO_PARENT, bool inheritScale = true);
+        const Matrix4& global(size_t node) const { return globals[node]; }
+        size_t size() const { return globals.size(); }
+        void clear() { globals.clear(); }
+
+    private:
+        std::vector<Matrix4> globals;
+};
@@ -0,0 +1,162 @@
+#include "Triangulator.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    struct Point2 {
+        double x;
+        double y;
+    };
+
+    double cross(const Point2& a, const Point2& b, const Point2& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    bool samePoint(const Point2& a, const Point2& b) {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    // Points on the edges count as inside, otherwise an ear could cut through a reflex corner lying on its diagonal.
+    bool insideTriangle(const Point2& p, const Point2& a, const Point2& b, const Point2& c) {
+        if (samePoint(p, a) || samePoint(p, b) || samePoint(p, c))
+            return false;
+
+        return cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0;
+    }
+
+    void addTriangle(Triangulation& result, const int* polygon, size_t firstCorner, int polygonIndex, std::array<size_t, 3> local) {
+        for (auto corner : local) {
+            result.triangles.push_back(polygon[corner]);
+            result.corners.push_back(static_cast<int>(firstCorner + corner));
+        }
+        result.polygons.push_back(polygonIndex);
+    }
+
+    void fan(Triangulation& result, const int* polygon, size_t firstCorner, int polygonIndex, const std::vector<size_t>& remaining) {
+        for (size_t i = 1; i + 1 < remaining.size(); i++)
+            addTriangle(result, polygon, firstCorner, polygonIndex, { remaining[0], remaining[i], remaining[i + 1] });
+    }
+
+    void earClip(Triangulation& result, const int* polygon, size_t size, size_t firstCorner, int polygonIndex, const double* points, size_t stride) {
+        std::vector<size_t> remaining(size);
+        std::iota(remaining.begin(), remaining.end(), 0);
+
+        // Newell's method gives a normal that is stable for slightly non-planar polygons.
+        std::array<double, 3> normal {};
+        for (size_t i = 0; i < size; i++) {
+            auto current = &points[polygon[i] * stride];
+            auto next = &points[polygon[(i + 1) % size] * stride];
+            normal[0] += (current[1] - next[1]) * (current[2] + next[2]);
+            normal[1] += (current[2] - next[2]) * (current[0] + next[0]);
+            normal[2] += (current[0] - next[0]) * (current[1] + next[1]);
+        }
+
+        // Project onto the plane of the largest normal axis, flipped so the polygon winds counter-clockwise.
+        auto axis = std::abs(normal[0]) > std::abs(normal[1]) ? (std::abs(normal[0]) > std::abs(normal[2]) ? 0 : 2) : (std::abs(normal[1]) > std::abs(normal[2]) ? 1 : 2);
+        if (normal[axis] == 0 || !std::isfinite(normal[axis])) {
+            fan(result, polygon, firstCorner, polygonIndex, remaining);
+            return;
+        }
+
+        auto u = (axis + 1) % 3;
+        auto v = (axis + 2) % 3;
+        auto sign = normal[axis] > 0 ? 1.0 : -1.0;
+
+        std::vector<Point2> projected(size);
+        for (size_t i = 0; i < size; i++) {
+            auto point = &points[polygon[i] * stride];
+            projected[i] = { point[u], point[v] * sign };
+        }
+
+        while (remaining.size() > 3) {
+            auto clipped = false;
+            for (size_t i = 0; i < remaining.size(); i++) {
+                auto previous = remaining[(i + remaining.size() - 1) % remaining.size()];
+                auto current = remaining[i];
+                auto next = remaining[(i + 1) % remaining.size()];
+
+                const auto& a = projected[previous];
+                const auto& b = projected[current];
+                const auto& c = projected[next];
+                if (cross(a, b, c) <= 0)
+                    continue;
+
+                auto isEar = true;
+                for (auto other : remaining) {
+                    if (other != previous && other != current && other != next && insideTriangle(projected[other], a, b, c)) {
+                        isEar = false;
+                        break;
+                    }
+                }
+
+                if (!isEar)
+                    continue;
+
+                addTriangle(result, polygon, firstCorner, polygonIndex, { previous, current, next });
+                remaining.erase(remaining.begin() + i);
+                clipped = true;
+                break;
+            }
+
+            // Self-intersecting or degenerate rest, fall back to a fan like the SDK does.
+            if (!clipped)
+                break;
+        }
+
+        fan(result, polygon, firstCorner, polygonIndex, remaining);
+    }
+}
+
+bool triangulatePolygons(std::span<const int> polygonVertices, std::span<const int> polygonSizes,
+    const double* points, size_t pointCount, size_t stride, Triangulation& result) {
+    result.triangles.clear();
+    result.corners.clear();
+    result.polygons.clear();
+    result.splitPolygons = 0;
+
+    for (auto index : polygonVertices) {
+        if (index < 0 || static_cast<size_t>(index) >= pointCount)
+            return false;
+    }
+
+    // Already triangulated meshes are the common case and are passed through unchanged.
+    auto allTriangles = polygonVertices.size() == polygonSizes.size() * 3;
+    for (size_t i = 0; allTriangles && i < polygonSizes.size(); i++)
+        allTriangles = polygonSizes[i] == 3;
+
+    if (allTriangles) {
+        result.triangles.assign(polygonVertices.begin(), polygonVertices.end());
+        result.corners.resize(polygonVertices.size());
+        std::iota(result.corners.begin(), result.corners.end(), 0);
+        result.polygons.resize(polygonSizes.size());
+        std::iota(result.polygons.begin(), result.polygons.end(), 0);
+        return true;
+    }
+
+    result.triangles.reserve(polygonVertices.size() * 2);
+    result.corners.reserve(polygonVertices.size() * 2);
+
+    size_t firstCorner = 0;
+    for (size_t polygon = 0; polygon < polygonSizes.size(); polygon++) {
+        auto size = static_cast<size_t>(std::max(polygonSizes[polygon], 0));
+        if (firstCorner + size > polygonVertices.size())
+            return false;
+
+        auto vertices = &polygonVertices[firstCorner];
+        if (size == 3) {
+            addTriangle(result, vertices, firstCorner, static_cast<int>(polygon), { 0, 1, 2 });
+        } else {
+            // Points and lines have no area and are dropped.
+            if (size > 3)
+                earClip(result, vertices, size, firstCorner, static_cast<int>(polygon), points, stride);
+            result.splitPolygons++;
+        }
+
+        firstCorner += size;
+    }
+
+    return true;
+}
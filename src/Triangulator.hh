@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// What a layer element's values are stored per, before triangulation.
+enum class ElementMapping { ByControlPoint, ByPolygonVertex, ByPolygon, AllSame };
+
+struct Triangulation {
+    // Control point indices, three per triangle.
+    std::vector<int> triangles;
+    // The polygon vertex each triangle corner came from, to look up by-polygon-vertex elements.
+    std::vector<int> corners;
+    // The polygon each triangle came from, to look up by-polygon elements.
+    std::vector<int> polygons;
+    // Polygons that had to be split or were dropped, 0 when the mesh was already triangulated.
+    size_t splitPolygons = 0;
+};
+
+// Triangulates polygons given as a flat list of control point indices and the size of each polygon.
+// Triangles are kept as they are, larger polygons are ear clipped in the plane of their normal and
+// fanned when that fails. Points are read with the given stride in doubles. Returns false if an
+// index is out of range. Only touches its arguments, so meshes can be triangulated in parallel.
+bool triangulatePolygons(std::span<const int> polygonVertices, std::span<const int> polygonSizes,
+    const double* points, size_t pointCount, size_t stride, Triangulation& result);
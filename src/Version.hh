@@ -0,0 +1,3 @@
+#pragma once
+
+#define FBX_CONVERTER_VERSION "0.3.0"
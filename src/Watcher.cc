@@ -0,0 +1,228 @@
+#include "Watcher.hh"
+#include "Log.hh"
+#include "Stopwatch.hh"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+    // Editors usually save in several steps (truncate, write, rename), so events are
+    // collected until the pack directories have been quiet for this long.
+    constexpr int DEBOUNCE_MILLISECONDS = 30;
+}
+
+AssetWatcher::AssetWatcher(const char* resourcePacksDir, const std::filesystem::path& outputDirectory, const std::vector<std::string>& models) :
+    loader(resourcePacksDir),
+    converter(loader),
+    outputDirectory(outputDirectory),
+    models(models) {
+
+}
+
+bool AssetWatcher::convert(const std::string& model) {
+    auto output = outputDirectory / (model + ".fbx");
+    if (!converter.convertToFbx(model.c_str(), output.string().c_str())) {
+        Log::error() << "Error: failed to convert model " << model << ".";
+        return false;
+    }
+
+    return true;
+}
+
+void AssetWatcher::updateDependencies(const std::string& model) {
+    for (const auto& file : dependencies[model]) {
+        if (auto it = dependents.find(file); it != dependents.end()) {
+            it->second.erase(model);
+            if (it->second.empty())
+                dependents.erase(it);
+        }
+    }
+
+    auto files = loader.getDependencies(model);
+    for (const auto& file : files)
+        dependents[file].insert(model);
+
+    dependencies[model] = files;
+}
+
+std::vector<std::string> AssetWatcher::affectedModels(const std::set<std::string>& changedFiles) const {
+    std::set<std::string> affected;
+    for (const auto& file : changedFiles) {
+        if (auto it = dependents.find(file); it != dependents.end())
+            affected.insert(it->second.begin(), it->second.end());
+    }
+
+    return {affected.begin(), affected.end()};
+}
+
+void AssetWatcher::rebuild(const std::set<std::string>& changedFiles) {
+    auto affected = affectedModels(changedFiles);
+    if (affected.empty()) {
+        Log::verbose() << "Ignoring change to " << changedFiles.size() << " file(s) no model depends on.";
+        return;
+    }
+
+    Stopwatch stopwatch;
+    loader.invalidate({changedFiles.begin(), changedFiles.end()});
+
+    for (const auto& model : affected) {
+        Stopwatch modelStopwatch;
+        if (convert(model))
+            Log::info() << "Reconverted " << model << " in " << modelStopwatch.elapsedMilliseconds() << " ms.";
+        updateDependencies(model);
+    }
+
+    Log::info() << "Rebuilt " << affected.size() << " model(s) in " << stopwatch.elapsedMilliseconds() << " ms.";
+    Log::flush();
+}
+
+void AssetWatcher::rebuildAll() {
+    Stopwatch stopwatch;
+
+    // Passing the packs themselves reloads the archives among them.
+    std::vector<std::string> packs;
+    for (const auto& pack : loader.getResourcePacks())
+        packs.push_back(ResourceLoader::normalizePath(pack));
+    loader.invalidate(packs);
+    loader.clearCache();
+
+    for (const auto& model : models) {
+        convert(model);
+        updateDependencies(model);
+    }
+
+    Log::info() << "Rebuilt all " << models.size() << " model(s) in " << stopwatch.elapsedMilliseconds() << " ms.";
+    Log::flush();
+}
+
+int AssetWatcher::run() {
+    std::filesystem::create_directories(outputDirectory);
+
+    for (const auto& model : models) {
+        convert(model);
+        updateDependencies(model);
+    }
+
+#ifndef __linux__
+    Log::error() << "Error: watch mode is only supported on Linux.";
+    return -1;
+#else
+    auto notifier = inotify_init1(IN_CLOEXEC);
+    if (notifier < 0) {
+        Log::error() << "Error: could not initialize inotify (" << std::strerror(errno) << ").";
+        return -1;
+    }
+
+    const auto mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+    std::unordered_map<int, std::filesystem::path> watches;
+
+    auto addWatch = [&](const std::filesystem::path& directory) {
+        auto watch = inotify_add_watch(notifier, directory.c_str(), mask);
+        if (watch < 0) {
+            Log::warning() << "Warning: could not watch " << directory << " (" << std::strerror(errno) << ").";
+            return;
+        }
+        watches[watch] = directory;
+    };
+
+    auto addWatchRecursive = [&](const std::filesystem::path& directory) {
+        addWatch(directory);
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+            if (entry.is_directory())
+                addWatch(entry.path());
+        }
+    };
+
+    // Archives are replaced as a whole, so the directory holding them is watched instead. Adding a watch
+    // again returns the existing one, so this also picks up directories created since.
+    auto addPackWatches = [&]() {
+        for (const auto& pack : loader.getResourcePacks()) {
+            if (std::filesystem::is_directory(pack))
+                addWatchRecursive(pack);
+            else
+                addWatch(pack.parent_path());
+        }
+    };
+    addPackWatches();
+
+    Log::info() << "Watching " << watches.size() << " directories for changes to " << models.size() << " model(s).";
+    Log::flush();
+
+    alignas(inotify_event) char buffer[64 * 1024];
+    std::set<std::string> changedFiles;
+    // Set when the kernel's event queue overflowed, after which any change may have gone unseen.
+    auto overflowed = false;
+
+    auto readEvents = [&]() -> bool {
+        auto length = read(notifier, buffer, sizeof(buffer));
+        if (length < 0)
+            return errno == EINTR;
+
+        for (auto offset = 0; offset < length;) {
+            auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflowed = true;
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                watches.erase(event->wd);
+                continue;
+            }
+
+            auto directory = watches.find(event->wd);
+            if (directory == watches.end() || event->len == 0)
+                continue;
+
+            auto path = directory->second / event->name;
+            if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                addWatchRecursive(path);
+
+                // Files moved in with the directory, or written before its watch was added, raise no events of their
+                // own. They can be files a model looked for and did not find.
+                std::error_code error;
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(path, error)) {
+                    if (!entry.is_directory())
+                        changedFiles.insert(ResourceLoader::normalizePath(entry.path()));
+                }
+            } else if (!(event->mask & IN_ISDIR)) {
+                changedFiles.insert(ResourceLoader::normalizePath(path));
+            }
+        }
+
+        return true;
+    };
+
+    while (readEvents()) {
+        pollfd pending { .fd = notifier, .events = POLLIN, .revents = 0 };
+        while (poll(&pending, 1, DEBOUNCE_MILLISECONDS) > 0) {
+            if (!readEvents())
+                break;
+        }
+
+        if (overflowed) {
+            Log::warning() << "Warning: too many file changes to track, rebuilding all models.";
+            addPackWatches();
+            rebuildAll();
+            changedFiles.clear();
+            overflowed = false;
+        } else if (!changedFiles.empty()) {
+            rebuild(changedFiles);
+            changedFiles.clear();
+        }
+    }
+
+    Log::error() << "Error: failed to read file change events (" << std::strerror(errno) << ").";
+    close(notifier);
+    return -1;
+#endif
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "FbxConverter.hh"
+#include "ResourceLoader.hh"
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Converts models once, then watches the resource packs and reconverts only the
+// models whose model, inherited bones, entity templates, materials, textures or animations changed.
+class AssetWatcher {
+    public:
+        AssetWatcher(const char* resourcePacksDir, const std::filesystem::path& outputDirectory, const std::vector<std::string>& models);
+
+        int run();
+
+        ResourceLoader& getLoader() { return loader; }
+
+    private:
+        bool convert(const std::string& model);
+        void updateDependencies(const std::string& model);
+        std::vector<std::string> affectedModels(const std::set<std::string>& changedFiles) const;
+        void rebuild(const std::set<std::string>& changedFiles);
+        // Reloads everything and reconverts every model, for when change events were lost.
+        void rebuildAll();
+
+        ResourceLoader loader;
+        FbxConverter converter;
+        std::filesystem::path outputDirectory;
+        std::vector<std::string> models;
+        std::unordered_map<std::string, std::vector<std::string>> dependencies;
+        std::unordered_map<std::string, std::set<std::string>> dependents;
+};
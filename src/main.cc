@@ -1,56 +1,270 @@
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <filesystem>
 #include <fstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 //#define USE_ASSIMP
 
 #include "FbxConverter.hh"
+#include "GltfExporter.hh"
+#include "GltfImporter.hh"
 #include "BadgerConverter.hh"
 #include "AssimpConverter.hh"
+#include "Batch.hh"
+#include "Log.hh"
+#include "ResourceLoader.hh"
+#include "Roundtrip.hh"
+#include "Server.hh"
+#include "Version.hh"
+#include "Watcher.hh"
+
+// Parses the value of a numeric option, the whole value has to be a number in range. Options that are not given keep
+// their current value.
+template<typename T>
+static bool parseOption(const std::unordered_map<std::string, std::string>& options, const std::string& name, T& value) {
+    auto it = options.find(name);
+    if (it == options.end())
+        return true;
+
+    const auto& text = it->second;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        Log::error() << "Error: invalid value '" << text << "' for --" << name << ".";
+        return false;
+    }
+    return true;
+}
+
+static void printUsage(const char* program) {
+    std::cout << "FbxImporter v" FBX_CONVERTER_VERSION " made by LukeFZ" << std::endl;
+    std::cout << "Usage: " << program << " [--quiet | --verbose] <command> <arguments>" << std::endl;
+    std::cout << "Command 'export': <path to resource packs> <model name> <path to output .fbx | .glb> [--native-fbx]" << std::endl;
+    std::cout << "Command 'import': <path to input .fbx | .glb | .gltf> <output folder> [--native-fbx] [--max-influences <n>] [--weight-steps <n>]" << std::endl;
+    std::cout << "Command 'roundtrip': <path to resource packs> [model names...] [--jobs <n>] [--tolerance <value>] [--weight-tolerance <value>] [--work-dir <path>] [--report <path to .json>] [--keep]" << std::endl;
+    std::cout << "Command 'serve': [default path to resource packs] [--socket <path>] [--memory-budget <MB>] - reads JSON-lines requests from stdin or the socket" << std::endl;
+    std::cout << "Command 'client': <socket path> - sends JSON-lines requests from stdin to a serving socket" << std::endl;
+    std::cout << "Command 'watch': <path to resource packs> <output folder> [model names...] [--memory-budget <MB>] - reconverts models when their files change" << std::endl;
+    std::cout << "Command 'batch': <path to resource packs> <output folder> [model names...] [--jobs <n>] [--cache <path to manifest .json>] [--native-fbx] - skips models whose inputs are unchanged" << std::endl;
+}
+
+static int runRoundtrip(const std::vector<char*>& args, const std::unordered_map<std::string, std::string>& options) {
+    RoundtripTolerances tolerances;
+    size_t jobs = 0;
+    if (!parseOption(options, "tolerance", tolerances.position) || !parseOption(options, "weight-tolerance", tolerances.weight)
+        || !parseOption(options, "jobs", jobs)) {
+        printUsage(args[0]);
+        return -1;
+    }
+
+    std::vector<std::string> models(args.begin() + 3, args.end());
+    if (models.empty()) {
+        ResourceLoader loader(args[2]);
+        models = loader.listModels();
+    }
+
+    auto option = [&](const std::string& name, const std::string& fallback) {
+        auto it = options.find(name);
+        return it == options.end() ? fallback : it->second;
+    };
+
+    auto workDirectory = option("work-dir", (std::filesystem::temp_directory_path() / "fbx_converter_roundtrip").string());
+    RoundtripRunner runner(args[2], workDirectory, tolerances);
+    runner.keepOutput = options.contains("keep");
+
+    auto results = runner.runAll(models, jobs);
+
+    size_t matching = 0;
+    for (const auto& result : results) {
+        if (result.matches)
+            matching++;
+    }
+
+    Log::info() << "Round trip finished: " << matching << " of " << results.size() << " models match.";
+
+    if (auto report = option("report", ""); !report.empty()) {
+        std::ofstream reportStream(report, std::ios::out);
+        reportStream << json(results).dump(4);
+    }
+
+    return matching == results.size() ? 0 : -1;
+}
+
+static int runBatch(const std::vector<char*>& args, const std::unordered_map<std::string, std::string>& options) {
+    size_t jobs = 0;
+    if (!parseOption(options, "jobs", jobs)) {
+        printUsage(args[0]);
+        return -1;
+    }
+
+    std::vector<std::string> models(args.begin() + 4, args.end());
+    if (models.empty()) {
+        ResourceLoader loader(args[2]);
+        models = loader.listModels();
+    }
+
+    BatchRunner runner(args[2], args[3]);
+    runner.nativeWriter = options.contains("native-fbx");
+    if (auto it = options.find("cache"); it != options.end())
+        runner.useCache(it->second);
+
+    auto result = runner.run(models, jobs);
+
+    Log::info() << "Batch finished: " << result.converted << " converted, " << result.skipped << " up to date, " << result.failed << " failed.";
+    return result.failed == 0 ? 0 : -1;
+}
 
 int main(int argc, char** argv)
 {
+    const std::vector<std::string> valueOptions = { "cache", "jobs", "max-influences", "memory-budget", "report", "socket", "tolerance", "weight-steps", "weight-tolerance", "work-dir" };
+
+    std::vector<char*> args;
+    std::unordered_map<std::string, std::string> options;
+    for (auto i = 0; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--quiet") {
+            Log::setLevel(Log::Level::Error);
+        } else if (arg == "--verbose") {
+            Log::setLevel(Log::Level::Verbose);
+        } else if (arg == "--keep") {
+            options["keep"] = "";
+        } else if (arg == "--native-fbx") {
+            options["native-fbx"] = "";
+        } else if (arg.starts_with("--") && std::find(valueOptions.begin(), valueOptions.end(), arg.substr(2)) != valueOptions.end() && i + 1 < argc) {
+            options[arg.substr(2)] = argv[++i];
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
     std::string command;
 
-    if (argc > 2) {
-        command = argv[1];
+    if (args.size() > 1) {
+        command = args[1];
     }
 
     auto doExport = command == "export";
     auto doImport = command == "import";
+    auto doRoundtrip = command == "roundtrip";
+    auto doServe = command == "serve";
+    auto doClient = command == "client";
+    auto doWatch = command == "watch";
+    auto doBatch = command == "batch";
 
-    if (!(doExport && argc == 5) && !(doImport && argc == 4)) {
-        std::cout << "FbxImporter v0.3.0 made by LukeFZ" << std::endl;
-        std::cout << "Usage: " << argv[0] << " <command> <arguments>" << std::endl;
-        std::cout << "Command 'export': <path to resource packs> <model name> <path to output .fbx>" << std::endl;
-        std::cout << "Command 'import': <path to input fbx> <output folder>" << std::endl;
+    if (!(doExport && args.size() == 5) && !(doImport && args.size() == 4) && !(doRoundtrip && args.size() > 2)
+        && !(doServe && args.size() <= 3) && !(doClient && args.size() == 3) && !(doWatch && args.size() > 3)
+        && !(doBatch && args.size() > 3)) {
+        printUsage(argv[0]);
         return -1;
     }
 
     if (doExport) {
-        FbxConverter converter(argv[2]);
-        if (!converter.convertToFbx(argv[3], argv[4])) {
-            std::cout << "Failed to convert model." << std::endl;
+        bool converted;
+        if (std::filesystem::path(args[4]).extension() == ".glb") {
+            GltfExporter exporter(args[2]);
+            converted = exporter.convertToGlb(args[3], args[4]);
+        } else {
+            FbxConverter converter(args[2]);
+            converter.nativeWriter = options.contains("native-fbx");
+            converted = converter.convertToFbx(args[3], args[4]);
+        }
+
+        if (!converted) {
+            Log::error() << "Failed to convert model.";
             return -1;
         }
     }
 
     if (doImport) {
-        BadgerConverter converter;
-        if (!converter.convertToBadger(argv[2], argv[3])) {
-            std::cout << "Failed to convert model." << std::endl;
+        InfluenceLimits influenceLimits;
+        if (!parseOption(options, "max-influences", influenceLimits.maxInfluences) || !parseOption(options, "weight-steps", influenceLimits.weightSteps)) {
+            printUsage(argv[0]);
             return -1;
         }
+
+        bool converted;
+        if (auto extension = std::filesystem::path(args[2]).extension(); extension == ".glb" || extension == ".gltf") {
+            GltfImporter importer;
+            importer.influenceLimits = influenceLimits;
+            converted = importer.convertToBadger(args[2], args[3]);
+        } else {
+            BadgerConverter converter;
+            converter.nativeReader = options.contains("native-fbx");
+            converter.influenceLimits = influenceLimits;
+            converted = converter.convertToBadger(args[2], args[3]);
+        }
+
+        if (!converted) {
+            Log::error() << "Failed to convert model.";
+            return -1;
+        }
+    }
+
+    if (doRoundtrip) {
+        auto result = runRoundtrip(args, options);
+        Log::flush();
+        return result;
+    }
+
+    // Given in megabytes, 0 keeps every loaded resource cached.
+    size_t memoryBudget = 0;
+    if (!parseOption(options, "memory-budget", memoryBudget)) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    memoryBudget *= 1024 * 1024;
+
+    if (doServe) {
+        ConversionServer server(args.size() == 3 ? args[2] : nullptr);
+        server.memoryBudget = memoryBudget;
+
+        int result;
+        if (auto it = options.find("socket"); it != options.end()) {
+            result = server.serveSocket(it->second);
+        } else {
+            Log::useStderr(true);
+            result = server.serveStream(std::cin, std::cout);
+        }
+
+        Log::flush();
+        return result;
+    }
+
+    if (doClient) {
+        return runClient(args[2]);
+    }
+
+    if (doBatch) {
+        auto result = runBatch(args, options);
+        Log::flush();
+        return result;
+    }
+
+    if (doWatch) {
+        std::vector<std::string> models(args.begin() + 4, args.end());
+        if (models.empty()) {
+            ResourceLoader loader(args[2]);
+            models = loader.listModels();
+        }
+
+        AssetWatcher watcher(args[2], args[3], models);
+        watcher.getLoader().setMemoryBudget(memoryBudget);
+        return watcher.run();
     }
 
 #ifdef USE_ASSIMP
     AssimpConverter assimpConv;
 
-    if (!assimpConv.convertFbx(argv[3], "output.gltf2", "gltf2")) {
-        std::cout << "Failed to convert model to glTF." << std::endl;
+    if (!assimpConv.convertFbx(args[3], "output.gltf2", "gltf2")) {
+        Log::error() << "Failed to convert model to glTF.";
         return -1;
     }
 #endif
 
+    Log::flush();
+
     return 0;
 }
@@ -1,5 +1,6 @@
 add_requires("nlohmann_json v3.11.2")
 add_requires("brotli 1.0.9")
+add_requires("zlib v1.2.13")
 --add_requires("assimp v5.2.5")
 add_rules("mode.debug", "mode.release")
 
@@ -13,11 +14,29 @@ target("fbx_converter")
     add_linkdirs("M:/Tools/FBXSDK/2020.3.1/lib/vs2019/x64/release")
 
     add_syslinks("advapi32")
-    add_links("libfbxsdk-mt", "libxml2-mt", "zlib-mt")
+    add_links("libfbxsdk-mt", "libxml2-mt")
     add_packages("nlohmann_json")
     add_packages("brotli")
+    add_packages("zlib")
     --add_packages("assimp")
 
+target("fbx_converter_bench")
+    set_kind("binary")
+    set_default(false)
+    add_files("src/*.cc|main.cc", "bench/*.cc")
+    add_includedirs("src")
+    set_languages("c++20")
+    add_cxxflags("/MT")
+
+    add_includedirs("M:/Tools/FBXSDK/2020.3.1/include")
+    add_linkdirs("M:/Tools/FBXSDK/2020.3.1/lib/vs2019/x64/release")
+
+    add_syslinks("advapi32")
+    add_links("libfbxsdk-mt", "libxml2-mt")
+    add_packages("nlohmann_json")
+    add_packages("brotli")
+    add_packages("zlib")
+
 --
 -- If you want to known more usage about xmake, please see https://xmake.io
 --